@@ -13,14 +13,14 @@ main()
     double roughness[]   = { 0.05, 0.01, 0.05 };
     double z_roughness[] = { 0.75, 1.25 };
 
-    const_set_gravity(32.2);
-    const_set_manning(1.49);
+    Constants constants = CONSTANTS_US;
 
-    printf("Gravity = %f\n", const_gravity());
-    printf("Manning conversion factor = %f\n", const_manning());
+    printf("Gravity = %f\n", constants.gravity);
+    printf("Manning conversion factor = %f\n", constants.manning);
 
     CoArray      ca = coarray_new(n, y, z);
-    CrossSection xs = xs_new(ca, n_roughness, roughness, z_roughness);
+    CrossSection xs = xs_new_with_constants(
+        ca, n_roughness, roughness, z_roughness, &constants);
 
     CoArray           xs_ca = xs_coarray(xs);
     CrossSectionProps xsp;
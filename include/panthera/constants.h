@@ -6,13 +6,56 @@
  * @short_description: Physical constants
  * @title: Constants
  *
- * Application wide access to physical constants
+ * Physical constants. A #Constants value holds the constants of one
+ * simulation and is passed to xs_new_with_constants(), which folds the
+ * constants into the coefficients of the new cross section. Cross sections
+ * with different constants, such as SI and US customary units, can be used
+ * at the same time from different threads.
+ *
+ * The process-wide default constants are used by constructors that are not
+ * given constants, such as xs_new(). They are read when a cross section is
+ * created, so changing them does not affect existing cross sections.
+ */
+
+/**
+ * Constants:
+ * @gravity: acceleration due to gravity [L/T^2]
+ * @manning: conversion factor k used to convert the Manning coefficient from
+ *           SI units
+ *
+ * Physical constants of a simulation
+ */
+typedef struct {
+    double gravity;
+    double manning;
+} Constants;
+
+/**
+ * CONSTANTS_SI:
+ *
+ * Initializer of #Constants in SI units
+ */
+#define CONSTANTS_SI { 9.81, 1 }
+
+/**
+ * CONSTANTS_US:
+ *
+ * Initializer of #Constants in US customary units
+ */
+#define CONSTANTS_US { 32.2, 1.49 }
+
+/**
+ * const_defaults:
+ *
+ * Returns: the process-wide default constants
  */
+extern Constants
+const_defaults(void);
 
 /**
  * const_gravity:
  *
- * Returns the acceleration due to gravity [L/T^2]
+ * Returns the default acceleration due to gravity [L/T^2]
  *
  * Returns: acceleration due to gravity
  */
@@ -22,8 +65,8 @@ const_gravity(void);
 /**
  * const_manning:
  *
- * Returns the conversion factor k used to convert the Manning coefficient from
- * SI units.
+ * Returns the default conversion factor k used to convert the Manning
+ * coefficient from SI units.
  *
  * Returns: Manning formula conversion factor
  */
@@ -34,7 +77,9 @@ const_manning(void);
  * const_set_gravity:
  * @gravity: acceleration due to gravity
  *
- * Sets the acceleration due to gravity [L/T^2]
+ * Sets the default acceleration due to gravity [L/T^2]. The default should
+ * be set before cross sections are created and not while other threads create
+ * cross sections.
  *
  * Returns: nothing
  */
@@ -45,8 +90,9 @@ const_set_gravity(double gravity);
  * const_set_manning:
  * @k: Manning formula conversion factor
  *
- * Sets the conversion factor k used to convert the Manning coefficient from SI
- * units.
+ * Sets the default conversion factor k used to convert the Manning
+ * coefficient from SI units. The default should be set before cross sections
+ * are created and not while other threads create cross sections.
  *
  * Typical values are 1 for SI units and 1.49 for English units.
  *
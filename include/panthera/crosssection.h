@@ -1,6 +1,7 @@
 #ifndef CROSSSECTION_INCLUDED
 #define CROSSSECTION_INCLUDED
 
+#include <panthera/constants.h>
 
 /**
  * SECTION: coordinate.h
@@ -142,6 +143,22 @@ typedef struct CoArray *CoArray;
 extern CoArray
 coarray_new(int n, double *y, double *z);
 
+/**
+ * coarray_new_adopt:
+ * @n: the length of @y and @z
+ * @y: pointer to an array of @n y-values allocated with malloc()
+ * @z: pointer to an array of @n z-values allocated with malloc()
+ *
+ * Creates a new coordinate array like coarray_new() that takes ownership of
+ * @y and @z instead of copying them. @y and @z must not be used or freed by
+ * the caller after the call. They are freed with free() when the coordinate
+ * array is freed with coarray_free().
+ *
+ * Returns: a new coordinate array
+ */
+extern CoArray
+coarray_new_adopt(int n, double *y, double *z);
+
 /**
  * coarray_copy:
  * @a: a #CoArray
@@ -216,6 +233,32 @@ coarray_min_y(CoArray a);
 extern int
 coarray_length(CoArray a);
 
+/**
+ * coarray_y:
+ * @a: a #CoArray
+ *
+ * Returns a pointer to the contiguous y-values of @a. The values are owned by
+ * @a and are valid until @a is freed. NULL coordinates are stored as `NAN`.
+ * No memory is allocated.
+ *
+ * Returns: y-values of @a
+ */
+extern const double *
+coarray_y(CoArray a);
+
+/**
+ * coarray_z:
+ * @a: a #CoArray
+ *
+ * Returns a pointer to the contiguous z-values of @a. The values are owned by
+ * @a and are valid until @a is freed. NULL coordinates are stored as `NAN`.
+ * No memory is allocated.
+ *
+ * Returns: z-values of @a
+ */
+extern const double *
+coarray_z(CoArray a);
+
 /**
  * coarray_get:
  * @a: a #CoArray
@@ -297,6 +340,35 @@ typedef enum {
     N_XSP
 } xs_prop;
 
+/**
+ * xs_prop_mask:
+ * @XS_MASK_DEPTH:             selects #XS_DEPTH
+ * @XS_MASK_AREA:              selects #XS_AREA
+ * @XS_MASK_TOP_WIDTH:         selects #XS_TOP_WIDTH
+ * @XS_MASK_WETTED_PERIMETER:  selects #XS_WETTED_PERIMETER
+ * @XS_MASK_HYDRAULIC_DEPTH:   selects #XS_HYDRAULIC_DEPTH
+ * @XS_MASK_HYDRAULIC_RADIUS:  selects #XS_HYDRAULIC_RADIUS
+ * @XS_MASK_CONVEYANCE:        selects #XS_CONVEYANCE
+ * @XS_MASK_VELOCITY_COEFF:    selects #XS_VELOCITY_COEFF
+ * @XS_MASK_CRITICAL_FLOW:     selects #XS_CRITICAL_FLOW
+ * @XS_MASK_ALL:               selects all hydraulic properties
+ *
+ * Bits selecting hydraulic properties to compute. Masks are combined with
+ * bitwise or.
+ */
+typedef enum {
+    XS_MASK_DEPTH            = 1 << XS_DEPTH,
+    XS_MASK_AREA             = 1 << XS_AREA,
+    XS_MASK_TOP_WIDTH        = 1 << XS_TOP_WIDTH,
+    XS_MASK_WETTED_PERIMETER = 1 << XS_WETTED_PERIMETER,
+    XS_MASK_HYDRAULIC_DEPTH  = 1 << XS_HYDRAULIC_DEPTH,
+    XS_MASK_HYDRAULIC_RADIUS = 1 << XS_HYDRAULIC_RADIUS,
+    XS_MASK_CONVEYANCE       = 1 << XS_CONVEYANCE,
+    XS_MASK_VELOCITY_COEFF   = 1 << XS_VELOCITY_COEFF,
+    XS_MASK_CRITICAL_FLOW    = 1 << XS_CRITICAL_FLOW,
+    XS_MASK_ALL              = (1 << N_XSP) - 1
+} xs_prop_mask;
+
 /**
  * CrossSectionProps:
  *
@@ -304,6 +376,18 @@ typedef enum {
  */
 typedef struct CrossSectionProps *CrossSectionProps;
 
+/**
+ * XSPValues:
+ * @values: property values indexed by #xs_prop
+ *
+ * Fixed-size hydraulic property values. Unlike #CrossSectionProps, an
+ * #XSPValues is owned by the caller and may be stored on the stack or in a
+ * preallocated array.
+ */
+typedef struct {
+    double values[N_XSP];
+} XSPValues;
+
 /**
  * xsp_free:
  * @xsp: a #CrossSectionProps
@@ -378,6 +462,79 @@ typedef struct CrossSection *CrossSection;
 extern CrossSection
 xs_new(CoArray ca, int n_roughness, double *roughness, double *z_roughness);
 
+/**
+ * xs_new_with_constants:
+ * @ca:          a #CoArray
+ * @n_roughness: number of roughness values in cross section
+ * @roughness:   array of @n_roughness values
+ * @z_roughness: array of z-locations of roughness section
+ * @constants:   physical constants of the new cross section
+ *
+ * Creates a new #CrossSection as described in xs_new() that computes its
+ * properties with @constants. xs_new() uses the default constants at the time
+ * it is called. The constants are copied into the new cross section, and the
+ * Manning conversion factor is folded into the conveyance coefficient of each
+ * subsection, so @constants may be discarded after the call.
+ *
+ * Returns: a new #CrossSection
+ */
+extern CrossSection
+xs_new_with_constants(CoArray          ca,
+                      int              n_roughness,
+                      double *         roughness,
+                      double *         z_roughness,
+                      const Constants *constants);
+
+/**
+ * xs_new_adopt:
+ * @ca:          a #CoArray
+ * @n_roughness: number of roughness values in cross section
+ * @roughness:   array of @n_roughness values
+ * @z_roughness: array of z-locations of roughness section
+ * @constants:   physical constants of the new cross section, or `NULL` for
+ *               the defaults
+ *
+ * Creates a new #CrossSection as described in xs_new_with_constants() that
+ * takes ownership of @ca instead of copying it. Subsections whose boundaries
+ * are z-values of coordinates in @ca view the coordinates of @ca rather than
+ * copying them, so building a cross section allocates no coordinate values.
+ * @ca must not be used or freed by the caller after the call. It is freed
+ * with the cross section.
+ *
+ * Returns: a new #CrossSection
+ */
+extern CrossSection
+xs_new_adopt(CoArray          ca,
+             int              n_roughness,
+             double *         roughness,
+             double *         z_roughness,
+             const Constants *constants);
+
+/**
+ * xs_with_roughness:
+ * @xs:        a #CrossSection
+ * @roughness: array of xs_n_subsections() roughness values
+ *
+ * Creates a new #CrossSection with the coordinates, subsection boundaries,
+ * and constants of @xs and @roughness[`i`] for the `i`-th subsection. The
+ * coordinates and the geometry of the subsections of @xs, which do not depend
+ * on roughness, are shared with the new cross section rather than rebuilt, so
+ * creating a cross section for each of many sets of roughness values costs
+ * little more than the allocations. Only conveyance and the velocity
+ * coefficient differ from @xs. The shared coordinates and geometry are freed
+ * with the last cross section that uses them, so @xs and the new cross
+ * section may be freed in any order, but cross sections that share geometry
+ * must be created and freed from one thread at a time. The property table of
+ * @xs, if any, is not copied.
+ *
+ * The returned cross section is newly created and should be freed with
+ * xs_free() after use.
+ *
+ * Returns: a new #CrossSection
+ */
+extern CrossSection
+xs_with_roughness(CrossSection xs, const double *roughness);
+
 /**
  * xs_free:
  * @xs: a #CrossSection
@@ -390,6 +547,19 @@ xs_new(CoArray ca, int n_roughness, double *roughness, double *z_roughness);
 extern void
 xs_free(CrossSection xs);
 
+/**
+ * xs_ref:
+ * @xs: a #CrossSection
+ *
+ * Increases the reference count of @xs. Each reference is released with
+ * xs_free(). Reference counts are not atomic, so references to a cross
+ * section must be taken and released from one thread at a time.
+ *
+ * Returns: @xs
+ */
+extern CrossSection
+xs_ref(CrossSection xs);
+
 /**
  * xs_coarray:
  * @xs: a #CrossSection
@@ -402,6 +572,42 @@ xs_free(CrossSection xs);
 CoArray
 xs_coarray(CrossSection xs);
 
+/**
+ * xs_constants:
+ * @xs: a #CrossSection
+ *
+ * Returns: the physical constants used by @xs
+ */
+extern Constants
+xs_constants(CrossSection xs);
+
+/**
+ * xs_max_y:
+ * @xs: a #CrossSection
+ *
+ * Returns: the maximum y-value of the coordinates in @xs
+ */
+extern double
+xs_max_y(CrossSection xs);
+
+/**
+ * xs_min_y:
+ * @xs: a #CrossSection
+ *
+ * Returns: the minimum y-value of the coordinates in @xs
+ */
+extern double
+xs_min_y(CrossSection xs);
+
+/**
+ * xs_n_coordinates:
+ * @xs: a #CrossSection
+ *
+ * Returns: the number of coordinates in @xs
+ */
+extern int
+xs_n_coordinates(CrossSection xs);
+
 /**
  * xs_n_subsections:
  * @xs: a #CrossSection
@@ -429,6 +635,54 @@ xs_n_subsections(CrossSection xs);
 extern void
 xs_roughness(CrossSection xs, double *roughness);
 
+/**
+ * xs_subsection_span:
+ * @xs: a #CrossSection
+ * @i:  index of a subsection of @xs
+ * @y:  location to store a pointer to the y-values of the subsection
+ * @z:  location to store a pointer to the z-values of the subsection
+ *
+ * Stores pointers to the contiguous y- and z-values of the coordinates of the
+ * @i-th subsection of @xs in @y and @z. The values are owned by @xs and are
+ * valid until @xs is freed. If the subsection boundaries are coordinates of
+ * @xs, the values are part of the values returned by xs_y() and xs_z().
+ * Otherwise the end coordinates are interpolated at the boundaries. No memory
+ * is allocated.
+ *
+ * Returns: the number of coordinates in the subsection
+ */
+extern int
+xs_subsection_span(CrossSection    xs,
+                   int             i,
+                   const double ** y,
+                   const double ** z);
+
+/**
+ * xs_y:
+ * @xs: a #CrossSection
+ *
+ * Returns a pointer to the contiguous y-values of the xs_n_coordinates()
+ * coordinates of @xs. The values are owned by @xs and are valid until @xs is
+ * freed. Unlike xs_coarray(), no memory is allocated.
+ *
+ * Returns: y-values of @xs
+ */
+extern const double *
+xs_y(CrossSection xs);
+
+/**
+ * xs_z:
+ * @xs: a #CrossSection
+ *
+ * Returns a pointer to the contiguous z-values of the xs_n_coordinates()
+ * coordinates of @xs. The values are owned by @xs and are valid until @xs is
+ * freed. Unlike xs_coarray(), no memory is allocated.
+ *
+ * Returns: z-values of @xs
+ */
+extern const double *
+xs_z(CrossSection xs);
+
 /**
  * xs_z_roughness:
  * @xs: a #CrossSection
@@ -458,20 +712,195 @@ xs_z_roughness(CrossSection xs, double *z_roughness);
 extern CrossSectionProps
 xs_hydraulic_properties(CrossSection xs, double h);
 
+/**
+ * xs_hydraulic_properties_into:
+ * @xs:  a #CrossSection
+ * @h:   depth
+ * @xsp: location to store the hydraulic properties
+ *
+ * Computes the hydraulic properties of @xs at depth @h and stores them in
+ * @xsp. No memory is allocated. If @h is not finite, all properties in @xsp
+ * are set to `NAN`.
+ *
+ * Returns: nothing
+ */
+extern void
+xs_hydraulic_properties_into(CrossSection xs, double h, XSPValues *xsp);
+
+/**
+ * xs_hydraulic_properties_masked:
+ * @xs:   a #CrossSection
+ * @h:    depth
+ * @mask: bitwise or of #xs_prop_mask values selecting properties to compute
+ * @xsp:  location to store the hydraulic properties
+ *
+ * Computes the hydraulic properties of @xs selected by @mask at depth @h and
+ * stores them in @xsp. Work needed only by properties that are not selected,
+ * such as the subsection conveyance for the velocity coefficient, is skipped.
+ * Values in @xsp of properties that are not selected are unspecified. If @h is
+ * not finite, all properties in @xsp are set to `NAN`. No memory is
+ * allocated.
+ *
+ * Returns: nothing
+ */
+extern void
+xs_hydraulic_properties_masked(CrossSection xs,
+                               double       h,
+                               unsigned int mask,
+                               XSPValues *  xsp);
+
+/**
+ * xs_hydraulic_properties_deriv:
+ * @xs:   a #CrossSection
+ * @h:    depth
+ * @xsp:  location to store the hydraulic properties
+ * @dxsp: location to store the derivatives of the hydraulic properties
+ *
+ * Computes the hydraulic properties of @xs at depth @h and their exact
+ * derivatives with respect to depth in the same pass, and stores them in @xsp
+ * and @dxsp. The derivatives of wetted perimeter and top width are summed from
+ * the partially wet segments of each subsection, and the derivatives of the
+ * remaining properties are computed from them. At coordinate elevations,
+ * where the derivatives are discontinuous, derivatives are taken from above.
+ * The property table of @xs is not used. If @h is not finite, all values are
+ * set to `NAN`. No memory is allocated.
+ *
+ * Returns: nothing
+ */
+extern void
+xs_hydraulic_properties_deriv(CrossSection xs,
+                              double       h,
+                              XSPValues *  xsp,
+                              XSPValues *  dxsp);
+
+/**
+ * xs_hydraulic_properties_batch:
+ * @xs:     a #CrossSection
+ * @n:      number of depths
+ * @depths: array of @n depths
+ * @out:    array of @n * #N_XSP values to store the hydraulic properties
+ *
+ * Computes the hydraulic properties of @xs at each depth in @depths. @out is
+ * stored as structure-of-arrays: property @prop at `depths[i]` is stored in
+ * `out[prop * n + i]`. Depths are evaluated in blocks with a kernel that is
+ * vectorized across depths, using AVX2 or AVX-512 when they are supported by
+ * the processor. Values match xs_hydraulic_properties_into() to within
+ * rounding error. All properties are `NAN` at depths that are not finite. No
+ * memory is allocated.
+ *
+ * Returns: nothing
+ */
+extern void
+xs_hydraulic_properties_batch(CrossSection  xs,
+                              int           n,
+                              const double *depths,
+                              double *      out);
+
+/**
+ * xs_build_table:
+ * @xs:        a #CrossSection
+ * @h_lo:      lower bound of the table range
+ * @h_hi:      upper bound of the table range
+ * @max_error: maximum relative interpolation error
+ *
+ * Enables property-table mode in @xs. The hydraulic properties of @xs are
+ * sampled between @h_lo and @h_hi, at every coordinate elevation of the
+ * subsections in that range and at additional depths where linear
+ * interpolation between samples would exceed a relative error of
+ * @max_error. Subsequent calls to xs_hydraulic_properties() with a depth
+ * between @h_lo and @h_hi interpolate between the two bracketing samples.
+ * Depths outside of the range are computed exactly.
+ *
+ * Any table previously built for @xs is replaced. A table changes the
+ * properties computed by @xs for every holder of a reference, so a table can
+ * be built on a shared cross section only if it has none; replacing a table
+ * requires a single reference. Use xs_pool_build_table() for cross sections
+ * returned by xs_pool_intern().
+ *
+ * Returns: nothing
+ */
+extern void
+xs_build_table(CrossSection xs, double h_lo, double h_hi, double max_error);
+
+/**
+ * xs_clear_table:
+ * @xs: a #CrossSection
+ *
+ * Frees the property table of @xs, if one has been built, and returns @xs to
+ * exact property computation. @xs must have a single reference.
+ *
+ * Returns: nothing
+ */
+extern void
+xs_clear_table(CrossSection xs);
+
+/**
+ * xs_table_size:
+ * @xs: a #CrossSection
+ *
+ * Returns: the number of samples in the property table of @xs, or 0 if
+ * property-table mode is not enabled
+ */
+extern int
+xs_table_size(CrossSection xs);
+
+/**
+ * XSSolveInfo:
+ * @converged:     nonzero if a solution has been found
+ * @n_iterations:  the number of iterations taken during the solution
+ * @n_evaluations: the number of hydraulic property evaluations taken during
+ *                 the solution
+ * @residual:      the residual of the equation being solved at the solution
+ *
+ * Statistics of an iterative solution, such as a critical or normal depth
+ * solution
+ */
+typedef struct {
+    int    converged;
+    int    n_iterations;
+    int    n_evaluations;
+    double residual;
+} XSSolveInfo;
+
 /**
  * xs_critical_depth
  * @xs:            a #CrossSection
  * @critical_flow: critical flow value
  * @initial_depth: initial depth for solution
  *
- * Computes critical depth using secant solver. Returns `NAN` if no solution is
- * found.
+ * Computes critical depth with xs_critical_depth_solve(). Returns `NAN` if no
+ * solution is found.
  *
  * Returns: critical depth computed for @critical_flow
  */
 extern double
 xs_critical_depth(CrossSection xs, double critical_flow, double initial_depth);
 
+/**
+ * xs_critical_depth_solve
+ * @xs:            a #CrossSection
+ * @critical_flow: critical flow value
+ * @initial_depth: initial depth for solution
+ * @info:          location to store solution statistics, or `NULL`
+ *
+ * Computes critical depth with a bracketing solver. The solution is bracketed
+ * between the minimum y-value of @xs, where critical flow is 0, and a depth
+ * found by searching upward from the maximum y-value of @xs. Newton steps
+ * computed from the derivative of critical flow are taken from
+ * @initial_depth, with bisection steps taken when a Newton step leaves the
+ * bracket. If the property table of @xs is enabled, Brent's method is used
+ * with table lookups instead. @initial_depth only affects the number of
+ * iterations taken. No memory is allocated. Returns `NAN` if no solution is
+ * found.
+ *
+ * Returns: critical depth computed for @critical_flow
+ */
+extern double
+xs_critical_depth_solve(CrossSection xs,
+                        double       critical_flow,
+                        double       initial_depth,
+                        XSSolveInfo *info);
+
 /**
  * xs_normal_depth
  * @xs:            a #CrossSection
@@ -479,8 +908,8 @@ xs_critical_depth(CrossSection xs, double critical_flow, double initial_depth);
  * @slope:         slope for computing normal depth
  * @initial_depth: initial depth for solution
  *
- * Computes normal depth using secant solver. Returns `NAN` if no solution is
- * found.
+ * Computes normal depth with xs_normal_depth_solve(). Returns `NAN` if no
+ * solution is found.
  *
  * Returns: normal depth computed for @normal_flow
  */
@@ -490,4 +919,227 @@ xs_normal_depth(CrossSection xs,
                 double       slope,
                 double       initial_depth);
 
+/**
+ * xs_normal_depth_solve
+ * @xs:            a #CrossSection
+ * @normal_flow:   normal flow value
+ * @slope:         slope for computing normal depth
+ * @initial_depth: initial depth for solution
+ * @info:          location to store solution statistics, or `NULL`
+ *
+ * Computes normal depth with the bracketing solver described in
+ * xs_critical_depth_solve(), using the derivative of conveyance. Returns
+ * `NAN` if no solution is found.
+ *
+ * Returns: normal depth computed for @normal_flow
+ */
+extern double
+xs_normal_depth_solve(CrossSection xs,
+                      double       normal_flow,
+                      double       slope,
+                      double       initial_depth,
+                      XSSolveInfo *info);
+
+/**
+ * xs_hydraulic_properties_many:
+ * @xs:        array of @n_xs cross sections
+ * @n_xs:      number of cross sections
+ * @n_depths:  number of depths for each cross section
+ * @depths:    array of @n_xs * @n_depths depths
+ * @out:       array of @n_xs * @n_depths * #N_XSP values to store the
+ *             hydraulic properties
+ * @n_threads: maximum number of threads to use
+ *
+ * Computes the hydraulic properties of many cross sections at many depths,
+ * such as for the rating curves of many cross sections. Cross section i is
+ * evaluated with xs_hydraulic_properties_batch() at the depths starting at
+ * `depths[i * n_depths]` and its properties are stored starting at
+ * `out[i * n_depths * N_XSP]`. The cross sections are divided among up to
+ * @n_threads threads, including the calling thread, and must not be modified
+ * during the call. A cross section may appear more than once in @xs. The
+ * results do not depend on the number of threads. No memory is allocated
+ * when @n_threads is 1.
+ *
+ * Returns: nothing
+ */
+extern void
+xs_hydraulic_properties_many(CrossSection *xs,
+                             int           n_xs,
+                             int           n_depths,
+                             const double *depths,
+                             double *      out,
+                             int           n_threads);
+
+/**
+ * xs_critical_depth_many:
+ * @xs:            array of @n cross sections
+ * @n:             number of solutions
+ * @critical_flow: array of @n critical flow values
+ * @initial_depth: array of @n initial depths, or `NULL`
+ * @depth:         array of @n values to store the critical depths
+ * @info:          array of @n values to store the solution statistics, or
+ *                 `NULL`
+ * @n_threads:     maximum number of threads to use
+ *
+ * Computes the critical depth of `xs[i]` for `critical_flow[i]` with
+ * xs_critical_depth_solve() for each i. If @initial_depth is `NULL`, each
+ * solution starts from the middle of its bracket. The solutions are divided
+ * among up to @n_threads threads, including the calling thread, and the
+ * cross sections must not be modified during the call. The results do not
+ * depend on the number of threads. No memory is allocated when @n_threads is
+ * 1.
+ *
+ * Returns: nothing
+ */
+extern void
+xs_critical_depth_many(CrossSection *xs,
+                       int           n,
+                       const double *critical_flow,
+                       const double *initial_depth,
+                       double *      depth,
+                       XSSolveInfo * info,
+                       int           n_threads);
+
+/**
+ * xs_normal_depth_many:
+ * @xs:            array of @n cross sections
+ * @n:             number of solutions
+ * @normal_flow:   array of @n normal flow values
+ * @slope:         array of @n slopes
+ * @initial_depth: array of @n initial depths, or `NULL`
+ * @depth:         array of @n values to store the normal depths
+ * @info:          array of @n values to store the solution statistics, or
+ *                 `NULL`
+ * @n_threads:     maximum number of threads to use
+ *
+ * Computes the normal depth of `xs[i]` for `normal_flow[i]` and `slope[i]`
+ * with xs_normal_depth_solve() for each i, divided among threads as
+ * described in xs_critical_depth_many().
+ *
+ * Returns: nothing
+ */
+extern void
+xs_normal_depth_many(CrossSection *xs,
+                     int           n,
+                     const double *normal_flow,
+                     const double *slope,
+                     const double *initial_depth,
+                     double *      depth,
+                     XSSolveInfo * info,
+                     int           n_threads);
+
+/**
+ * XSPool:
+ *
+ * Interning table that shares cross sections with the same shape
+ */
+typedef struct XSPool *XSPool;
+
+/**
+ * xs_pool_new:
+ * @tolerance: largest difference between coordinates considered equal
+ *
+ * Creates an empty pool. Coordinates of cross sections interned in the pool
+ * are compared within @tolerance, which may be 0 to require exact equality.
+ * The returned pool is newly created and should be freed with xs_pool_free()
+ * after use.
+ *
+ * Returns: a new #XSPool
+ */
+extern XSPool
+xs_pool_new(double tolerance);
+
+/**
+ * xs_pool_free:
+ * @pool: a #XSPool
+ *
+ * Releases the references held by @pool to its cross sections and frees
+ * @pool. Cross sections still referenced elsewhere are not freed.
+ *
+ * Returns: nothing
+ */
+extern void
+xs_pool_free(XSPool pool);
+
+/**
+ * xs_pool_size:
+ * @pool: a #XSPool
+ *
+ * Returns: the number of distinct cross sections in @pool
+ */
+extern int
+xs_pool_size(XSPool pool);
+
+/**
+ * xs_pool_intern:
+ * @pool:        a #XSPool
+ * @ca:          a #CoArray
+ * @n_roughness: number of roughness values in cross section
+ * @roughness:   array of @n_roughness values
+ * @z_roughness: array of z-locations of roughness section
+ * @constants:   physical constants of the cross section, or `NULL` for the
+ *               default constants
+ * @y_offset:    location to store the vertical offset of @ca
+ *
+ * Returns a cross section with the shape described by the arguments, as
+ * xs_new_with_constants() would create, shared with every other call that
+ * describes the same shape. Shapes are the same if they have the same
+ * roughness values and constants and their coordinates differ only by a
+ * vertical shift, within the tolerance of @pool.
+ *
+ * The coordinates of the returned cross section are those of @ca shifted
+ * down so that the lowest y-value is 0, and the shift, the minimum y-value of
+ * @ca, is stored in @y_offset. Depths and elevations of the returned cross
+ * section are relative to @y_offset, so a node of a reach is created with
+ * reach_put_xs() at the elevation of the original coordinates plus
+ * @y_offset. Nodes with the same shape then share one cross section, one
+ * set of subsection geometry, and the property table built for the shape
+ * with xs_pool_build_table().
+ *
+ * The first cross section interned with a shape is kept. Shapes are looked
+ * up by a hash of their coordinates rounded to the nearest multiple of the
+ * tolerance, so shapes that are within tolerance but round to different
+ * multiples are not shared. With a tolerance of 0.001, for example, z-values
+ * of 1.0004999 and 1.0005001 are within tolerance but are interned as two
+ * shapes. Interning takes time linear in the number of coordinates and no
+ * memory is allocated when the shape is already in @pool.
+ *
+ * The returned cross section holds a new reference and should be released
+ * with xs_free() after use. A pool must be used by one thread at a time.
+ *
+ * Returns: an interned #CrossSection
+ */
+extern CrossSection
+xs_pool_intern(XSPool           pool,
+               CoArray          ca,
+               int              n_roughness,
+               double *         roughness,
+               double *         z_roughness,
+               const Constants *constants,
+               double *         y_offset);
+
+/**
+ * xs_pool_build_table:
+ * @pool:      a #XSPool
+ * @xs:        a #CrossSection returned by xs_pool_intern() for @pool
+ * @h_lo:      lower bound of the table range
+ * @h_hi:      upper bound of the table range
+ * @max_error: maximum relative interpolation error
+ *
+ * Builds a property table for @xs with xs_build_table() unless one has
+ * already been built. Like the cross section itself, the first table built
+ * for a shape is kept and used by every node with that shape, so it is built
+ * once however many times the shape is interned. Depths of interned cross
+ * sections are relative to their lowest point, so one range of depths suits
+ * every shape in @pool.
+ *
+ * Returns: nonzero if a table was built, 0 if @xs already had one
+ */
+extern int
+xs_pool_build_table(XSPool       pool,
+                    CrossSection xs,
+                    double       h_lo,
+                    double       h_hi,
+                    double       max_error);
+
 #endif
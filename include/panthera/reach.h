@@ -34,13 +34,45 @@ reach_new(void);
  * reach_free:
  * @reach: a #Reach
  *
- * Frees @reach. The cross sections referenced by @reach are not freed.
+ * Frees @reach in O(n) time. The cross sections referenced by @reach are not
+ * freed.
  *
  * Returns: nothing
  */
 extern void
 reach_free(Reach reach);
 
+/**
+ * reach_freeze:
+ * @reach: a #Reach
+ *
+ * Creates a read-only snapshot of @reach. The snapshot has its own copy of
+ * the nodes of @reach and the stream distance and elevation vectors of the
+ * nodes, which are built once when the snapshot is created. The snapshot
+ * refers to the same cross sections as @reach. Nodes cannot be added to the
+ * snapshot, and @reach may continue to be modified without affecting it.
+ *
+ * None of the functions that query or solve a reach modify it, so any number
+ * of threads may use a frozen reach at the same time without locks, provided
+ * that its cross sections are not modified, such as by xs_build_table().
+ *
+ * The returned reach is newly created and should be freed with reach_free()
+ * after use.
+ *
+ * Returns: a frozen copy of @reach
+ */
+extern Reach
+reach_freeze(Reach reach);
+
+/**
+ * reach_is_frozen:
+ * @reach: a #Reach
+ *
+ * Returns: nonzero if @reach was created by reach_freeze()
+ */
+extern int
+reach_is_frozen(Reach reach);
+
 /**
  * reach_size:
  * @reach: a #Reach
@@ -70,20 +102,93 @@ reach_size(Reach reach);
 extern ReachNodeProps
 reach_rnp(Reach reach, int i, double wse, double q);
 
+/**
+ * RNPArrays:
+ * @velocity:       array to store the mean velocity of each node, or `NULL`
+ * @friction_slope: array to store the friction slope of each node, or `NULL`
+ * @velocity_head:  array to store the velocity head of each node, or `NULL`
+ * @area:           array to store the wetted area of each node, or `NULL`
+ * @top_width:      array to store the top width of each node, or `NULL`
+ * @froude:         array to store the Froude number of each node, or `NULL`
+ *
+ * Output arrays of reach_rnp_many(), each with one element for each node of
+ * a reach. Properties with a `NULL` array are not stored.
+ */
+typedef struct {
+    double *velocity;
+    double *friction_slope;
+    double *velocity_head;
+    double *area;
+    double *top_width;
+    double *froude;
+} RNPArrays;
+
+/**
+ * reach_rnp_many:
+ * @reach:     a #Reach
+ * @wse:       array of water surface elevations, one for each node
+ * @q:         array of discharge values, one for each node
+ * @out:       output arrays
+ * @n_threads: maximum number of threads to use
+ *
+ * Computes the properties of every node of @reach in one call and stores
+ * them in the arrays of @out. The Froude number is the velocity divided by
+ * the square root of gravity times the hydraulic depth, so it is 1 at
+ * critical flow. The nodes are divided into contiguous blocks that are
+ * evaluated on up to @n_threads threads, including the calling thread, when
+ * @n_threads is greater than 1 and threads are available. The results do not
+ * depend on the number of threads. No memory is allocated when @n_threads is
+ * 1.
+ *
+ * Returns: nothing
+ */
+extern void
+reach_rnp_many(Reach         reach,
+               const double *wse,
+               const double *q,
+               RNPArrays *   out,
+               int           n_threads);
+
 /**
  * reach_put_xs:
  * @reach: a #Reach
  * @x:     distance downstream
  * @y:     thalweg elevation
- * xs:     a #CrossSection
+ * @xs:    a #CrossSection
  *
- * Create a node in a reach from a cross section.
+ * Create a node in a reach from a cross section. The nodes of @reach are kept
+ * in an array ordered by distance downstream. A node already at @x is
+ * replaced. Adding a node downstream of the other nodes takes amortized
+ * constant time. Use reach_put_xs_many() to add many nodes in any order.
+ * @reach must not be frozen.
  *
  * Returns: nothing
  */
 extern void
 reach_put_xs(Reach reach, double x, double y, CrossSection xs);
 
+/**
+ * reach_put_xs_many:
+ * @reach: a #Reach
+ * @n:     number of nodes to add
+ * @x:     array of @n distances downstream
+ * @y:     array of @n thalweg elevations
+ * @xs:    array of @n cross sections
+ *
+ * Creates @n nodes in @reach, the same as calling reach_put_xs() for each
+ * element of the arrays in order. The new nodes are sorted once and merged
+ * with the existing nodes of @reach, so adding n nodes to a reach of m nodes
+ * takes O(n log n + m) time.
+ *
+ * Returns: nothing
+ */
+extern void
+reach_put_xs_many(Reach               reach,
+                  int                 n,
+                  const double *      x,
+                  const double *      y,
+                  const CrossSection *xs);
+
 /**
  * reach_stream_distance:
  * @reach: a #Reach
@@ -112,4 +217,228 @@ reach_stream_distance(Reach reach, double *x);
 extern void
 reach_elevation(Reach reach, double *y);
 
+/**
+ * reach_stream_distance_data:
+ * @reach: a frozen #Reach
+ *
+ * @reach must have been created by reach_freeze(); use
+ * reach_stream_distance() to copy the stream distance values of a reach that
+ * can still be modified. The returned array is owned by @reach and has
+ * reach_size() elements ordered by distance downstream. It must not be
+ * modified or freed.
+ *
+ * Returns: the stream distance values of the nodes in @reach
+ */
+extern const double *
+reach_stream_distance_data(Reach reach);
+
+/**
+ * reach_elevation_data:
+ * @reach: a frozen #Reach
+ *
+ * @reach must have been created by reach_freeze(); use reach_elevation() to
+ * copy the elevation values of a reach that can still be modified. The
+ * returned array is owned by @reach and has reach_size() elements ordered by
+ * distance downstream. It must not be modified or freed.
+ *
+ * Returns: the elevation values of the nodes in @reach
+ */
+extern const double *
+reach_elevation_data(Reach reach);
+
+/**
+ * reach_energy_residuals:
+ * @reach:        a #Reach
+ * @wse:          array of water surface elevations, one for each node
+ * @q:            array of discharge values, one for each node
+ * @residual:     array to store the energy equation residuals
+ * @dres_dwse_lo: array to store the derivatives of the residuals with
+ *                respect to the upstream water surface elevations, or `NULL`
+ * @dres_dwse_hi: array to store the derivatives of the residuals with
+ *                respect to the downstream water surface elevations, or
+ *                `NULL`
+ *
+ * Computes the residuals of the energy equations between all consecutive
+ * nodes of @reach. Element i of @residual is
+ *
+ * wse[i + 1] + hv[i + 1] - wse[i] - hv[i] + (x[i + 1] - x[i]) * (sf[i] +
+ * sf[i + 1]) / 2
+ *
+ * where hv is the velocity head, sf is the friction slope, and x is the
+ * distance downstream. Element i of @dres_dwse_lo and @dres_dwse_hi is the
+ * derivative of element i of @residual with respect to wse[i] and
+ * wse[i + 1], respectively, computed from exact property derivatives. These
+ * are the two bands of the Jacobian of the energy equations. If
+ * @dres_dwse_lo and @dres_dwse_hi are `NULL`, only the residuals are
+ * computed. The properties of each node are evaluated once.
+ *
+ * @wse and @q must each have reach_size() elements and @residual,
+ * @dres_dwse_lo, and @dres_dwse_hi must each have reach_size() - 1 elements,
+ * all ordered by distance downstream. No memory is allocated.
+ *
+ * Returns: nothing
+ */
+extern void
+reach_energy_residuals(Reach         reach,
+                       const double *wse,
+                       const double *q,
+                       double *      residual,
+                       double *      dres_dwse_lo,
+                       double *      dres_dwse_hi);
+
+/**
+ * reach_boundary:
+ * @REACH_UPSTREAM:   boundary condition at the most upstream node
+ * @REACH_DOWNSTREAM: boundary condition at the most downstream node
+ *
+ * Location of a boundary condition in a reach
+ */
+typedef enum { REACH_UPSTREAM, REACH_DOWNSTREAM } reach_boundary;
+
+/**
+ * reach_standard_step:
+ * @reach:       a #Reach
+ * @q:           array of discharge values, one for each node
+ * @wse_bc:      water surface elevation boundary condition
+ * @bc_location: location of the boundary condition
+ * @wse:         array to store the computed water surface elevations
+ * @info:        array to store the solution statistics of each node, or
+ *               `NULL`
+ *
+ * Computes a water surface profile with the standard step method. The water
+ * surface elevation at the node at @bc_location is @wse_bc, and the profile
+ * is computed node by node away from the boundary. A subcritical profile is
+ * computed upstream from a downstream boundary condition and a supercritical
+ * profile is computed downstream from an upstream boundary condition.
+ *
+ * The water surface elevation at each node is solved from the energy equation
+ * with a safeguarded Newton method using exact property derivatives. The
+ * solution is bracketed between critical depth and a depth found by searching
+ * upward, or toward the bottom of the cross section for a supercritical
+ * profile. If no solution is found at a node, the water surface elevations of
+ * that node and the remaining nodes are set to `NAN`.
+ *
+ * @q, @wse, and @info must each have reach_size() elements and are ordered by
+ * distance downstream. No memory is allocated.
+ *
+ * Returns: the number of nodes with a computed water surface elevation,
+ * including the boundary condition node
+ */
+extern int
+reach_standard_step(Reach          reach,
+                    const double * q,
+                    double         wse_bc,
+                    reach_boundary bc_location,
+                    double *       wse,
+                    XSSolveInfo *  info);
+
+/**
+ * reach_standard_step_many:
+ * @reach:       a #Reach
+ * @n_profiles:  number of profiles
+ * @q:           array of @n_profiles * reach_size() discharge values
+ * @wse_bc:      array of @n_profiles water surface elevation boundary
+ *               conditions
+ * @bc_location: location of the boundary conditions
+ * @wse:         array of @n_profiles * reach_size() values to store the
+ *               computed water surface elevations
+ * @info:        array of @n_profiles * reach_size() values to store the
+ *               solution statistics of each node, or `NULL`
+ * @n_solved:    array of @n_profiles values to store the number of nodes
+ *               with a computed water surface elevation, or `NULL`
+ * @n_threads:   maximum number of threads to use
+ *
+ * Computes @n_profiles independent water surface profiles with
+ * reach_standard_step(). Profile p uses the discharge values starting at
+ * `q[p * reach_size()]` and boundary condition `wse_bc[p]` and stores its
+ * results starting at `wse[p * reach_size()]` and `info[p * reach_size()]`.
+ * The profiles are divided among up to @n_threads threads, including the
+ * calling thread. The results do not depend on the number of threads. No
+ * memory is allocated when @n_threads is 1.
+ *
+ * Returns: nothing
+ */
+extern void
+reach_standard_step_many(Reach          reach,
+                         int            n_profiles,
+                         const double * q,
+                         const double * wse_bc,
+                         reach_boundary bc_location,
+                         double *       wse,
+                         XSSolveInfo *  info,
+                         int *          n_solved,
+                         int            n_threads);
+
+/**
+ * reach_simultaneous:
+ * @reach:  a #Reach
+ * @q:      array of discharge values, one for each node
+ * @wse_bc: water surface elevation at the most downstream node
+ * @wse:    array to store the computed water surface elevations
+ * @info:   location to store the solution statistics, or `NULL`
+ *
+ * Computes a water surface profile by solving the energy equations between
+ * all consecutive nodes simultaneously with Newton's method. The initial
+ * estimate is the depth of the downstream boundary condition at every node.
+ *
+ * The Jacobian of the energy equations is upper bidiagonal. Each iteration
+ * evaluates the properties and exact property derivatives of every node once
+ * in a single upstream sweep that assembles each residual and Jacobian row and
+ * solves it by back substitution, so an iteration takes O(n) time. Steps are
+ * limited at each node to between halving and doubling the depth.
+ *
+ * The solution has converged when the largest absolute residual is less than
+ * 1e-8. If @info is not `NULL`, the number of iterations, the number of node
+ * property evaluations, and the largest absolute residual of the last
+ * iteration are stored in @info.
+ *
+ * @q and @wse must each have reach_size() elements and are ordered by
+ * distance downstream. No memory is allocated.
+ *
+ * Returns: nonzero if a solution is found
+ */
+extern int
+reach_simultaneous(Reach         reach,
+                   const double *q,
+                   double        wse_bc,
+                   double *      wse,
+                   XSSolveInfo * info);
+
+/**
+ * reach_boundary_value:
+ * @reach: a #Reach
+ * @wse:   array of water surface elevations
+ * @q:     location of the discharge
+ * @info:  location to store the solution statistics, or `NULL`
+ *
+ * Computes a water surface profile and the discharge through @reach from the
+ * water surface elevations at both ends of @reach. On input, the first and
+ * last elements of @wse are the known water surface elevations, the other
+ * elements of @wse are an initial estimate of the profile, and @q is an
+ * initial estimate of the discharge, which must be positive. On output, @wse
+ * and @q contain the solution. The discharge is the same at every node.
+ *
+ * The energy equations between all consecutive nodes are solved with
+ * Newton's method. The Jacobian is bidiagonal in the unknown water surface
+ * elevations and bordered by a dense discharge column. Each iteration
+ * evaluates the residuals and Jacobian bands with reach_energy_residuals()
+ * and solves the system in an upstream sweep that expresses each water
+ * surface elevation step as a linear function of the discharge step, so an
+ * iteration takes O(n) time.
+ * The Newton step is scaled so that no depth and not the discharge is more
+ * than doubled or less than halved, and is then halved until the sum of
+ * squared residuals decreases. If the residuals cannot be reduced, the
+ * estimate from the start of that iteration is returned. Convergence depends
+ * on the initial estimate, particularly on long reaches.
+ *
+ * The solution has converged when the largest absolute residual is less than
+ * 1e-8. If @info is not `NULL`, the number of iterations, the number of node
+ * property evaluations, and the largest absolute residual of the last
+ * iteration are stored in @info. @reach must have at least two nodes.
+ *
+ * Returns: nonzero if a solution is found
+ */
+extern int
+reach_boundary_value(Reach reach, double *wse, double *q, XSSolveInfo *info);
+
 #endif
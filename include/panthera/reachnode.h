@@ -40,6 +40,18 @@ typedef enum {
  */
 typedef struct ReachNodeProps *ReachNodeProps;
 
+/**
+ * RNPValues:
+ * @values: property values indexed by #rn_prop
+ *
+ * Fixed-size reach node property values. Unlike #ReachNodeProps, an
+ * #RNPValues is owned by the caller and may be stored on the stack or in a
+ * preallocated array.
+ */
+typedef struct {
+    double values[N_RN];
+} RNPValues;
+
 /**
  * rnp_free:
  * @rnp: a #ReachNodeProps
@@ -111,6 +123,17 @@ reachnode_x(ReachNode node);
 extern double
 reachnode_y(ReachNode node);
 
+/**
+ * reachnode_xs:
+ * @node: a #ReachNode
+ *
+ * The returned cross section is referenced by @node and must not be freed.
+ *
+ * Returns: the cross section of a reach node
+ */
+extern CrossSection
+reachnode_xs(ReachNode node);
+
 /**
  * reachnode_xsp:
  * @node: a #ReachNode
@@ -139,4 +162,41 @@ reachnode_xsp(ReachNode node, double wse);
 extern ReachNodeProps
 reachnode_properties(ReachNode node, double wse, double q);
 
+/**
+ * reachnode_properties_into:
+ * @node: a #ReachNode
+ * @wse:  water surface elevation
+ * @q:    discharge
+ * @rnp:  location to store the reach node properties
+ *
+ * Computes properties for a reach node and stores them in @rnp. No memory is
+ * allocated.
+ *
+ * Returns: nothing
+ */
+extern void
+reachnode_properties_into(ReachNode node, double wse, double q, RNPValues *rnp);
+
+/**
+ * reachnode_properties_deriv:
+ * @node: a #ReachNode
+ * @wse:  water surface elevation
+ * @q:    discharge
+ * @rnp:  location to store the reach node properties
+ * @drnp: location to store the derivatives of the reach node properties
+ *
+ * Computes properties for a reach node and stores them in @rnp, and stores
+ * their derivatives with respect to water surface elevation in @drnp. The
+ * derivatives are computed from the exact cross section property derivatives
+ * returned by xs_hydraulic_properties_deriv(). No memory is allocated.
+ *
+ * Returns: nothing
+ */
+extern void
+reachnode_properties_deriv(ReachNode  node,
+                           double     wse,
+                           double     q,
+                           RNPValues *rnp,
+                           RNPValues *drnp);
+
 #endif
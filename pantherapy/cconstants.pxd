@@ -1,4 +1,9 @@
 cdef extern from "panthera/constants.h":
+    ctypedef struct Constants:
+        double gravity
+        double manning
+
+    Constants const_defaults()
     double const_gravity()
     double const_manning()
     void const_set_gravity(double gravity)
@@ -1,3 +1,5 @@
+from pantherapy.cconstants cimport Constants
+
 cdef extern from "panthera/crosssection.h":
 
     # coordinate
@@ -46,6 +48,9 @@ cdef extern from "panthera/crosssection.h":
         XS_CRITICAL_FLOW,
         N_XSP
 
+    ctypedef struct XSPValues:
+        double values[N_XSP]
+
     cdef void xsp_free(CrossSectionProps xsp)
     cdef double xsp_get(CrossSectionProps xsp, xs_prop prop)
 
@@ -59,12 +64,50 @@ cdef extern from "panthera/crosssection.h":
                         double *roughness,
                         double *z_roughness)
 
+    CrossSection xs_new_adopt(CoArray ca,
+                              int n_roughness,
+                              double *roughness,
+                              double *z_roughness,
+                              const Constants *constants)
+
+    CrossSection xs_with_roughness(CrossSection xs, const double *roughness)
+
     void xs_free(CrossSection xs)
 
     CoArray xs_coarray(CrossSection xs)
 
+    double xs_max_y(CrossSection xs)
+
+    double xs_min_y(CrossSection xs)
+
+    int xs_n_coordinates(CrossSection xs)
+
+    const double *xs_y(CrossSection xs)
+
+    const double *xs_z(CrossSection xs)
+
+    ctypedef struct XSSolveInfo:
+        int converged
+        int n_iterations
+        int n_evaluations
+        double residual
+
     double xs_critical_depth(CrossSection xs, double qc, double y0)
 
     CrossSectionProps xs_hydraulic_properties(CrossSection xs, double h)
 
+    void xs_hydraulic_properties_into(CrossSection xs,
+                                      double h,
+                                      XSPValues *xsp)
+
+    void xs_hydraulic_properties_deriv(CrossSection xs,
+                                       double h,
+                                       XSPValues *xsp,
+                                       XSPValues *dxsp)
+
+    void xs_hydraulic_properties_batch(CrossSection xs,
+                                       int n,
+                                       const double *depths,
+                                       double *out)
+
     double xs_normal_depth(CrossSection xs, double qn, double s, double y0)
@@ -0,0 +1,63 @@
+from pantherapy.ccrosssection cimport CrossSection, XSSolveInfo
+
+cdef extern from "panthera/reach.h":
+
+    ctypedef struct Reach:
+        pass
+
+    ctypedef enum reach_boundary:
+        REACH_UPSTREAM,
+        REACH_DOWNSTREAM
+
+    Reach reach_new()
+
+    void reach_free(Reach reach)
+
+    int reach_size(Reach reach)
+
+    ctypedef struct RNPArrays:
+        double *velocity
+        double *friction_slope
+        double *velocity_head
+        double *area
+        double *top_width
+        double *froude
+
+    void reach_rnp_many(Reach reach,
+                        const double *wse,
+                        const double *q,
+                        RNPArrays *out,
+                        int n_threads)
+
+    void reach_put_xs(Reach reach, double x, double y, CrossSection xs)
+
+    void reach_put_xs_many(Reach reach,
+                           int n,
+                           const double *x,
+                           const double *y,
+                           const CrossSection *xs)
+
+    void reach_energy_residuals(Reach reach,
+                                const double *wse,
+                                const double *q,
+                                double *residual,
+                                double *dres_dwse_lo,
+                                double *dres_dwse_hi)
+
+    int reach_standard_step(Reach reach,
+                            const double *q,
+                            double wse_bc,
+                            reach_boundary bc_location,
+                            double *wse,
+                            XSSolveInfo *info)
+
+    int reach_simultaneous(Reach reach,
+                           const double *q,
+                           double wse_bc,
+                           double *wse,
+                           XSSolveInfo *info)
+
+    int reach_boundary_value(Reach reach,
+                             double *wse,
+                             double *q,
+                             XSSolveInfo *info)
@@ -1,5 +1,6 @@
 #  cython : language_level=3
 
+from cpython.buffer cimport PyBUF_FORMAT, PyBUF_WRITABLE
 from cpython.ref cimport PyObject
 cimport cpython.float as pyfloat
 from libc.math cimport isfinite, sqrt, NAN
@@ -13,6 +14,58 @@ from matplotlib.patches import Polygon
 cimport pantherapy.cconstants as constants
 cimport pantherapy.ccrosssection as cxs
 
+cdef class _CoordinateBuffer:
+    """Read-only buffer of coordinate values owned by a cross section
+
+    The buffer keeps the cross section that owns the values alive, so
+    arrays created from the buffer remain valid after the cross section
+    is no longer referenced elsewhere.
+
+    """
+
+    cdef object owner
+    cdef const double *data
+    cdef Py_ssize_t shape[1]
+    cdef Py_ssize_t strides[1]
+
+    def __getbuffer__(self, Py_buffer *buffer, int flags):
+
+        if flags & PyBUF_WRITABLE:
+            raise BufferError("coordinate values are read-only")
+
+        buffer.buf = <void *> self.data
+        if flags & PyBUF_FORMAT:
+            buffer.format = 'd'
+        else:
+            buffer.format = NULL
+        buffer.internal = NULL
+        buffer.itemsize = sizeof(double)
+        buffer.len = self.shape[0] * sizeof(double)
+        buffer.ndim = 1
+        buffer.obj = self
+        buffer.readonly = 1
+        buffer.shape = self.shape
+        buffer.strides = self.strides
+        buffer.suboffsets = NULL
+
+    def __releasebuffer__(self, Py_buffer *buffer):
+        pass
+
+
+cdef _coordinate_view(object owner, const double *data, Py_ssize_t n):
+    """Returns a read-only array viewing n values owned by owner"""
+
+    cdef _CoordinateBuffer buffer = \
+        _CoordinateBuffer.__new__(_CoordinateBuffer)
+
+    buffer.owner = owner
+    buffer.data = data
+    buffer.shape[0] = n
+    buffer.strides[0] = sizeof(double)
+
+    return np.asarray(buffer)
+
+
 cdef class CrossSection:
     """CrossSection(y, z, roughness) -> new CrossSection with one subsection
 
@@ -57,9 +110,8 @@ cdef class CrossSection:
         cdef cxs.CoArray ca = \
             cxs.coarray_new(n_coordinates, &y_view[0], &z_view[0])
 
-        self.xs = cxs.xs_new(ca, 1, &n, NULL)
-
-        cxs.coarray_free(ca)
+        # the cross section takes ownership of ca
+        self.xs = cxs.xs_new_adopt(ca, 1, &n, NULL, NULL)
 
     def __dealloc__(self):
         cxs.xs_free(self.xs)
@@ -115,30 +167,24 @@ cdef class CrossSection:
     cdef _property(self, y, cxs.xs_prop prop):
 
         y = np.array(y, dtype=np.float64, order='C')
-        p = np.zeros_like(y)
 
-        cdef Py_ssize_t i
-        cdef Py_ssize_t i_max = y.size
+        cdef Py_ssize_t n = y.size
+
+        # properties are computed in structure-of-arrays order, one row per
+        # property
+        out = np.empty((cxs.N_XSP, n), dtype=np.float64)
 
         cdef double *y_data = <double *> cnp.PyArray_DATA(y)
-        cdef double *p_data = <double *> cnp.PyArray_DATA(p)
+        cdef double *out_data = <double *> cnp.PyArray_DATA(out)
 
-        cdef cxs.CrossSectionProps xsp
-        cdef double result
+        cxs.xs_hydraulic_properties_batch(self.xs, <int> n, y_data, out_data)
 
-        for i in range(i_max):
-            if not isfinite(y_data[i]):
-                p_data[i] = NAN
-            else:
-                xsp = cxs.xs_hydraulic_properties(self.xs, y_data[i])
-                result = cxs.xsp_get(xsp, prop)
-                p_data[i] = result
-                cxs.xsp_free(xsp)
+        p = out[<int> prop].reshape(np.shape(y))
 
         if np.ndim(p) > 0:
             return p
         else:
-            return p_data[0]
+            return float(p)
 
     def area(self, y):
         """area(y)
@@ -186,6 +232,10 @@ cdef class CrossSection:
     def coordinates(self):
         """Returns cross section coordinates
 
+        The returned arrays are read-only views of the coordinates stored
+        in the cross section, so no values are copied. Copy the arrays to
+        modify them.
+
         Returns
         -------
         numpy.ndarray, numpy.ndarray
@@ -194,27 +244,10 @@ cdef class CrossSection:
 
         """
 
-        cdef cxs.CoArray ca = cxs.xs_coarray(self.xs)
-        cdef Py_ssize_t length = cxs.coarray_length(ca)
-
-        y = np.zeros(length)
-        z = np.zeros(length)
+        cdef Py_ssize_t length = cxs.xs_n_coordinates(self.xs)
 
-        cdef double[:] y_view = y
-        cdef double[:] z_view = z
-
-        cdef Py_ssize_t i
-        cdef Py_ssize_t i_max = length
-
-        cdef cxs.Coordinate c
-
-        for i in range(i_max):
-            c = cxs.coarray_get(ca, <int> i)
-            y_view[i] = c.y
-            z_view[i] = c.z
-            cxs.coord_free(c)
-
-        cxs.coarray_free(ca)
+        y = _coordinate_view(self, cxs.xs_y(self.xs), length)
+        z = _coordinate_view(self, cxs.xs_z(self.xs), length)
 
         return y, z
 
@@ -240,16 +273,13 @@ cdef class CrossSection:
         critical_flow = np.array(critical_flow, dtype=np.float64, order='C')
 
         cdef double cy0
-        cdef cxs.CoArray ca
         cdef double y_min
         cdef double y_max
 
         if y0 is None:
-            ca = cxs.xs_coarray(self.xs)
-            y_min = cxs.coarray_min_y(ca)
-            y_max = cxs.coarray_max_y(ca)
+            y_min = cxs.xs_min_y(self.xs)
+            y_max = cxs.xs_max_y(self.xs)
             cy0 = 0.75 * (y_max - y_min) + y_min
-            cxs.coarray_free(ca)
         else:
             if not pyfloat.PyFloat_Check(y0):
                 raise ValueError("y0 must be a float")
@@ -290,6 +320,70 @@ cdef class CrossSection:
 
         return self._property(y, cxs.XS_CRITICAL_FLOW)
 
+    def derivative(self, y, prop):
+        """derivative(y, prop)
+
+        Computes the derivative of a property with respect to depth
+
+        Parameters
+        ----------
+        y : array_like
+            Water surface elevation
+        prop : {'area', 'top_width', 'wetted_perimeter', 'hydraulic_depth',
+                'hydraulic_radius', 'conveyance', 'velocity_coeff',
+                'critical_flow'}
+            Property name
+
+        Returns
+        -------
+        numpy.ndarray
+            Computed derivative
+
+        Notes
+        -----
+        Derivatives are exact and are computed from the partially wet
+        segments of the cross section. At coordinate elevations derivatives
+        are taken from above.
+
+        """
+
+        props = {
+            'area': cxs.XS_AREA,
+            'top_width': cxs.XS_TOP_WIDTH,
+            'wetted_perimeter': cxs.XS_WETTED_PERIMETER,
+            'hydraulic_depth': cxs.XS_HYDRAULIC_DEPTH,
+            'hydraulic_radius': cxs.XS_HYDRAULIC_RADIUS,
+            'conveyance': cxs.XS_CONVEYANCE,
+            'velocity_coeff': cxs.XS_VELOCITY_COEFF,
+            'critical_flow': cxs.XS_CRITICAL_FLOW
+        }
+
+        if prop not in props:
+            raise ValueError("Unknown property: {}".format(prop))
+
+        cdef int cprop = props[prop]
+
+        y = np.array(y, dtype=np.float64, order='C')
+        d = np.zeros_like(y)
+
+        cdef Py_ssize_t i
+        cdef Py_ssize_t i_max = y.size
+
+        cdef double *y_data = <double *> cnp.PyArray_DATA(y)
+        cdef double *d_data = <double *> cnp.PyArray_DATA(d)
+
+        cdef cxs.XSPValues xsp
+        cdef cxs.XSPValues dxsp
+
+        for i in range(i_max):
+            cxs.xs_hydraulic_properties_deriv(self.xs, y_data[i], &xsp, &dxsp)
+            d_data[i] = dxsp.values[cprop]
+
+        if np.ndim(d) > 0:
+            return d
+        else:
+            return d_data[0]
+
     def hydraulic_depth(self, y):
         """hydrauilc_depth(y)
 
@@ -355,16 +449,13 @@ cdef class CrossSection:
             raise ValueError("slope must be a float")
 
         cdef double cy0
-        cdef cxs.CoArray ca
         cdef double y_min
         cdef double y_max
 
         if y0 is None:
-            ca = cxs.xs_coarray(self.xs)
-            y_min = cxs.coarray_min_y(ca)
-            y_max = cxs.coarray_max_y(ca)
+            y_min = cxs.xs_min_y(self.xs)
+            y_max = cxs.xs_max_y(self.xs)
             cy0 = 0.75 * (y_max - y_min) + y_min
-            cxs.coarray_free(ca)
         else:
             if not pyfloat.PyFloat_Check(y0):
                 raise ValueError("y0 must be a float")
@@ -422,17 +513,11 @@ cdef class CrossSection:
         cdef double *y_data = <double *> cnp.PyArray_DATA(y)
         cdef double *qn_data = <double *> cnp.PyArray_DATA(normal_flow)
 
-        cdef cxs.CrossSectionProps xsp
-        cdef double conveyance
+        cdef cxs.XSPValues xsp
 
         for i in range(i_max):
-            if not isfinite(y_data[i]):
-                qn_data[i] = NAN
-            else:
-                xsp = cxs.xs_hydraulic_properties(self.xs, y_data[i])
-                conveyance = cxs.xsp_get(xsp, cxs.XS_CONVEYANCE)
-                cxs.xsp_free(xsp)
-                qn_data[i] = conveyance * sqrt_s
+            cxs.xs_hydraulic_properties_into(self.xs, y_data[i], &xsp)
+            qn_data[i] = xsp.values[<int> cxs.XS_CONVEYANCE] * sqrt_s
 
         if np.ndim(normal_flow) > 0:
             return normal_flow
@@ -469,22 +554,15 @@ cdef class CrossSection:
         ax.plot(z_coord, y_coord, 'k', marker='.', label='Coordinates')
 
         cdef double cy
-        cdef double min_y
-        cdef cxs.CoArray ca
 
         if y is not None:
             y = float(y)
 
-            ca = cxs.xs_coarray(self.xs)
-            min_y = cxs.coarray_min_y(ca)
-
             cy = pyfloat.PyFloat_AsDouble(y)
 
-            if cy > min_y:
+            if cy > cxs.xs_min_y(self.xs):
                 self._plot_tw_wp(cy, ax)
 
-            cxs.coarray_free(ca)
-
         ax.set_xlabel('z')
         ax.set_ylabel('y')
 
@@ -525,7 +603,7 @@ cdef class CrossSection:
         cdef double alpha
         cdef double area
         cdef double gravity = constants.const_gravity()
-        cdef cxs.CrossSectionProps xsp
+        cdef cxs.XSPValues xsp
 
         cdef double *y_data = <double *> cnp.PyArray_DATA(y)
         cdef double *e_data = <double *> cnp.PyArray_DATA(specific_energy)
@@ -534,10 +612,9 @@ cdef class CrossSection:
             if not isfinite(y_data[i]):
                 e_data[i] = NAN
             else:
-                xsp = cxs.xs_hydraulic_properties(self.xs, y_data[i])
-                alpha = cxs.xsp_get(xsp, cxs.XS_VELOCITY_COEFF)
-                area = cxs.xsp_get(xsp, cxs.XS_AREA)
-                cxs.xsp_free(xsp)
+                cxs.xs_hydraulic_properties_into(self.xs, y_data[i], &xsp)
+                alpha = xsp.values[<int> cxs.XS_VELOCITY_COEFF]
+                area = xsp.values[<int> cxs.XS_AREA]
                 e_data[i] = \
                     y_data[i] + alpha * cq * cq / (2 * gravity * area * area)
 
@@ -602,3 +679,34 @@ cdef class CrossSection:
         """
 
         return self._property(y, cxs.XS_WETTED_PERIMETER)
+
+    def with_roughness(self, roughness):
+        """with_roughness(roughness)
+
+        Creates a cross section with the coordinates of this cross
+        section and a different roughness. The geometry of this cross
+        section is shared rather than recomputed, which makes sweeps
+        over many roughness values inexpensive.
+
+        Parameters
+        ----------
+        roughness : float
+            Manning coefficient for the new cross section
+
+        Returns
+        -------
+        CrossSection
+            New cross section
+
+        """
+
+        roughness = float(roughness)
+        if not roughness > 0:
+            raise ValueError("roughness must be greater than 0")
+
+        cdef double n = roughness
+        cdef CrossSection xs = CrossSection.__new__(CrossSection)
+
+        xs.xs = cxs.xs_with_roughness(self.xs, &n)
+
+        return xs
@@ -2,3 +2,4 @@
 
 include "constants.pyx"
 include "crosssection.pyx"
+include "reachsolver.pyx"
@@ -1,6 +1,6 @@
 import numpy as np
 
-from pantherapy.panthera import Constants
+from pantherapy.panthera import Constants, ReachSolver
 
 
 class ReachNode:
@@ -38,6 +38,32 @@ class ReachNode:
         conveyance = self.xs.conveyance(depth)
         return q**2 / conveyance**2
 
+    def friction_slope_derivative(self, y, q):
+        """Computes the derivative of friction slope
+
+        Computes the derivative of the friction slope with respect to
+        water surface elevation for this node for water surface elevation
+        `y` and flow `q`.
+
+        Parameters
+        ----------
+        y : float
+            Water surface elevation
+        q : float
+            Flow
+
+        Returns
+        -------
+        float
+            Derivative of friction slope
+
+        """
+
+        depth = y - self.y
+        conveyance = self.xs.conveyance(depth)
+        d_conveyance = self.xs.derivative(depth, 'conveyance')
+        return -2 * q**2 * d_conveyance / conveyance**3
+
     def velocity(self, y, q):
         """Computes mean velocity
 
@@ -87,6 +113,36 @@ class ReachNode:
         velocity_coeff = self.xs.velocity_coeff(depth)
         return velocity_coeff * velocity**2 / (2 * Constants.gravity())
 
+    def velocity_head_derivative(self, y, q):
+        """Computes the derivative of velocity head
+
+        Computes the derivative of the velocity head with respect to water
+        surface elevation for this node for water surface elevation `y` and
+        flow `q`.
+
+        Parameters
+        ----------
+        y : float
+            Water surface elevation
+        q : float
+            Flow
+
+        Returns
+        -------
+        float
+            Derivative of velocity head
+
+        """
+
+        depth = y - self.y
+        area = self.xs.area(depth)
+        top_width = self.xs.top_width(depth)
+        velocity_coeff = self.xs.velocity_coeff(depth)
+        d_velocity_coeff = self.xs.derivative(depth, 'velocity_coeff')
+        return q**2 / (2 * Constants.gravity()) * \
+            (d_velocity_coeff / area**2 -
+             2 * velocity_coeff * top_width / area**3)
+
 
 class Reach:
     """Stream reach
@@ -97,6 +153,7 @@ class Reach:
 
         self._nodes = {}
         self._array = None
+        self._solver = None
 
     def __len__(self):
 
@@ -110,6 +167,51 @@ class Reach:
         node_array = np.array(list(self._nodes.values()))
         self._array = node_array[x_sort_idx]
 
+    def _build_solver(self):
+
+        if self._array is None:
+            self._build_array()
+
+        self._solver = ReachSolver(
+            [node.x for node in self._array],
+            [node.y for node in self._array],
+            [node.xs for node in self._array])
+
+    def boundary_value(self, wse_0, q_0):
+        """Computes a water surface profile and discharge from the water
+        surface elevations at both ends of the reach
+
+        The energy equations between all nodes are solved together with
+        Newton's method in C. The cross sections of the nodes must be
+        :class:`~pantherapy.panthera.CrossSection` instances.
+
+        Parameters
+        ----------
+        wse_0 : array_like
+            Initial estimate of the water surface elevation at each node. The
+            first and last values are the known water surface elevations at
+            the upstream and downstream ends of the reach.
+        q_0 : float
+            Initial estimate of the discharge
+
+        Returns
+        -------
+        wse : numpy.ndarray
+            Water surface elevation at each node
+        discharge : float
+            Discharge through the reach
+        converged : bool
+            True if a solution was found
+        n_iterations : int
+            Number of Newton iterations
+
+        """
+
+        if self._solver is None:
+            self._build_solver()
+
+        return self._solver.boundary_value(wse_0, q_0)
+
     def energy_diff(self, yj, qj, j, yi, qi, i):
         """Specific energy difference between nodes
 
@@ -150,6 +252,84 @@ class Reach:
 
         return (yj + hvj) - (yi + hvi) + head_loss
 
+    def energy_diff_derivative(self, yj, qj, j, yi, qi, i):
+        """Derivatives of specific energy difference between nodes
+
+        Computes the derivatives of :meth:`energy_diff` with respect to the
+        water surface elevations at node j and node i.
+
+        Parameters
+        ----------
+        yj : float
+            Water surface elevation at node j
+        qj : float
+            Flow at node j
+        j : int
+            Index of node j
+        yi : float
+            Water surface elevation at node i
+        qi : float
+            Flow at node i
+        i : int
+            Index of node i
+
+        Returns
+        -------
+        float, float
+            Derivatives with respect to `yj` and `yi`
+
+        """
+
+        if self._array is None:
+            self._build_array()
+
+        node_i = self._array[i]
+        node_j = self._array[j]
+
+        dx = node_j.x - node_i.x
+
+        d_yj = 1 + node_j.velocity_head_derivative(yj, qj) + \
+            dx / 2 * node_j.friction_slope_derivative(yj, qj)
+        d_yi = -1 - node_i.velocity_head_derivative(yi, qi) + \
+            dx / 2 * node_i.friction_slope_derivative(yi, qi)
+
+        return d_yj, d_yi
+
+    def energy_residuals(self, wse, flow):
+        """Computes the residuals of the energy equations between all
+        consecutive nodes and their derivatives with respect to the water
+        surface elevations
+
+        The properties of each node are evaluated once in C. The cross
+        sections of the nodes must be
+        :class:`~pantherapy.panthera.CrossSection` instances.
+
+        Parameters
+        ----------
+        wse : array_like
+            Water surface elevation at each node
+        flow : array_like
+            Flow at each node
+
+        Returns
+        -------
+        residual : numpy.ndarray
+            Energy equation residual between each node and the next node
+            downstream
+        dres_dwse_lo : numpy.ndarray
+            Derivative of each residual with respect to the upstream water
+            surface elevation
+        dres_dwse_hi : numpy.ndarray
+            Derivative of each residual with respect to the downstream water
+            surface elevation
+
+        """
+
+        if self._solver is None:
+            self._build_solver()
+
+        return self._solver.energy_residuals(wse, flow)
+
     def friction_slope(self, i, h, q):
         """Computes the friction slope at a node
 
@@ -194,6 +374,37 @@ class Reach:
 
         return self._array[i].x
 
+    def node_properties(self, wse, flow, n_threads=1):
+        """Computes hydraulic properties at every node
+
+        The properties of all nodes are computed in one call in C. The cross
+        sections of the nodes must be
+        :class:`~pantherapy.panthera.CrossSection` instances.
+
+        Parameters
+        ----------
+        wse : array_like
+            Water surface elevation at each node
+        flow : array_like
+            Flow at each node
+        n_threads : int, optional
+            Maximum number of threads to use. The default is 1.
+
+        Returns
+        -------
+        dict
+            Arrays of the velocity, friction slope, velocity head, area, top
+            width, and Froude number at each node, with keys 'velocity',
+            'friction_slope', 'velocity_head', 'area', 'top_width', and
+            'froude'
+
+        """
+
+        if self._solver is None:
+            self._build_solver()
+
+        return self._solver.node_properties(wse, flow, n_threads)
+
     def put(self, xs, x, y=0):
         """Puts a node in the reach
 
@@ -211,6 +422,73 @@ class Reach:
         node = ReachNode(x, y, xs)
         self._nodes[x] = node
         self._array = None
+        self._solver = None
+
+    def simultaneous(self, flow, wse_bc):
+        """Computes a water surface profile with the simultaneous method
+
+        The energy equations between all nodes are solved together with
+        Newton's method in C, starting from the depth of the downstream
+        boundary condition at every node. The cross sections of the nodes
+        must be :class:`~pantherapy.panthera.CrossSection` instances.
+
+        Parameters
+        ----------
+        flow : array_like
+            Flow at each node
+        wse_bc : float
+            Water surface elevation at the most downstream node
+
+        Returns
+        -------
+        wse : numpy.ndarray
+            Water surface elevation at each node
+        converged : bool
+            True if a solution was found
+        n_iterations : int
+            Number of Newton iterations
+        residual : float
+            Largest absolute energy residual of the last iteration
+
+        """
+
+        if self._solver is None:
+            self._build_solver()
+
+        return self._solver.simultaneous(flow, wse_bc)
+
+    def standard_step(self, flow, wse_bc, boundary_location):
+        """Computes a water surface profile with the standard step method
+
+        The profile is computed in C. A subcritical profile is computed
+        upstream from a downstream boundary condition and a supercritical
+        profile is computed downstream from an upstream boundary condition.
+        The cross sections of the nodes must be
+        :class:`~pantherapy.panthera.CrossSection` instances.
+
+        Parameters
+        ----------
+        flow : array_like
+            Flow at each node
+        wse_bc : float
+            Water surface elevation boundary condition
+        boundary_location : {'upstream', 'downstream'}
+            Boundary condition location
+
+        Returns
+        -------
+        wse : numpy.ndarray
+            Water surface elevation at each node, NaN at nodes after a node
+            where no solution is found
+        converged : numpy.ndarray
+            True where a solution was found at a node
+
+        """
+
+        if self._solver is None:
+            self._build_solver()
+
+        return self._solver.standard_step(flow, wse_bc, boundary_location)
 
     def stream_distance(self):
         """Returns the stream distance of each node
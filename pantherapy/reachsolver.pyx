@@ -0,0 +1,354 @@
+#  cython : language_level=3
+
+from libc.stdlib cimport malloc, free
+
+cimport pantherapy.ccrosssection as cxs
+cimport pantherapy.creach as creach
+
+cdef class ReachSolver:
+    """ReachSolver(stream_distance, thalweg, xs) -> new ReachSolver
+
+    Steady flow solvers for a reach
+
+    Parameters
+    ----------
+    stream_distance : array_like
+        Distance downstream of each node
+    thalweg : array_like
+        Thalweg elevation of each node
+    xs : sequence of CrossSection
+        Cross section of each node
+
+    """
+
+    cdef creach.Reach reach
+    cdef list _xs
+
+    def __cinit__(self):
+        self.reach = creach.reach_new()
+
+    def __init__(self, stream_distance, thalweg, xs):
+
+        stream_distance = np.ascontiguousarray(
+            stream_distance, dtype=np.float64)
+        thalweg = np.ascontiguousarray(thalweg, dtype=np.float64)
+        xs = list(xs)
+
+        if np.ndim(stream_distance) != 1 or np.ndim(thalweg) != 1:
+            raise ValueError(
+                "stream_distance and thalweg must be one-dimensional")
+        if not stream_distance.size == thalweg.size == len(xs):
+            raise ValueError(
+                "stream_distance, thalweg, and xs must be the same size")
+
+        # the C reach references the cross sections without owning them
+        self._xs = xs
+
+        cdef Py_ssize_t i
+        cdef Py_ssize_t n = len(xs)
+        cdef CrossSection node_xs
+
+        if n == 0:
+            return
+
+        cdef cxs.CrossSection *xs_data = \
+            <cxs.CrossSection *> malloc(n * sizeof(cxs.CrossSection))
+        if xs_data == NULL:
+            raise MemoryError()
+
+        try:
+            for i in range(n):
+                node_xs = xs[i]
+                xs_data[i] = node_xs.xs
+        except TypeError:
+            free(xs_data)
+            raise
+
+        creach.reach_put_xs_many(
+            self.reach,
+            n,
+            <double *> cnp.PyArray_DATA(stream_distance),
+            <double *> cnp.PyArray_DATA(thalweg),
+            xs_data)
+
+        free(xs_data)
+
+    def __dealloc__(self):
+        creach.reach_free(self.reach)
+
+    def __len__(self):
+        return creach.reach_size(self.reach)
+
+    def boundary_value(self, wse_0, q_0):
+        """boundary_value(wse_0, q_0)
+
+        Computes a water surface profile and discharge from the water surface
+        elevations at both ends of the reach
+
+        The energy equations between all nodes are solved together with
+        Newton's method for the water surface elevations between the ends of
+        the reach and the discharge, which is the same at every node.
+
+        Parameters
+        ----------
+        wse_0 : array_like
+            Initial estimate of the water surface elevation at each node. The
+            first and last values are the known water surface elevations at
+            the upstream and downstream ends of the reach.
+        q_0 : float
+            Initial estimate of the discharge
+
+        Returns
+        -------
+        wse : numpy.ndarray
+            Water surface elevation at each node
+        discharge : float
+            Discharge through the reach
+        converged : bool
+            True if a solution was found
+        n_iterations : int
+            Number of Newton iterations
+
+        """
+
+        cdef Py_ssize_t n = creach.reach_size(self.reach)
+
+        if n < 2:
+            raise ValueError("Reach must have at least two nodes")
+
+        wse = np.array(wse_0, dtype=np.float64)
+        if wse.shape != (n, ):
+            raise ValueError(
+                "Initial wse estimate must be the same length as reach")
+
+        cdef double *wse_data = <double *> cnp.PyArray_DATA(wse)
+        cdef double q = q_0
+        cdef cxs.XSSolveInfo info
+
+        creach.reach_boundary_value(self.reach, wse_data, &q, &info)
+
+        return wse, q, info.converged != 0, info.n_iterations
+
+    def energy_residuals(self, wse, flow):
+        """energy_residuals(wse, flow)
+
+        Computes the residuals of the energy equations between all
+        consecutive nodes and their derivatives with respect to the water
+        surface elevations
+
+        The properties of each node are evaluated once.
+
+        Parameters
+        ----------
+        wse : array_like
+            Water surface elevation at each node
+        flow : array_like
+            Flow at each node
+
+        Returns
+        -------
+        residual : numpy.ndarray
+            Energy equation residual between each node and the next node
+            downstream
+        dres_dwse_lo : numpy.ndarray
+            Derivative of each residual with respect to the upstream water
+            surface elevation
+        dres_dwse_hi : numpy.ndarray
+            Derivative of each residual with respect to the downstream water
+            surface elevation
+
+        """
+
+        cdef Py_ssize_t n = creach.reach_size(self.reach)
+        cdef Py_ssize_t n_res = n - 1 if n > 0 else 0
+
+        wse = np.ascontiguousarray(
+            np.broadcast_to(wse, (n, )), dtype=np.float64)
+        flow = np.ascontiguousarray(
+            np.broadcast_to(flow, (n, )), dtype=np.float64)
+        residual = np.empty(n_res, dtype=np.float64)
+        dres_dwse_lo = np.empty(n_res, dtype=np.float64)
+        dres_dwse_hi = np.empty(n_res, dtype=np.float64)
+
+        if n_res == 0:
+            return residual, dres_dwse_lo, dres_dwse_hi
+
+        creach.reach_energy_residuals(
+            self.reach,
+            <double *> cnp.PyArray_DATA(wse),
+            <double *> cnp.PyArray_DATA(flow),
+            <double *> cnp.PyArray_DATA(residual),
+            <double *> cnp.PyArray_DATA(dres_dwse_lo),
+            <double *> cnp.PyArray_DATA(dres_dwse_hi))
+
+        return residual, dres_dwse_lo, dres_dwse_hi
+
+    def node_properties(self, wse, flow, n_threads=1):
+        """node_properties(wse, flow, n_threads=1)
+
+        Computes hydraulic properties at every node
+
+        Parameters
+        ----------
+        wse : array_like
+            Water surface elevation at each node
+        flow : array_like
+            Flow at each node
+        n_threads : int, optional
+            Maximum number of threads to use. The default is 1.
+
+        Returns
+        -------
+        dict
+            Arrays of the velocity, friction slope, velocity head, area, top
+            width, and Froude number at each node, with keys 'velocity',
+            'friction_slope', 'velocity_head', 'area', 'top_width', and
+            'froude'
+
+        """
+
+        cdef Py_ssize_t n = creach.reach_size(self.reach)
+
+        wse = np.ascontiguousarray(
+            np.broadcast_to(wse, (n, )), dtype=np.float64)
+        flow = np.ascontiguousarray(
+            np.broadcast_to(flow, (n, )), dtype=np.float64)
+
+        names = ('velocity', 'friction_slope', 'velocity_head', 'area',
+                 'top_width', 'froude')
+        props = {name: np.empty(n, dtype=np.float64) for name in names}
+
+        if n == 0:
+            return props
+
+        cdef creach.RNPArrays out
+        out.velocity = <double *> cnp.PyArray_DATA(props['velocity'])
+        out.friction_slope = \
+            <double *> cnp.PyArray_DATA(props['friction_slope'])
+        out.velocity_head = \
+            <double *> cnp.PyArray_DATA(props['velocity_head'])
+        out.area = <double *> cnp.PyArray_DATA(props['area'])
+        out.top_width = <double *> cnp.PyArray_DATA(props['top_width'])
+        out.froude = <double *> cnp.PyArray_DATA(props['froude'])
+
+        creach.reach_rnp_many(
+            self.reach,
+            <double *> cnp.PyArray_DATA(wse),
+            <double *> cnp.PyArray_DATA(flow),
+            &out,
+            n_threads)
+
+        return props
+
+    def simultaneous(self, flow, wse_bc):
+        """simultaneous(flow, wse_bc)
+
+        Computes a water surface profile with the simultaneous solution method
+
+        The energy equations between all nodes are solved with Newton's
+        method, starting from the depth of the downstream boundary condition
+        at every node.
+
+        Parameters
+        ----------
+        flow : array_like
+            Flow at each node
+        wse_bc : float
+            Water surface elevation at the most downstream node
+
+        Returns
+        -------
+        wse : numpy.ndarray
+            Water surface elevation at each node
+        converged : bool
+            True if a solution was found
+        n_iterations : int
+            Number of Newton iterations
+        residual : float
+            Largest absolute energy residual of the last iteration
+
+        """
+
+        cdef Py_ssize_t n = creach.reach_size(self.reach)
+
+        flow = np.ascontiguousarray(
+            np.broadcast_to(flow, (n, )), dtype=np.float64)
+        wse = np.empty(n, dtype=np.float64)
+
+        if n == 0:
+            return wse, True, 0, 0.0
+
+        cdef double *flow_data = <double *> cnp.PyArray_DATA(flow)
+        cdef double *wse_data = <double *> cnp.PyArray_DATA(wse)
+        cdef cxs.XSSolveInfo info
+
+        creach.reach_simultaneous(
+            self.reach, flow_data, wse_bc, wse_data, &info)
+
+        return wse, info.converged != 0, info.n_iterations, info.residual
+
+    def standard_step(self, flow, wse_bc, boundary_location):
+        """standard_step(flow, wse_bc, boundary_location)
+
+        Computes a water surface profile with the standard step method
+
+        A subcritical profile is computed upstream from a downstream boundary
+        condition and a supercritical profile is computed downstream from an
+        upstream boundary condition. If no solution is found at a node, the
+        water surface elevation of that node and of the remaining nodes is
+        NaN.
+
+        Parameters
+        ----------
+        flow : array_like
+            Flow at each node
+        wse_bc : float
+            Water surface elevation boundary condition
+        boundary_location : {'upstream', 'downstream'}
+            Boundary condition location
+
+        Returns
+        -------
+        wse : numpy.ndarray
+            Water surface elevation at each node
+        converged : numpy.ndarray
+            True where a solution was found at a node
+
+        """
+
+        cdef Py_ssize_t n = creach.reach_size(self.reach)
+        cdef creach.reach_boundary bc
+
+        if boundary_location == 'downstream':
+            bc = creach.REACH_DOWNSTREAM
+        elif boundary_location == 'upstream':
+            bc = creach.REACH_UPSTREAM
+        else:
+            raise ValueError(
+                "Invalid boundary location: {}".format(boundary_location))
+
+        flow = np.ascontiguousarray(
+            np.broadcast_to(flow, (n, )), dtype=np.float64)
+        wse = np.empty(n, dtype=np.float64)
+        converged = np.zeros(n, dtype=bool)
+
+        if n == 0:
+            return wse, converged
+
+        cdef double *flow_data = <double *> cnp.PyArray_DATA(flow)
+        cdef double *wse_data = <double *> cnp.PyArray_DATA(wse)
+        cdef cxs.XSSolveInfo *info = \
+            <cxs.XSSolveInfo *> malloc(n * sizeof(cxs.XSSolveInfo))
+        if info == NULL:
+            raise MemoryError()
+
+        creach.reach_standard_step(
+            self.reach, flow_data, wse_bc, bc, wse_data, info)
+
+        cdef Py_ssize_t i
+        for i in range(n):
+            converged[i] = info[i].converged != 0
+
+        free(info)
+
+        return wse, converged
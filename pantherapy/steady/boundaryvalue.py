@@ -27,51 +27,39 @@ class BoundaryValuePlan:
         self._reach = reach
 
     def solve(self, wse_0, q_0):
+        """Solve the plan
+
+        Parameters
+        ----------
+        wse_0 : array_like
+            Initial estimate of the water surface elevation at each node. The
+            first and last values are the known water surface elevations at
+            the upstream and downstream ends of the reach.
+        q_0 : float
+            Initial estimate of the discharge
+
+        Returns
+        -------
+        BoundaryValueSolution
+
+        """
 
         if len(wse_0) != len(self._reach):
             raise ValueError(
                 "Initial wse estimate must be the same length as reach")
 
-        # number of unknown water surface elevations
-        n = len(self._reach) - 2
+        wse, discharge, converged, n_iterations = \
+            self._reach.boundary_value(wse_0, q_0)
+
+        if not converged:
+            raise RuntimeError(
+                "Number of iterations exceeded without finding solution")
 
-        # vector of unknowns
-        x = np.ones((n + 1, ))
-        x[:-1] = wse_0[1:-1]
-        x[-1] = q_0
-
-        b = np.zeros_like(x)
-        b[0] = wse_0[0]
-        b[-2] = wse_0[-1]
-
-        h_tol = 0.001
-        q_tol = 0.01
-        tol = np.zeros_like(x)
-        tol[:-1] = h_tol
-        tol[-1] = q_tol
-
-        max_iter = 20
-
-        solver = BoundaryValueSolver(self._reach)
-
-        for i in range(max_iter):
-            dx = solver.solve_iteration(x, b)
-            x = x + dx
-            if np.any(np.isnan(x)):
-                break
-            if np.all(np.abs(dx) < tol):
-                break
-
-        wse = np.zeros_like(wse_0)
-        wse[0] = wse_0[0]
-        wse[-1] = wse_0[-1]
-        wse[1:-1] = x[:-1]
-        discharge = x[-1]
         stream_distance = self._reach.stream_distance()
         thalweg = self._reach.thalweg()
 
         return BoundaryValueSolution(
-            stream_distance, thalweg, wse, discharge, i)
+            stream_distance, thalweg, wse, discharge, n_iterations)
 
 
 class BoundaryValueSolution(SteadySolution):
@@ -35,71 +35,40 @@ class InitialValuePlan:
         self._bc_loc = boundary_location
         self._bc = boundary_condition
 
-    def _simultaneous(self, eps=0.001, iter=20):
+    def _simultaneous(self):
 
         if self._bc_loc == 'upstream':
             raise NotImplementedError(
                 "Upstream boundary condition not implemented for " +
                 "simultaneous solution")
 
-        thalweg = self._reach.thalweg()
-        bc_index = -1
-        bc_x = self._reach.node_location(bc_index)
-        bc_flow = self._flow_data.flow(bc_x)
-        bc_elevation = self._bc.stage(bc_flow)
-        bc_depth = bc_elevation - thalweg[bc_index]
-        y = bc_depth + thalweg
-
-        solver = SimultaneousSolver(self._reach, self._flow_data, bc_elevation)
-
-        i = 0
-        while i < iter:
-
-            i = i + 1
-
-            dy = solver.solve_iteration(y)
-            y = y + dy
+        stream_distance = self._reach.stream_distance()
+        flow = self._flow_data.flow(stream_distance)
+        bc_elevation = self._bc.stage(flow[-1])
 
-            if (np.abs(dy[:-1])).max() < eps:
-                break
+        wse, converged, _, _ = self._reach.simultaneous(flow, bc_elevation)
 
-        if i == iter:
+        if not converged:
             raise RuntimeError(
                 "Number of iterations exceeded without finding solution")
 
-        return SteadySolution(self._reach.stream_distance(), thalweg, y)
+        return SteadySolution(stream_distance, self._reach.thalweg(), wse)
 
     def _sstep(self):
 
-        solver = StandardStepSolver(self._reach, self._flow_data)
-
         if self._bc_loc == 'downstream':
-            first_index = len(self._reach) - 1
-            last_index = -1
-            direction = -1
+            bc_index = -1
         elif self._bc_loc == 'upstream':
-            first_index = 0
-            last_index = len(self._reach)
-            direction = 1
+            bc_index = 0
         else:
             raise ValueError(
                 "Invalid boundary location: {}".format(self._bc_loc))
 
-        node_range = np.arange(first_index + direction, last_index, direction)
-
         stream_distance = self._reach.stream_distance()
+        flow = self._flow_data.flow(stream_distance)
 
-        wse = np.zeros_like(stream_distance)
-        wse[:] = np.nan
-
-        wse[first_index] = self._bc.stage(
-            self._flow_data.flow(
-                stream_distance[first_index]))
-
-        for i, j in zip(node_range, node_range - direction):
-            wse[i] = solver.solve_node(i, j, wse[j])
-            if np.isnan(wse[i]):
-                break
+        wse_bc = self._bc.stage(flow[bc_index])
+        wse, _ = self._reach.standard_step(flow, wse_bc, self._bc_loc)
 
         return SteadySolution(
             stream_distance, self._reach.thalweg(), wse)
@@ -135,22 +104,15 @@ class SimultaneousSolver:
     flow_data : SteadyFlow
     y_d : float
         Downstream water surface elevation
-    dy : float, optional
-        Elevation difference for estimating minimization function derivative
 
     """
 
-    def __init__(self, reach, flow_data, y_d, dy=0.01):
+    def __init__(self, reach, flow_data, y_d):
 
         self._reach = reach
         self._flow = flow_data.flow(reach.stream_distance())
         self._y_d = y_d
 
-        if dy > 0:
-            self._dy = dy
-        else:
-            raise ValueError("dy must be greater than zero")
-
     def _f(self, wse, i):
 
         return self._reach.energy_diff(
@@ -158,20 +120,13 @@ class SimultaneousSolver:
 
     def _f_prime(self, wse, i, j):
 
-        delta_y = np.array([-self._dy / 2, self._dy / 2])
+        df_dyj, df_dyi = self._reach.energy_diff_derivative(
+            wse[i + 1], self._flow[i + 1], i + 1, wse[i], self._flow[i], i)
 
         if i == j:
-            y_i = wse[i] + delta_y
-            y_j = wse[i + 1]
+            return df_dyi
         else:
-            y_i = wse[i]
-            y_j = wse[j] + delta_y
-
-        f = self._reach.energy_diff(
-            y_j, self._flow[j], j, y_i, self._flow[i], i)
-        df = f[1] - f[0]
-
-        return df / self._dy
+            return df_dyj
 
     def solve_iteration(self, wse):
         """Solve an iteration of the simultaneous solution method
@@ -38,7 +38,8 @@ pantherapy_src = ['pantherapy/panthera' + ext]
 pantherapy_src.extend(panthera_src)
 pantherapy_ext = Extension('pantherapy.panthera',
                            sources=pantherapy_src,
-                           include_dirs=[panthera_inc]
+                           include_dirs=[panthera_inc],
+                           libraries=[] if os.name == 'nt' else ['pthread']
                            )
 
 if use_cython:
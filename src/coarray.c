@@ -1,89 +1,143 @@
-#include "list.h"
+#include "coarray.h"
 #include "mem.h"
 #include <assert.h>
+#include <limits.h>
 #include <math.h>
 #include <panthera/crosssection.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <string.h>
 
 struct CoArray {
-    int         length;      /* number of coordinates in this array */
-    double      max_y;       /* maximum y in coarray */
-    double      min_y;       /* minimum y in coarray */
-    Coordinate *coordinates; /* array of coordinates */
+    int            length;    /* number of coordinates in this array */
+    double         max_y;     /* maximum y in coarray */
+    double         min_y;     /* minimum y in coarray */
+    double *       y;         /* array of vertical values */
+    double *       z;         /* array of lateral values */
+    unsigned char *gaps;      /* bit mask of NULL coordinates, NULL if none */
+    CoArray        parent;    /* array whose values are viewed, NULL if the
+                                 values are owned */
+    int            ref_count; /* number of references, including views */
 };
 
-static void
-check_z_coordinates(int n, Coordinate *coordinates, const char *file, int line)
+static bool
+coarray_is_gap(CoArray a, int i)
 {
-    assert(coordinates);
+    return a->gaps && (a->gaps[i / CHAR_BIT] >> (i % CHAR_BIT)) & 1;
+}
 
-    for (int i = 1; i < n; i++) {
-        assert((*(coordinates + i - 1))->z <= (*(coordinates + i))->z);
-    }
+/* marks the i-th coordinate of a as NULL */
+static void
+coarray_set_gap(CoArray a, int i)
+{
+    if (!a->gaps)
+        a->gaps = mem_calloc(
+            (a->length + CHAR_BIT - 1) / CHAR_BIT, 1, __FILE__, __LINE__);
+    a->gaps[i / CHAR_BIT] |= 1 << (i % CHAR_BIT);
+    a->y[i] = NAN;
+    a->z[i] = NAN;
 }
 
-CoArray
-coarray_new(int n, double *y, double *z)
+/* allocates a coordinate array of length n with uninitialized values */
+static CoArray
+coarray_alloc(int n)
 {
-    assert(y);
-    assert(z);
+    assert(n >= 0);
 
-    double  max_y = -INFINITY;
-    double  min_y = INFINITY;
     CoArray a;
     NEW(a);
 
-    a->length      = n;
-    a->coordinates = mem_calloc(n, sizeof(Coordinate), __FILE__, __LINE__);
+    a->length    = n;
+    a->max_y     = -INFINITY;
+    a->min_y     = INFINITY;
+    a->gaps      = NULL;
+    a->parent    = NULL;
+    a->ref_count = 1;
 
-    int i;
-    for (i = 0; i < n; i++) {
-        *(a->coordinates + i) = coord_new(*(y + i), *(z + i));
-        if (*(y + i) > max_y)
-            max_y = *(y + i);
-        if (*(y + i) < min_y)
-            min_y = *(y + i);
+    if (n > 0) {
+        a->y = mem_calloc(n, sizeof(double), __FILE__, __LINE__);
+        a->z = mem_calloc(n, sizeof(double), __FILE__, __LINE__);
+    } else {
+        a->y = NULL;
+        a->z = NULL;
+    }
+
+    return a;
+}
+
+/* sets the minimum and maximum y of a from its non-NULL coordinates */
+static void
+coarray_set_bounds(CoArray a)
+{
+    double max_y = -INFINITY;
+    double min_y = INFINITY;
+
+    for (int i = 0; i < a->length; i++) {
+        if (coarray_is_gap(a, i))
+            continue;
+        if (a->y[i] > max_y)
+            max_y = a->y[i];
+        if (a->y[i] < min_y)
+            min_y = a->y[i];
     }
+
     a->max_y = max_y;
     a->min_y = min_y;
+}
 
-    check_z_coordinates(n, a->coordinates, __FILE__, __LINE__);
+static void
+check_z_coordinates(CoArray a)
+{
+    for (int i = 1; i < a->length; i++) {
+        assert(a->z[i - 1] <= a->z[i]);
+    }
+}
+
+CoArray
+coarray_new(int n, double *y, double *z)
+{
+    assert(y);
+    assert(z);
+
+    CoArray a = coarray_alloc(n);
+
+    memcpy(a->y, y, n * sizeof(double));
+    memcpy(a->z, z, n * sizeof(double));
+    coarray_set_bounds(a);
+
+    check_z_coordinates(a);
 
     return a;
 }
 
-static CoArray
-coarray_from_array(int n, Coordinate *array)
+CoArray
+coarray_new_adopt(int n, double *y, double *z)
 {
-    assert(array);
+    assert(n >= 0);
+    assert(n == 0 || (y && z));
 
-    CoArray     a;
-    Coordinate *coordinates;
-    double      max_y = -INFINITY;
-    double      min_y = INFINITY;
+    CoArray a;
+    NEW(a);
 
-    Coordinate c;
+    a->length    = n;
+    a->y         = y;
+    a->z         = z;
+    a->gaps      = NULL;
+    a->parent    = NULL;
+    a->ref_count = 1;
+    coarray_set_bounds(a);
 
-    if (n > 0) {
-        coordinates = mem_calloc(n, sizeof(Coordinate), __FILE__, __LINE__);
-        for (int i = 0; i < n; i++) {
-            c                  = *(array + i);
-            *(coordinates + i) = c;
-            if (c) {
-                if (c->y > max_y)
-                    max_y = c->y;
-                if (c->y < min_y)
-                    min_y = c->y;
-            }
-        }
-    } else
-        coordinates = NULL;
+    check_z_coordinates(a);
 
-    NEW(a);
-    a->coordinates = coordinates;
-    a->length      = n;
-    a->max_y       = max_y;
-    a->min_y       = min_y;
+    return a;
+}
+
+CoArray
+coarray_ref(CoArray a)
+{
+    assert(a);
+
+    a->ref_count++;
 
     return a;
 }
@@ -93,17 +147,22 @@ coarray_copy(CoArray ca)
 {
     assert(ca);
 
-    int n = ca->length;
+    int     n    = ca->length;
+    CoArray copy = coarray_alloc(n);
 
-    Coordinate *coordinates =
-        mem_calloc(n, sizeof(Coordinate), __FILE__, __LINE__);
-    CoArray copy;
+    if (n > 0) {
+        memcpy(copy->y, ca->y, n * sizeof(double));
+        memcpy(copy->z, ca->z, n * sizeof(double));
+    }
 
-    for (int i = 0; i < n; i++)
-        coordinates[i] = coord_copy(ca->coordinates[i]);
+    if (ca->gaps) {
+        copy->gaps = mem_calloc(
+            (n + CHAR_BIT - 1) / CHAR_BIT, 1, __FILE__, __LINE__);
+        memcpy(copy->gaps, ca->gaps, (n + CHAR_BIT - 1) / CHAR_BIT);
+    }
 
-    copy = coarray_from_array(n, coordinates);
-    mem_free(coordinates, __FILE__, __LINE__);
+    copy->max_y = ca->max_y;
+    copy->min_y = ca->min_y;
 
     return copy;
 }
@@ -113,20 +172,13 @@ coarray_add_y(CoArray ca, double add_y)
 {
     assert(ca);
 
-    int     n = ca->length;
-    double *y = mem_calloc(n, sizeof(double), __FILE__, __LINE__);
-    double *z = mem_calloc(n, sizeof(double), __FILE__, __LINE__);
-
-    int i;
-    for (i = 0; i < n; i++) {
-        y[i] = (*(ca->coordinates + i))->y + add_y;
-        z[i] = (*(ca->coordinates + i))->z;
-    }
+    CoArray new_a = coarray_copy(ca);
 
-    CoArray new_a = coarray_new(n, y, z);
+    for (int i = 0; i < new_a->length; i++)
+        new_a->y[i] += add_y;
 
-    mem_free(y, __FILE__, __LINE__);
-    mem_free(z, __FILE__, __LINE__);
+    new_a->max_y += add_y;
+    new_a->min_y += add_y;
 
     return new_a;
 }
@@ -136,14 +188,16 @@ coarray_free(CoArray a)
 {
     assert(a);
 
-    int        i;
-    Coordinate c;
-    for (i = 0; i < a->length; i++) {
-        c = *(a->coordinates + i);
-        coord_free(c);
-    }
+    if (--a->ref_count > 0)
+        return;
 
-    mem_free((void *) a->coordinates, __FILE__, __LINE__);
+    if (a->parent) {
+        coarray_free(a->parent);
+    } else {
+        mem_free(a->y, __FILE__, __LINE__);
+        mem_free(a->z, __FILE__, __LINE__);
+        mem_free(a->gaps, __FILE__, __LINE__);
+    }
 
     FREE(a);
 }
@@ -151,10 +205,6 @@ coarray_free(CoArray a)
 int
 coarray_eq(CoArray a1, CoArray a2)
 {
-
-    Coordinate c1;
-    Coordinate c2;
-
     int i;
 
     if (a1 == a2)
@@ -168,9 +218,11 @@ coarray_eq(CoArray a1, CoArray a2)
         return 1;
 
     for (i = 0; i < a1->length; i++) {
-        c1 = *(a1->coordinates + i);
-        c2 = *(a2->coordinates + i);
-        if (coord_eq(c1, c2) != 0)
+        if (coarray_is_gap(a1, i) != coarray_is_gap(a2, i))
+            return 1;
+        if (coarray_is_gap(a1, i))
+            continue;
+        if (a1->y[i] != a2->y[i] || a1->z[i] != a2->z[i])
             return 1;
     }
 
@@ -198,16 +250,30 @@ coarray_length(CoArray a)
     return a->length;
 }
 
+const double *
+coarray_y(CoArray a)
+{
+    assert(a);
+    return a->y;
+}
+
+const double *
+coarray_z(CoArray a)
+{
+    assert(a);
+    return a->z;
+}
+
 Coordinate
 coarray_get(CoArray a, int i)
 {
     assert(a);
     assert(0 <= i && i < a->length);
 
-    if (a->coordinates[i])
-        return coord_copy(a->coordinates[i]);
-    else
+    if (coarray_is_gap(a, i))
         return NULL;
+    else
+        return coord_new(a->y[i], a->z[i]);
 }
 
 /* find the index of the coordinate with the greatest z value that's less than
@@ -216,15 +282,15 @@ static int
 find_zlo_idx(CoArray a, int lo, int hi, double zlo)
 {
     if (lo == hi) {
-        while (lo > 0 && a->coordinates[lo - 1]->z >= zlo) {
+        while (lo > 0 && a->z[lo - 1] >= zlo) {
             lo--;
         }
-        return a->coordinates[lo]->z <= zlo ? lo : -1;
+        return a->z[lo] <= zlo ? lo : -1;
     }
 
     int mid = (hi + lo) / 2;
 
-    if (zlo < a->coordinates[mid]->z)
+    if (zlo < a->z[mid])
         return find_zlo_idx(a, lo, mid, zlo);
 
     int ret = find_zlo_idx(a, mid + 1, hi, zlo);
@@ -236,15 +302,15 @@ static int
 find_zhi_idx(CoArray a, int n, int lo, int hi, double zhi)
 {
     if (lo == hi) {
-        while (hi < n - 1 && a->coordinates[hi + 1]->z <= zhi) {
+        while (hi < n - 1 && a->z[hi + 1] <= zhi) {
             hi++;
         }
-        return a->coordinates[hi]->z >= zhi ? hi : -1;
+        return a->z[hi] >= zhi ? hi : -1;
     }
 
     int mid = (hi + lo) / 2;
 
-    if (zhi <= a->coordinates[mid]->z)
+    if (zhi <= a->z[mid])
         return find_zhi_idx(a, n, lo, mid, zhi);
 
     int ret = find_zhi_idx(a, n, mid + 1, hi, zhi);
@@ -259,113 +325,164 @@ coarray_subarray_y(CoArray a, double y)
 
     int n = a->length;
 
-    /* subarray to return */
-    int         sa_length;
-    List        list = list_new();
-    CoArray     sa;
-    Coordinate *coordinates;
+    /* each coordinate adds at most itself, an interpolated coordinate, and a
+     * NULL coordinate to the subarray */
+    CoArray sa = coarray_alloc(3 * n);
 
     /* loop variables */
-    Coordinate c1     = NULL;
-    Coordinate c2     = NULL;
-    Coordinate c_last = NULL; /* keep track of the last coordinate added */
-
-    /* check the first coordinate */
-    c1 = *(a->coordinates);
-
-    /* if the y of the coordinate is less than or equal to y, add the
-     * coordinate to the list
+    int    j         = 0;    /* length of the subarray */
+    bool   last_null = true; /* true if the last coordinate added was NULL */
+    double y1;
+    double z1;
+    double y2;
+    double z2;
+
+    /* if the y of the first coordinate is less than or equal to y, add the
+     * coordinate to the subarray
      */
-    if (c1->y <= y) {
-        c_last = coord_copy(c1);
-        list_append(list, c_last);
+    if (a->y[0] <= y) {
+        sa->y[j] = a->y[0];
+        sa->z[j] = a->z[0];
+        j++;
+        last_null = false;
     }
 
     for (int i = 1; i < n; i++) {
 
-        c1 = *(a->coordinates + i - 1);
-        c2 = *(a->coordinates + i);
+        y1 = a->y[i - 1];
+        z1 = a->z[i - 1];
+        y2 = a->y[i];
+        z2 = a->z[i];
 
         /* add an interpolated coordinate if coordinates change from
          * above to below or below to above the y value
          */
-        if ((c1->y < y && y < c2->y) || (y < c1->y && c2->y < y)) {
-            c_last = coord_interp_z(c1, c2, y);
-            list_append(list, c_last);
+        if ((y1 < y && y < y2) || (y < y1 && y2 < y)) {
+            sa->y[j] = y;
+            sa->z[j] = (z2 - z1) / (y2 - y1) * (y - y1) + z1;
+            j++;
+            last_null = false;
         }
 
-        /* add c2 if c2.z is at or below z */
-        if (c2->y <= y) {
-            c_last = coord_copy(c2);
-            list_append(list, c_last);
+        /* add the second coordinate if it is at or below y */
+        if (y2 <= y) {
+            sa->y[j] = y2;
+            sa->z[j] = z2;
+            j++;
+            last_null = false;
         }
 
         /* if the last coordinate added wasn't NULL,
-         * c2 isn't the last coordinate in the array,
-         * and c2 is above y,
-         * add a NULL spot in the
+         * the second coordinate isn't the last coordinate in the array,
+         * and the second coordinate is above y,
+         * add a NULL spot in the subarray
          */
-        if (c_last != NULL && (i < n - 1) && (c2->y > y)) {
-            c_last = NULL;
-            list_append(list, c_last);
+        if (!last_null && (i < n - 1) && (y2 > y)) {
+            coarray_set_gap(sa, j++);
+            last_null = true;
         }
     }
 
-    sa_length = list_length(list);
-
     /* don't include the last coordinate if it was null */
-    if (c_last == NULL)
-        sa_length--;
+    if (last_null && j > 0 && coarray_is_gap(sa, j - 1))
+        j--;
 
-    coordinates = (Coordinate *) list_to_array(list);
-    list_free(list);
-    sa = coarray_from_array(sa_length, coordinates);
-    mem_free(coordinates, __FILE__, __LINE__);
+    sa->length = j;
+    coarray_set_bounds(sa);
 
     return sa;
 }
 
+/* linearly interpolates the y value of a at z between the i-th and
+ * (i + 1)-th coordinates */
+static double
+coarray_interp_y(CoArray a, int i, double z)
+{
+    double y1 = a->y[i];
+    double z1 = a->z[i];
+    double y2 = a->y[i + 1];
+    double z2 = a->z[i + 1];
+
+    assert((z1 <= z && z <= z2) || (z2 <= z && z <= z1));
+
+    return (y2 - y1) / (z2 - z1) * (z - z1) + y1;
+}
+
 CoArray
 coarray_subarray(CoArray a, double zlo, double zhi)
 {
     assert(a);
     assert(zhi > zlo);
-    assert(a->coordinates[0]->z <= zlo);
-    assert(zhi <= a->coordinates[a->length - 1]->z);
+    assert(a->z[0] <= zlo);
+    assert(zhi <= a->z[a->length - 1]);
 
-    double      eps = 1e-10;
-    CoArray     sa;
-    Coordinate  c0;
-    Coordinate  c1;
-    Coordinate *array =
-        mem_calloc(a->length, sizeof(Coordinate), __FILE__, __LINE__);
+    double  eps = 1e-10;
+    CoArray sa  = coarray_alloc(a->length);
 
     /* loop variables */
     int i  = find_zlo_idx(a, 0, a->length, zlo);
     int j  = 0;
     int hi = find_zhi_idx(a, a->length, 0, a->length, zhi);
 
-    c0 = a->coordinates[i];
-    c1 = a->coordinates[i + 1];
-
-    if (fabs(c1->z - c0->z) <= eps)
-        array[j++] = coord_copy(c0);
-    else
-        array[j++] = coord_interp_y(c0, c1, zlo);
+    if (fabs(a->z[i + 1] - a->z[i]) <= eps) {
+        sa->y[j] = a->y[i];
+        sa->z[j] = a->z[i];
+    } else {
+        sa->y[j] = coarray_interp_y(a, i, zlo);
+        sa->z[j] = zlo;
+    }
+    j++;
 
     while (++i < hi) {
-        array[j++] = coord_copy(a->coordinates[i]);
+        sa->y[j] = a->y[i];
+        sa->z[j] = a->z[i];
+        j++;
     }
 
-    c0 = a->coordinates[i - 1];
-    c1 = a->coordinates[i];
-    if (fabs(c1->z - c0->z) <= eps)
-        array[j++] = coord_copy(c1);
-    else
-        array[j++] = coord_interp_y(c0, c1, zhi);
+    if (fabs(a->z[i] - a->z[i - 1]) <= eps) {
+        sa->y[j] = a->y[i];
+        sa->z[j] = a->z[i];
+    } else {
+        sa->y[j] = coarray_interp_y(a, i - 1, zhi);
+        sa->z[j] = zhi;
+    }
+    j++;
 
-    sa = coarray_from_array(j, array);
-    mem_free(array, __FILE__, __LINE__);
+    sa->length = j;
+    coarray_set_bounds(sa);
 
     return sa;
 }
+
+CoArray
+coarray_subarray_view(CoArray a, double zlo, double zhi)
+{
+    assert(a);
+    assert(zhi > zlo);
+    assert(a->z[0] <= zlo);
+    assert(zhi <= a->z[a->length - 1]);
+
+    double  eps = 1e-10;
+    CoArray view;
+
+    int lo = find_zlo_idx(a, 0, a->length, zlo);
+    int hi = find_zhi_idx(a, a->length, 0, a->length, zhi);
+
+    /* coarray_subarray() interpolates the end coordinates unless they are
+     * coordinates of a */
+    if (a->gaps || hi <= lo ||
+        !(a->z[lo] == zlo || fabs(a->z[lo + 1] - a->z[lo]) <= eps) ||
+        !(a->z[hi] == zhi || fabs(a->z[hi] - a->z[hi - 1]) <= eps))
+        return coarray_subarray(a, zlo, zhi);
+
+    NEW(view);
+    view->length    = hi - lo + 1;
+    view->y         = a->y + lo;
+    view->z         = a->z + lo;
+    view->gaps      = NULL;
+    view->parent    = coarray_ref(a->parent ? a->parent : a);
+    view->ref_count = 1;
+    coarray_set_bounds(view);
+
+    return view;
+}
@@ -0,0 +1,37 @@
+#ifndef COARRAY_INCLUDED
+#define COARRAY_INCLUDED
+
+#include <panthera/crosssection.h>
+
+/**
+ * coarray_ref:
+ * @a: a #CoArray
+ *
+ * Adds a reference to @a, which is released with coarray_free(). Reference
+ * counts are not atomic, so references to an array and to views of it must be
+ * added and released from one thread at a time.
+ *
+ * Returns: @a
+ */
+extern CoArray
+coarray_ref(CoArray a);
+
+/**
+ * coarray_subarray_view:
+ * @a:   a #CoArray
+ * @zlo: low z-value of coordinate range
+ * @zhi: high z-value of coordinate range
+ *
+ * Returns the coordinates of @a between @zlo and @zhi like coarray_subarray().
+ * If @zlo and @zhi are z-values of coordinates of @a, the returned array is a
+ * view of the values of @a rather than a copy, and it holds a reference to
+ * @a so that the values remain valid until the view is freed. Otherwise the
+ * coordinates are copied. Neither @a nor the view may be modified while the
+ * view exists. The returned array must be freed with coarray_free().
+ *
+ * Returns: a subset of @a
+ */
+extern CoArray
+coarray_subarray_view(CoArray a, double zlo, double zhi);
+
+#endif
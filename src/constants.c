@@ -1,28 +1,33 @@
 #include <panthera/constants.h>
 
-static double gravity            = 9.81;
-static double manning_conversion = 1;
+static Constants defaults = CONSTANTS_SI;
+
+Constants
+const_defaults(void)
+{
+    return defaults;
+}
 
 double
 const_gravity(void)
 {
-    return gravity;
+    return defaults.gravity;
 }
 
 double
 const_manning(void)
 {
-    return manning_conversion;
+    return defaults.manning;
 }
 
 void
 const_set_gravity(double g)
 {
-    gravity = g;
+    defaults.gravity = g;
 }
 
 void
 const_set_manning(double k)
 {
-    manning_conversion = k;
+    defaults.manning = k;
 }
@@ -1,28 +1,51 @@
+#include "coarray.h"
+#include "list.h"
 #include "mem.h"
-#include "secantsolve.h"
+#include "rootsolve.h"
 #include "subsection.h"
+#include "threadpool.h"
 #include <assert.h>
 #include <math.h>
 #include <panthera/constants.h>
 #include <panthera/crosssection.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
+/* maximum number of times a property table interval is bisected */
+#define MAX_TABLE_LEVEL 16
+
 /*
  * cross section interface
  */
 struct CrossSection {
-    int         n_coordinates; /* number of coordinates */
-    int         n_subsections; /* number of subsections */
-    CoArray     ca;            /* coordinate array */
-    Subsection *ss;            /* array of subsections */
+    int                n_coordinates; /* number of coordinates */
+    int                n_subsections; /* number of subsections */
+    CoArray            ca;            /* coordinate array */
+    Subsection *       ss;            /* array of subsections */
+    int                n_table;       /* number of property table samples */
+    XSPValues *        table;         /* property table, NULL if not built */
+    Constants          constants;     /* physical constants */
+    int                ref_count;     /* number of references to the xs */
 };
 
-static CrossSectionProps
-calc_hydraulic_properties(CrossSection xs, double h)
+/* properties computed by the critical and normal depth solvers */
+#define CRITICAL_MASK (XS_MASK_AREA | XS_MASK_TOP_WIDTH | XS_MASK_CRITICAL_FLOW)
+#define NORMAL_MASK XS_MASK_CONVEYANCE
+
+/* Computes the properties selected by mask. Subsection conveyance is only
+ * computed if conveyance or the velocity coefficient is selected, and the
+ * other derived properties are only computed if they are selected. Values of
+ * properties not in mask are left unmodified. If dxsp is not NULL, the
+ * derivatives of the selected properties with respect to depth are stored in
+ * dxsp, computed in the same pass from the partially wet segments. */
+static inline void
+calc_masked_properties(CrossSection xs,
+                       double       h,
+                       unsigned int mask,
+                       XSPValues *  xsp,
+                       XSPValues *  dxsp)
 {
-
-    assert(xs);
-
     int n_subsections = xs->n_subsections;
     int i;
 
@@ -30,6 +53,8 @@ calc_hydraulic_properties(CrossSection xs, double h)
     double area_ss     = 0; /* subsection area */
     double top_width   = 0; /* top width */
     double w_perimeter = 0; /* wetted perimeter */
+    double p_ss        = 0; /* subsection wetted perimeter */
+    double t_ss        = 0; /* subsection top width */
     double h_depth;         /* hydraulic depth */
     double h_radius;        /* hydraulic radius */
     double conveyance = 0;  /* conveyance */
@@ -38,57 +63,184 @@ calc_hydraulic_properties(CrossSection xs, double h)
     double alpha;           /* velocity coefficient */
     double crit_flow;       /* critical flow */
 
-    CrossSectionProps xsp = xsp_new();
-    CrossSectionProps xsp_ss;
-    Subsection        ss;
+    /* derivatives with respect to depth */
+    double d_top_width   = 0;
+    double d_w_perimeter = 0;
+    double d_conveyance  = 0;
+    double d_sum         = 0;
+    double dp_ss         = 0;
+    double dt_ss         = 0;
+    double dk_ss;
+
+    bool need_k   = mask & (XS_MASK_CONVEYANCE | XS_MASK_VELOCITY_COEFF);
+    bool need_sum = mask & XS_MASK_VELOCITY_COEFF;
+
+    Subsection ss;
 
     for (i = 0; i < n_subsections; i++) {
 
         /* skip subsection if depth is less than the lowest point in the
          * subsection */
         ss = *(xs->ss + i);
-        if (subsection_activated(ss, h))
+        if (subsection_activated(ss, h)) {
+            /* derivatives are taken from above, so a subsection that is
+             * activated just above h adds to the derivatives */
+            if (dxsp && !subsection_activated(ss, nextafter(h, INFINITY))) {
+                subsection_geometry_deriv(
+                    ss, h, &area_ss, &p_ss, &t_ss, &dp_ss, &dt_ss);
+                d_top_width += dt_ss;
+                d_w_perimeter += dp_ss;
+            }
             continue;
-
-        xsp_ss  = subsection_properties(ss, h);
-        area_ss = xsp_get(xsp_ss, XS_AREA);
-        k_ss    = xsp_get(xsp_ss, XS_CONVEYANCE);
-        top_width += xsp_get(xsp_ss, XS_TOP_WIDTH);
-        w_perimeter += xsp_get(xsp_ss, XS_WETTED_PERIMETER);
-
-        if (area_ss > 0) {
-            sum += (k_ss * k_ss * k_ss) / (area_ss * area_ss);
         }
 
-        xsp_free(xsp_ss);
-
+        if (dxsp) {
+            subsection_geometry_deriv(
+                ss, h, &area_ss, &p_ss, &t_ss, &dp_ss, &dt_ss);
+            d_top_width += dt_ss;
+            d_w_perimeter += dp_ss;
+        } else {
+            subsection_geometry(ss, h, &area_ss, &p_ss, &t_ss);
+        }
+        top_width += t_ss;
+        w_perimeter += p_ss;
         area += area_ss;
-        conveyance += k_ss;
+
+        if (need_k) {
+            k_ss = subsection_conveyance(ss, area_ss, p_ss);
+            conveyance += k_ss;
+            if (need_sum && area_ss > 0)
+                sum += (k_ss * k_ss * k_ss) / (area_ss * area_ss);
+
+            /* K = c A^(5/3) P^(-2/3) */
+            if (dxsp) {
+                dk_ss = k_ss * (5.0 / 3.0 * t_ss / area_ss -
+                                2.0 / 3.0 * dp_ss / p_ss);
+                d_conveyance += dk_ss;
+                if (need_sum && area_ss > 0)
+                    d_sum += 3 * k_ss * k_ss * dk_ss / (area_ss * area_ss) -
+                             2 * k_ss * k_ss * k_ss * t_ss /
+                                 (area_ss * area_ss * area_ss);
+            }
+        }
     }
 
-    h_depth  = area / top_width;
     h_radius = area / w_perimeter;
-    if (isnan(h_radius))
+    if (need_k && isnan(h_radius))
         conveyance = NAN;
-    alpha     = (area * area) * sum / (conveyance * conveyance * conveyance);
-    crit_flow = area * sqrt(const_gravity() * h_depth);
-
-    xsp_set(xsp, XS_DEPTH, h);
-    xsp_set(xsp, XS_AREA, area);
-    xsp_set(xsp, XS_TOP_WIDTH, top_width);
-    xsp_set(xsp, XS_WETTED_PERIMETER, w_perimeter);
-    xsp_set(xsp, XS_HYDRAULIC_DEPTH, h_depth);
-    xsp_set(xsp, XS_HYDRAULIC_RADIUS, h_radius);
-    xsp_set(xsp, XS_CONVEYANCE, conveyance);
-    xsp_set(xsp, XS_VELOCITY_COEFF, alpha);
-    xsp_set(xsp, XS_CRITICAL_FLOW, crit_flow);
 
-    return xsp;
+    if (mask & XS_MASK_DEPTH)
+        xsp->values[XS_DEPTH] = h;
+    if (mask & XS_MASK_AREA)
+        xsp->values[XS_AREA] = area;
+    if (mask & XS_MASK_TOP_WIDTH)
+        xsp->values[XS_TOP_WIDTH] = top_width;
+    if (mask & XS_MASK_WETTED_PERIMETER)
+        xsp->values[XS_WETTED_PERIMETER] = w_perimeter;
+    if (mask & XS_MASK_HYDRAULIC_RADIUS)
+        xsp->values[XS_HYDRAULIC_RADIUS] = h_radius;
+    if (mask & XS_MASK_CONVEYANCE)
+        xsp->values[XS_CONVEYANCE] = conveyance;
+    if (mask & XS_MASK_VELOCITY_COEFF) {
+        alpha = (area * area) * sum / (conveyance * conveyance * conveyance);
+        xsp->values[XS_VELOCITY_COEFF] = alpha;
+    }
+    if (mask & (XS_MASK_HYDRAULIC_DEPTH | XS_MASK_CRITICAL_FLOW)) {
+        h_depth = area / top_width;
+        if (mask & XS_MASK_HYDRAULIC_DEPTH)
+            xsp->values[XS_HYDRAULIC_DEPTH] = h_depth;
+        if (mask & XS_MASK_CRITICAL_FLOW) {
+            crit_flow = area * sqrt(xs->constants.gravity * h_depth);
+            xsp->values[XS_CRITICAL_FLOW] = crit_flow;
+        }
+    }
+
+    if (dxsp == NULL)
+        return;
+
+    if (mask & XS_MASK_DEPTH)
+        dxsp->values[XS_DEPTH] = 1;
+    if (mask & XS_MASK_AREA)
+        dxsp->values[XS_AREA] = top_width;
+    if (mask & XS_MASK_TOP_WIDTH)
+        dxsp->values[XS_TOP_WIDTH] = d_top_width;
+    if (mask & XS_MASK_WETTED_PERIMETER)
+        dxsp->values[XS_WETTED_PERIMETER] = d_w_perimeter;
+    if (mask & XS_MASK_HYDRAULIC_DEPTH)
+        dxsp->values[XS_HYDRAULIC_DEPTH] =
+            1 - area * d_top_width / (top_width * top_width);
+    if (mask & XS_MASK_HYDRAULIC_RADIUS)
+        dxsp->values[XS_HYDRAULIC_RADIUS] =
+            (top_width * w_perimeter - area * d_w_perimeter) /
+            (w_perimeter * w_perimeter);
+    if (mask & XS_MASK_CONVEYANCE)
+        dxsp->values[XS_CONVEYANCE] = isnan(conveyance) ? NAN : d_conveyance;
+    if (mask & XS_MASK_VELOCITY_COEFF)
+        dxsp->values[XS_VELOCITY_COEFF] =
+            alpha * (2 * top_width / area + d_sum / sum -
+                     3 * d_conveyance / conveyance);
+    if (mask & XS_MASK_CRITICAL_FLOW)
+        dxsp->values[XS_CRITICAL_FLOW] =
+            crit_flow *
+            (1.5 * top_width / area - 0.5 * d_top_width / top_width);
+}
+
+/* Dispatches to a copy of calc_masked_properties() specialized for the
+ * masks used in the solver loops and for all properties. */
+static void
+calc_hydraulic_properties(CrossSection xs,
+                          double       h,
+                          unsigned int mask,
+                          XSPValues *  xsp)
+{
+    assert(xs && xsp);
+
+    switch (mask) {
+    case XS_MASK_ALL:
+        calc_masked_properties(xs, h, XS_MASK_ALL, xsp, NULL);
+        break;
+    case CRITICAL_MASK:
+        calc_masked_properties(xs, h, CRITICAL_MASK, xsp, NULL);
+        break;
+    case NORMAL_MASK:
+        calc_masked_properties(xs, h, NORMAL_MASK, xsp, NULL);
+        break;
+    default:
+        calc_masked_properties(xs, h, mask, xsp, NULL);
+        break;
+    }
 }
 
 CrossSection
 xs_new(CoArray ca, int n_roughness, double *roughness, double *z_roughness)
 {
+    Constants constants = const_defaults();
+
+    return xs_new_with_constants(
+        ca, n_roughness, roughness, z_roughness, &constants);
+}
+
+CrossSection
+xs_new_with_constants(CoArray          ca,
+                      int              n_roughness,
+                      double *         roughness,
+                      double *         z_roughness,
+                      const Constants *constants)
+{
+    assert(constants);
+
+    return xs_new_adopt(
+        coarray_copy(ca), n_roughness, roughness, z_roughness, constants);
+}
+
+CrossSection
+xs_new_adopt(CoArray          ca,
+             int              n_roughness,
+             double *         roughness,
+             double *         z_roughness,
+             const Constants *constants)
+{
+    assert(ca);
     assert(n_roughness >= 1);
     assert(roughness);
     if (n_roughness > 1)
@@ -96,7 +248,11 @@ xs_new(CoArray ca, int n_roughness, double *roughness, double *z_roughness)
     for (int i = 0; i < n_roughness; i++)
         assert(roughness > 0);
 
-    Coordinate c;
+    Constants defaults;
+    if (!constants) {
+        defaults  = const_defaults();
+        constants = &defaults;
+    }
 
     /* cross section to return */
     CrossSection xs;
@@ -104,7 +260,14 @@ xs_new(CoArray ca, int n_roughness, double *roughness, double *z_roughness)
     xs->n_coordinates = coarray_length(ca);
     xs->n_subsections = n_roughness;
     xs->ss = mem_calloc(n_roughness, sizeof(Subsection), __FILE__, __LINE__);
-    xs->ca = coarray_copy(ca);
+    xs->ca = ca;
+
+    xs->constants = *constants;
+    xs->ref_count = 1;
+
+    /* property-table mode is off until xs_build_table() is called */
+    xs->n_table = 0;
+    xs->table   = NULL;
 
     /* initialize z splits
      * include first and last z-values of the CoArray
@@ -112,13 +275,8 @@ xs_new(CoArray ca, int n_roughness, double *roughness, double *z_roughness)
     double *z_splits =
         mem_calloc(n_roughness + 1, sizeof(double), __FILE__, __LINE__);
 
-    c           = coarray_get(xs->ca, 0);
-    z_splits[0] = c->z;
-    coord_free(c);
-
-    c                     = coarray_get(xs->ca, coarray_length(xs->ca) - 1);
-    z_splits[n_roughness] = c->z;
-    coord_free(c);
+    z_splits[0]           = coarray_z(ca)[0];
+    z_splits[n_roughness] = coarray_z(ca)[xs->n_coordinates - 1];
 
     for (int i = 1; i < n_roughness; i++) {
         z_splits[i] = *(z_roughness + i - 1);
@@ -127,13 +285,13 @@ xs_new(CoArray ca, int n_roughness, double *roughness, double *z_roughness)
     /* set all activation depths to -inf */
     double activation_depth = -INFINITY;
 
-    /* create subsections from the roughness section breaks */
+    /* create subsections from the roughness section breaks, which adopt
+     * views of the coordinate array where possible */
     CoArray subarray;
     for (int i = 0; i < n_roughness; i++) {
-        subarray = coarray_subarray(xs->ca, z_splits[i], z_splits[i + 1]);
-        *(xs->ss + i) =
-            subsection_new(subarray, *(roughness + i), activation_depth);
-        coarray_free(subarray);
+        subarray = coarray_subarray_view(ca, z_splits[i], z_splits[i + 1]);
+        *(xs->ss + i) = subsection_new_adopt(
+            subarray, *(roughness + i), activation_depth, constants);
     }
 
     mem_free(z_splits, __FILE__, __LINE__);
@@ -141,15 +299,74 @@ xs_new(CoArray ca, int n_roughness, double *roughness, double *z_roughness)
     return xs;
 }
 
+CrossSection
+xs_with_roughness(CrossSection xs, const double *roughness)
+{
+    assert(xs && roughness);
+
+    int i;
+    int n = xs->n_subsections;
+
+    for (i = 0; i < n; i++)
+        assert(roughness[i] > 0);
+
+    CrossSection new_xs;
+    NEW(new_xs);
+    new_xs->n_coordinates = xs->n_coordinates;
+    new_xs->n_subsections = n;
+    new_xs->ss = mem_calloc(n, sizeof(Subsection), __FILE__, __LINE__);
+    new_xs->ca = coarray_ref(xs->ca);
+
+    new_xs->constants = xs->constants;
+    new_xs->ref_count = 1;
+
+    /* the property table depends on roughness and is not shared */
+    new_xs->n_table = 0;
+    new_xs->table   = NULL;
+
+    for (i = 0; i < n; i++)
+        new_xs->ss[i] = subsection_with_roughness(xs->ss[i], roughness[i]);
+
+    return new_xs;
+}
+
+CrossSection
+xs_ref(CrossSection xs)
+{
+    assert(xs);
+
+    xs->ref_count++;
+
+    return xs;
+}
+
+/* frees the property table of xs, if any */
+static void
+table_free(CrossSection xs)
+{
+    if (xs->table == NULL)
+        return;
+
+    mem_free(xs->table, __FILE__, __LINE__);
+
+    xs->table   = NULL;
+    xs->n_table = 0;
+}
+
 void
 xs_free(CrossSection xs)
 {
     if (xs == NULL)
         return;
 
+    if (--xs->ref_count > 0)
+        return;
+
     int i;
     int n = xs->n_subsections;
 
+    table_free(xs);
+
     /* free the coordinate array */
     coarray_free(xs->ca);
 
@@ -162,15 +379,365 @@ xs_free(CrossSection xs)
     FREE(xs);
 }
 
+/* property table */
+
+static int
+compare_depth(const void *a, const void *b)
+{
+    double a_depth = *(const double *) a;
+    double b_depth = *(const double *) b;
+
+    if (a_depth < b_depth)
+        return -1;
+    else if (a_depth > b_depth)
+        return 1;
+    else
+        return 0;
+}
+
+/* returns true if the finite properties in exact are approximated by interp
+ * within a relative error of max_error */
+static bool
+table_within_error(const XSPValues *exact,
+                   const XSPValues *interp,
+                   double           max_error)
+{
+    double exact_value;
+    double interp_value;
+
+    for (int i = 0; i < N_XSP; i++) {
+        exact_value  = exact->values[i];
+        interp_value = interp->values[i];
+        if (!isfinite(exact_value))
+            continue;
+        if (fabs(interp_value - exact_value) > max_error * fabs(exact_value))
+            return false;
+    }
+
+    return true;
+}
+
+/* appends samples strictly between the depths of xsp1 and xsp2 to list */
+static void
+table_refine(CrossSection xs,
+             List         list,
+             XSPValues *  xsp1,
+             XSPValues *  xsp2,
+             double       max_error,
+             int          level)
+{
+    if (level >= MAX_TABLE_LEVEL)
+        return;
+
+    double h1    = xsp1->values[XS_DEPTH];
+    double h2    = xsp2->values[XS_DEPTH];
+    double h_mid = 0.5 * (h1 + h2);
+
+    XSPValues *exact;
+    XSPValues  interp;
+
+    NEW(exact);
+    calc_hydraulic_properties(xs, h_mid, XS_MASK_ALL, exact);
+    xsp_values_interp_depth(xsp1, xsp2, h_mid, &interp);
+
+    if (table_within_error(exact, &interp, max_error)) {
+        FREE(exact);
+        return;
+    }
+
+    table_refine(xs, list, xsp1, exact, max_error, level + 1);
+    list_append(list, exact);
+    table_refine(xs, list, exact, xsp2, max_error, level + 1);
+}
+
+void
+xs_build_table(CrossSection xs, double h_lo, double h_hi, double max_error)
+{
+    assert(xs);
+    assert(isfinite(h_lo) && isfinite(h_hi) && h_lo < h_hi);
+    assert(max_error > 0);
+
+    /* replacing a table would change the properties seen by every holder of
+     * a shared cross section */
+    assert(xs->ref_count == 1 || xs->table == NULL);
+
+    int           i;
+    int           j;
+    int           n_ss;
+    int           n_depths = 2;
+    double *      depths;
+    const double *ss_y;
+    const double *ss_z;
+
+    table_free(xs);
+
+    /* sample depths at the table bounds and at every subsection coordinate
+     * elevation, including subsection breaks, within the table range */
+    for (i = 0; i < xs->n_subsections; i++)
+        n_depths += coarray_length(subsection_coarray(*(xs->ss + i)));
+
+    depths    = mem_calloc(n_depths, sizeof(double), __FILE__, __LINE__);
+    depths[0] = h_lo;
+    depths[1] = h_hi;
+    n_depths  = 2;
+
+    /* NULL coordinates are NAN and fail the comparisons */
+    for (i = 0; i < xs->n_subsections; i++) {
+        n_ss = xs_subsection_span(xs, i, &ss_y, &ss_z);
+        for (j = 0; j < n_ss; j++) {
+            if (h_lo < ss_y[j] && ss_y[j] < h_hi)
+                depths[n_depths++] = ss_y[j];
+        }
+    }
+
+    qsort(depths, n_depths, sizeof(double), &compare_depth);
+
+    List       list = list_new();
+    XSPValues *xsp_prev;
+    XSPValues *xsp;
+
+    NEW(xsp_prev);
+    calc_hydraulic_properties(xs, depths[0], XS_MASK_ALL, xsp_prev);
+    list_append(list, xsp_prev);
+
+    for (i = 1; i < n_depths; i++) {
+        if (depths[i] == depths[i - 1])
+            continue;
+        NEW(xsp);
+        calc_hydraulic_properties(xs, depths[i], XS_MASK_ALL, xsp);
+        table_refine(xs, list, xsp_prev, xsp, max_error, 0);
+        list_append(list, xsp);
+        xsp_prev = xsp;
+    }
+
+    /* copy the samples into contiguous storage */
+    XSPValues **samples = (XSPValues **) list_to_array(list);
+
+    xs->n_table = list_length(list);
+    xs->table =
+        mem_calloc(xs->n_table, sizeof(XSPValues), __FILE__, __LINE__);
+    for (i = 0; i < xs->n_table; i++) {
+        *(xs->table + i) = *samples[i];
+        FREE(samples[i]);
+    }
+
+    mem_free(samples, __FILE__, __LINE__);
+    list_free(list);
+    mem_free(depths, __FILE__, __LINE__);
+}
+
+void
+xs_clear_table(CrossSection xs)
+{
+    assert(xs);
+    assert(xs->ref_count == 1);
+
+    table_free(xs);
+}
+
+int
+xs_table_size(CrossSection xs)
+{
+    assert(xs);
+    return xs->n_table;
+}
+
+/* interpolates properties from the property table into xsp. Returns false if
+ * h is outside of the table range or if the bracketing samples contain
+ * non-finite properties */
+static bool
+table_lookup(CrossSection xs, double h, XSPValues *xsp)
+{
+    XSPValues *table = xs->table;
+
+    int lo = 0;
+    int hi = xs->n_table - 1;
+    int mid;
+
+    if (h < table[lo].values[XS_DEPTH] || table[hi].values[XS_DEPTH] < h)
+        return false;
+
+    while (hi - lo > 1) {
+        mid = (lo + hi) / 2;
+        if (table[mid].values[XS_DEPTH] <= h)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    for (int i = 0; i < N_XSP; i++) {
+        if (!isfinite(table[lo].values[i]) || !isfinite(table[hi].values[i]))
+            return false;
+    }
+
+    xsp_values_interp_depth(&table[lo], &table[hi], h, xsp);
+
+    return true;
+}
+
+void
+xs_hydraulic_properties_masked(CrossSection xs,
+                               double       h,
+                               unsigned int mask,
+                               XSPValues *  xsp)
+{
+    assert(xs && xsp);
+
+    if (!isfinite(h)) {
+        for (int i = 0; i < N_XSP; i++)
+            xsp->values[i] = NAN;
+        return;
+    }
+
+    if (xs->table && table_lookup(xs, h, xsp))
+        return;
+
+    calc_hydraulic_properties(xs, h, mask, xsp);
+}
+
+void
+xs_hydraulic_properties_into(CrossSection xs, double h, XSPValues *xsp)
+{
+    xs_hydraulic_properties_masked(xs, h, XS_MASK_ALL, xsp);
+}
+
+void
+xs_hydraulic_properties_batch(CrossSection  xs,
+                              int           n,
+                              const double *depths,
+                              double *      out)
+{
+    assert(xs && n >= 0);
+    assert(n == 0 || (depths && out));
+
+    int    i;
+    int    j;
+    int    k;
+    int    m;
+    double h;
+
+    XSPValues xsp;
+
+    /* interpolate from the property table one depth at a time */
+    if (xs->table) {
+        for (i = 0; i < n; i++) {
+            xs_hydraulic_properties_into(xs, depths[i], &xsp);
+            for (k = 0; k < N_XSP; k++)
+                out[k * n + i] = xsp.values[k];
+        }
+        return;
+    }
+
+    /* subsection values */
+    double area_ss[BATCH_CHUNK];
+    double perimeter_ss[BATCH_CHUNK];
+    double top_width_ss[BATCH_CHUNK];
+    double k_ss[BATCH_CHUNK];
+
+    /* cross section sums */
+    double area[BATCH_CHUNK];
+    double w_perimeter[BATCH_CHUNK];
+    double top_width[BATCH_CHUNK];
+    double conveyance[BATCH_CHUNK];
+    double sum[BATCH_CHUNK];
+
+    double h_depth;
+    double h_radius;
+    double k_xs;
+
+    for (i = 0; i < n; i += BATCH_CHUNK) {
+
+        m = n - i < BATCH_CHUNK ? n - i : BATCH_CHUNK;
+
+        for (j = 0; j < m; j++) {
+            area[j]        = 0;
+            w_perimeter[j] = 0;
+            top_width[j]   = 0;
+            conveyance[j]  = 0;
+            sum[j]         = 0;
+        }
+
+        for (k = 0; k < xs->n_subsections; k++) {
+            subsection_properties_batch(*(xs->ss + k),
+                                        m,
+                                        depths + i,
+                                        area_ss,
+                                        perimeter_ss,
+                                        top_width_ss,
+                                        k_ss);
+            for (j = 0; j < m; j++) {
+                area[j] += area_ss[j];
+                w_perimeter[j] += perimeter_ss[j];
+                top_width[j] += top_width_ss[j];
+                conveyance[j] += k_ss[j];
+                if (area_ss[j] > 0)
+                    sum[j] += (k_ss[j] * k_ss[j] * k_ss[j]) /
+                              (area_ss[j] * area_ss[j]);
+            }
+        }
+
+        for (j = 0; j < m; j++) {
+
+            h = depths[i + j];
+
+            if (!isfinite(h)) {
+                for (k = 0; k < N_XSP; k++)
+                    out[k * n + i + j] = NAN;
+                continue;
+            }
+
+            h_depth  = area[j] / top_width[j];
+            h_radius = area[j] / w_perimeter[j];
+            k_xs     = isnan(h_radius) ? NAN : conveyance[j];
+
+            out[XS_DEPTH * n + i + j]            = h;
+            out[XS_AREA * n + i + j]             = area[j];
+            out[XS_TOP_WIDTH * n + i + j]        = top_width[j];
+            out[XS_WETTED_PERIMETER * n + i + j] = w_perimeter[j];
+            out[XS_HYDRAULIC_DEPTH * n + i + j]  = h_depth;
+            out[XS_HYDRAULIC_RADIUS * n + i + j] = h_radius;
+            out[XS_CONVEYANCE * n + i + j]       = k_xs;
+            out[XS_VELOCITY_COEFF * n + i + j] =
+                (area[j] * area[j]) * sum[j] / (k_xs * k_xs * k_xs);
+            out[XS_CRITICAL_FLOW * n + i + j] =
+                area[j] * sqrt(xs->constants.gravity * h_depth);
+        }
+    }
+}
+
+void
+xs_hydraulic_properties_deriv(CrossSection xs,
+                              double       h,
+                              XSPValues *  xsp,
+                              XSPValues *  dxsp)
+{
+    assert(xs && xsp && dxsp);
+
+    if (!isfinite(h)) {
+        for (int i = 0; i < N_XSP; i++) {
+            xsp->values[i]  = NAN;
+            dxsp->values[i] = NAN;
+        }
+        return;
+    }
+
+    calc_masked_properties(xs, h, XS_MASK_ALL, xsp, dxsp);
+}
+
 CrossSectionProps
 xs_hydraulic_properties(CrossSection xs, double y)
 {
     assert(xs);
 
+    CrossSectionProps xsp;
+
     if (!isfinite(y))
         return NULL;
 
-    return calc_hydraulic_properties(xs, y);
+    xsp = xsp_new();
+    xs_hydraulic_properties_into(xs, y, xsp_values(xsp));
+
+    return xsp;
 }
 
 CoArray
@@ -181,6 +748,38 @@ xs_coarray(CrossSection xs)
     return coarray_copy(xs->ca);
 }
 
+Constants
+xs_constants(CrossSection xs)
+{
+    assert(xs);
+
+    return xs->constants;
+}
+
+double
+xs_max_y(CrossSection xs)
+{
+    assert(xs);
+
+    return coarray_max_y(xs->ca);
+}
+
+double
+xs_min_y(CrossSection xs)
+{
+    assert(xs);
+
+    return coarray_min_y(xs->ca);
+}
+
+int
+xs_n_coordinates(CrossSection xs)
+{
+    assert(xs);
+
+    return xs->n_coordinates;
+}
+
 int
 xs_n_subsections(CrossSection xs)
 {
@@ -204,6 +803,39 @@ xs_roughness(CrossSection xs, double *roughness)
     }
 }
 
+int
+xs_subsection_span(CrossSection    xs,
+                   int             i,
+                   const double ** y,
+                   const double ** z)
+{
+    assert(xs && y && z);
+    assert(0 <= i && i < xs->n_subsections);
+
+    CoArray ss_array = subsection_coarray(*(xs->ss + i));
+
+    *y = coarray_y(ss_array);
+    *z = coarray_z(ss_array);
+
+    return coarray_length(ss_array);
+}
+
+const double *
+xs_y(CrossSection xs)
+{
+    assert(xs);
+
+    return coarray_y(xs->ca);
+}
+
+const double *
+xs_z(CrossSection xs)
+{
+    assert(xs);
+
+    return coarray_z(xs->ca);
+}
+
 void
 xs_z_roughness(CrossSection xs, double *z_roughness)
 {
@@ -219,52 +851,123 @@ xs_z_roughness(CrossSection xs, double *z_roughness)
     }
 }
 
+/* depth solvers */
+#define SOLVE_X_TOL 1e-8
+#define SOLVE_MAX_ITERATIONS 100
+#define SOLVE_MAX_EXPAND 64
+
+/* Solves func(h) = 0 for a flow function that is -discharge at the minimum
+ * y-value of xs and increases with h. The bracket is expanded upward from the
+ * maximum y-value of xs until it contains the solution. func_deriv is used
+ * with Newton steps unless the property table of xs is enabled. */
+static double
+solve_depth(CrossSection  xs,
+            RootFunc      func,
+            RootFuncDeriv func_deriv,
+            void *        func_data,
+            double        discharge,
+            double        initial_h,
+            XSSolveInfo * info)
+{
+    int    n_evaluations = 0;
+    double a             = coarray_min_y(xs->ca);
+    double b             = coarray_max_y(xs->ca);
+    double fa            = -discharge;
+    double fb;
+
+    RootSolution sol = { false, 0, 0, NAN, NAN };
+
+    if (discharge == 0) {
+        sol.converged = true;
+        sol.x         = a;
+        sol.residual  = 0;
+    } else if (discharge > 0 && b > a &&
+               root_bracket_up(func,
+                               func_data,
+                               a,
+                               fa,
+                               &b,
+                               &fb,
+                               SOLVE_MAX_EXPAND,
+                               &n_evaluations)) {
+        if (xs->table)
+            sol = root_brent(func,
+                             func_data,
+                             a,
+                             fa,
+                             b,
+                             fb,
+                             SOLVE_X_TOL,
+                             SOLVE_MAX_ITERATIONS);
+        else
+            sol = root_newton(func_deriv,
+                              func_data,
+                              a,
+                              fa,
+                              b,
+                              fb,
+                              initial_h,
+                              SOLVE_X_TOL,
+                              SOLVE_MAX_ITERATIONS);
+    }
+
+    if (info) {
+        info->converged     = sol.converged;
+        info->n_iterations  = sol.n_iterations;
+        info->n_evaluations = n_evaluations + sol.n_evaluations;
+        info->residual      = sol.residual;
+    }
+
+    return sol.x;
+}
+
 /* critical depth solver */
 typedef struct {
     double       discharge;
     CrossSection xs;
 } CriticalDepthData;
 
-double
+static double
 critical_flow_zero(double h, void *function_data)
 {
-    double             critical_flow;
-    CrossSectionProps  xsp;
+    XSPValues          xsp;
     CriticalDepthData *solver_data = (CriticalDepthData *) function_data;
 
-    if (!isfinite(h))
-        return NAN;
-
-    xsp           = xs_hydraulic_properties(solver_data->xs, h);
-    critical_flow = xsp_get(xsp, XS_CRITICAL_FLOW);
-    xsp_free(xsp);
+    xs_hydraulic_properties_masked(solver_data->xs, h, CRITICAL_MASK, &xsp);
 
-    return critical_flow - solver_data->discharge;
+    return xsp.values[XS_CRITICAL_FLOW] - solver_data->discharge;
 }
 
 static double
-calc_critical_depth(CrossSection xs, double discharge, double initial_h)
+critical_flow_zero_deriv(double h, void *function_data, double *deriv)
 {
-    assert(xs);
+    XSPValues          xsp;
+    XSPValues          dxsp;
+    CriticalDepthData *solver_data = (CriticalDepthData *) function_data;
 
-    int             max_iterations = 20;
-    double          eps            = 0.003;
-    double          critical_depth = NAN;
-    double          err;
-    double          h_1;
-    SecantSolution *res;
+    calc_masked_properties(solver_data->xs, h, CRITICAL_MASK, &xsp, &dxsp);
+    *deriv = dxsp.values[XS_CRITICAL_FLOW];
 
-    CriticalDepthData func_data = { discharge, xs };
-    err = critical_flow_zero(initial_h, (void *) &func_data);
-    h_1 = initial_h + 0.7 * err;
+    return xsp.values[XS_CRITICAL_FLOW] - solver_data->discharge;
+}
 
-    res = secant_solve(
-        max_iterations, eps, &critical_flow_zero, &func_data, initial_h, h_1);
-    if (res->solution_found)
-        critical_depth = res->x_computed;
-    FREE(res);
+double
+xs_critical_depth_solve(CrossSection xs,
+                        double       discharge,
+                        double       initial_depth,
+                        XSSolveInfo *info)
+{
+    assert(xs);
 
-    return critical_depth;
+    CriticalDepthData func_data = { discharge, xs };
+
+    return solve_depth(xs,
+                       &critical_flow_zero,
+                       &critical_flow_zero_deriv,
+                       &func_data,
+                       discharge,
+                       initial_depth,
+                       info);
 }
 
 double
@@ -272,7 +975,8 @@ xs_critical_depth(CrossSection xs, double discharge, double initial_depth)
 {
     assert(xs);
 
-    double critical_depth = calc_critical_depth(xs, discharge, initial_depth);
+    double critical_depth =
+        xs_critical_depth_solve(xs, discharge, initial_depth, NULL);
 
     return critical_depth;
 }
@@ -284,45 +988,50 @@ typedef struct {
     CrossSection xs;
 } NormalDepthData;
 
-double
+static double
 normal_flow_zero(double h, void *function_data)
 {
-    double            conveyance;
-    CrossSectionProps xsp;
-    NormalDepthData * solver_data = (NormalDepthData *) function_data;
+    XSPValues        xsp;
+    NormalDepthData *solver_data = (NormalDepthData *) function_data;
 
-    xsp        = xs_hydraulic_properties(solver_data->xs, h);
-    conveyance = xsp_get(xsp, XS_CONVEYANCE);
-    xsp_free(xsp);
+    xs_hydraulic_properties_masked(solver_data->xs, h, NORMAL_MASK, &xsp);
 
-    return conveyance * solver_data->sqrt_slope - solver_data->discharge;
+    return xsp.values[XS_CONVEYANCE] * solver_data->sqrt_slope -
+           solver_data->discharge;
 }
 
 static double
-calc_normal_depth(CrossSection xs,
-                  double       discharge,
-                  double       slope,
-                  double       initial_h)
+normal_flow_zero_deriv(double h, void *function_data, double *deriv)
+{
+    XSPValues        xsp;
+    XSPValues        dxsp;
+    NormalDepthData *solver_data = (NormalDepthData *) function_data;
+
+    calc_masked_properties(solver_data->xs, h, NORMAL_MASK, &xsp, &dxsp);
+    *deriv = dxsp.values[XS_CONVEYANCE] * solver_data->sqrt_slope;
+
+    return xsp.values[XS_CONVEYANCE] * solver_data->sqrt_slope -
+           solver_data->discharge;
+}
+
+double
+xs_normal_depth_solve(CrossSection xs,
+                      double       discharge,
+                      double       slope,
+                      double       initial_depth,
+                      XSSolveInfo *info)
 {
     assert(xs);
-    int             max_iterations = 20;
-    double          eps            = 0.003;
-    double          normal_depth   = NAN;
-    double          err;
-    double          h_1;
-    SecantSolution *res;
 
     NormalDepthData func_data = { discharge, sqrt(slope), xs };
-    err = normal_flow_zero(initial_h, (void *) &func_data);
-    h_1 = initial_h + 0.7 * err;
-
-    res = secant_solve(
-        max_iterations, eps, &normal_flow_zero, &func_data, initial_h, h_1);
-    if (res->solution_found)
-        normal_depth = res->x_computed;
-    FREE(res);
 
-    return normal_depth;
+    return solve_depth(xs,
+                       &normal_flow_zero,
+                       &normal_flow_zero_deriv,
+                       &func_data,
+                       discharge,
+                       initial_depth,
+                       info);
 }
 
 double
@@ -334,7 +1043,417 @@ xs_normal_depth(CrossSection xs,
     assert(xs);
 
     double normal_depth =
-        calc_normal_depth(xs, discharge, slope, initial_depth);
+        xs_normal_depth_solve(xs, discharge, slope, initial_depth, NULL);
 
     return normal_depth;
 }
+
+/* batch entry points */
+
+/* number of cross sections in each block evaluated by
+ * xs_hydraulic_properties_many() */
+#define PROPERTIES_BLOCK 1
+
+/* number of solutions in each block computed by xs_critical_depth_many() and
+ * xs_normal_depth_many() */
+#define SOLVE_BLOCK 32
+
+/* arguments of xs_hydraulic_properties_many() shared by its blocks */
+typedef struct {
+    CrossSection *xs;
+    long          n_depths;
+    const double *depths;
+    double *      out;
+} PropertiesData;
+
+static void
+properties_block(int begin, int end, void *data)
+{
+    int             i;
+    PropertiesData *p = data;
+
+    for (i = begin; i < end; i++) {
+        xs_hydraulic_properties_batch(p->xs[i],
+                                      (int) p->n_depths,
+                                      p->depths + i * p->n_depths,
+                                      p->out + i * p->n_depths * N_XSP);
+    }
+}
+
+void
+xs_hydraulic_properties_many(CrossSection *xs,
+                             int           n_xs,
+                             int           n_depths,
+                             const double *depths,
+                             double *      out,
+                             int           n_threads)
+{
+    assert(n_xs == 0 || n_depths == 0 || (xs && depths && out));
+
+    PropertiesData data = { xs, n_depths, depths, out };
+
+    if (n_depths > 0)
+        threadpool_parallel_for(
+            n_threads, n_xs, PROPERTIES_BLOCK, properties_block, &data);
+}
+
+/* arguments of xs_critical_depth_many() and xs_normal_depth_many() shared by
+ * their blocks. slope is NULL for critical depth. */
+typedef struct {
+    CrossSection *xs;
+    const double *flow;
+    const double *slope;
+    const double *initial_depth;
+    double *      depth;
+    XSSolveInfo * info;
+} SolveData;
+
+static void
+solve_block(int begin, int end, void *data)
+{
+    int          i;
+    double       initial_depth;
+    XSSolveInfo *info;
+    SolveData *  s = data;
+
+    for (i = begin; i < end; i++) {
+        initial_depth = s->initial_depth ? s->initial_depth[i] : NAN;
+        info          = s->info ? s->info + i : NULL;
+
+        if (s->slope) {
+            s->depth[i] = xs_normal_depth_solve(
+                s->xs[i], s->flow[i], s->slope[i], initial_depth, info);
+        } else {
+            s->depth[i] = xs_critical_depth_solve(
+                s->xs[i], s->flow[i], initial_depth, info);
+        }
+    }
+}
+
+void
+xs_critical_depth_many(CrossSection *xs,
+                       int           n,
+                       const double *critical_flow,
+                       const double *initial_depth,
+                       double *      depth,
+                       XSSolveInfo * info,
+                       int           n_threads)
+{
+    assert(n == 0 || (xs && critical_flow && depth));
+
+    SolveData data = { xs, critical_flow, NULL, initial_depth, depth, info };
+
+    threadpool_parallel_for(n_threads, n, SOLVE_BLOCK, solve_block, &data);
+}
+
+void
+xs_normal_depth_many(CrossSection *xs,
+                     int           n,
+                     const double *normal_flow,
+                     const double *slope,
+                     const double *initial_depth,
+                     double *      depth,
+                     XSSolveInfo * info,
+                     int           n_threads)
+{
+    assert(n == 0 || (xs && normal_flow && slope && depth));
+
+    SolveData data = { xs, normal_flow, slope, initial_depth, depth, info };
+
+    threadpool_parallel_for(n_threads, n, SOLVE_BLOCK, solve_block, &data);
+}
+
+/* interning */
+
+/* smallest number of slots in the hash table of a pool */
+#define POOL_MIN_SLOTS 16
+
+struct XSPool {
+    double        tolerance; /* coordinate tolerance */
+    int           n_xs;      /* number of interned cross sections */
+    int           n_slots;   /* number of hash table slots, a power of 2 */
+    CrossSection *slots;     /* cross section in each slot, NULL if empty */
+    uint64_t *    hashes;    /* hash of the cross section in each slot */
+};
+
+/* cross section being interned, with y-values taken relative to y_offset */
+typedef struct {
+    CoArray          ca;
+    double           y_offset;
+    int              n_roughness;
+    const double *   roughness;
+    const double *   z_roughness;
+    const Constants *constants;
+} PoolKey;
+
+/* FNV-1a hash of the bytes of value, continuing from hash */
+static uint64_t
+hash_bytes(uint64_t hash, const void *value, size_t size)
+{
+    size_t               i;
+    const unsigned char *bytes = value;
+
+    for (i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/* hash of a coordinate value, rounded to a multiple of the tolerance */
+static uint64_t
+hash_coordinate(uint64_t hash, double value, double tolerance)
+{
+    long long rounded;
+
+    if (isnan(value))
+        return hash_bytes(hash, "n", 1);
+
+    if (tolerance > 0) {
+        rounded = llround(value / tolerance);
+        return hash_bytes(hash, &rounded, sizeof(rounded));
+    }
+
+    /* +0 and -0 are equal and must hash the same */
+    if (value == 0)
+        value = 0;
+
+    return hash_bytes(hash, &value, sizeof(value));
+}
+
+static uint64_t
+pool_hash(XSPool pool, const PoolKey *key)
+{
+    int           i;
+    int           n    = coarray_length(key->ca);
+    const double *y    = coarray_y(key->ca);
+    const double *z    = coarray_z(key->ca);
+    uint64_t      hash = 14695981039346656037ULL;
+
+    hash = hash_bytes(hash, &n, sizeof(n));
+    for (i = 0; i < n; i++) {
+        hash = hash_coordinate(hash, y[i] - key->y_offset, pool->tolerance);
+        hash = hash_coordinate(hash, z[i], pool->tolerance);
+    }
+
+    hash = hash_bytes(hash, &key->n_roughness, sizeof(key->n_roughness));
+    for (i = 0; i < key->n_roughness; i++)
+        hash = hash_bytes(hash, key->roughness + i, sizeof(double));
+    for (i = 0; i < key->n_roughness - 1; i++)
+        hash = hash_bytes(hash, key->z_roughness + i, sizeof(double));
+
+    hash = hash_bytes(hash, key->constants, sizeof(Constants));
+
+    return hash;
+}
+
+static bool
+same_coordinate(double a, double b, double tolerance)
+{
+    if (isnan(a) || isnan(b))
+        return isnan(a) && isnan(b);
+
+    return fabs(a - b) <= tolerance;
+}
+
+/* returns true if xs was interned from a cross section matching key */
+static bool
+pool_key_matches(XSPool pool, CrossSection xs, const PoolKey *key)
+{
+    int           i;
+    int           n         = coarray_length(key->ca);
+    const double *y         = coarray_y(key->ca);
+    const double *z         = coarray_z(key->ca);
+    const double *xs_y      = coarray_y(xs->ca);
+    const double *xs_z      = coarray_z(xs->ca);
+    double        tolerance = pool->tolerance;
+    CoArray       ss_ca;
+
+    if (xs->n_coordinates != n || xs->n_subsections != key->n_roughness)
+        return false;
+
+    if (xs->constants.gravity != key->constants->gravity ||
+        xs->constants.manning != key->constants->manning)
+        return false;
+
+    for (i = 0; i < n; i++) {
+        if (!same_coordinate(xs_y[i], y[i] - key->y_offset, tolerance) ||
+            !same_coordinate(xs_z[i], z[i], tolerance))
+            return false;
+    }
+
+    for (i = 0; i < key->n_roughness; i++) {
+        if (subsection_roughness(xs->ss[i]) != key->roughness[i])
+            return false;
+        if (i == key->n_roughness - 1)
+            break;
+        ss_ca = subsection_coarray(xs->ss[i]);
+        if (coarray_z(ss_ca)[coarray_length(ss_ca) - 1] != key->z_roughness[i])
+            return false;
+    }
+
+    return true;
+}
+
+/* returns the slot of the cross section matching key, or the empty slot
+ * where it would be stored */
+static int
+pool_find(XSPool pool, const PoolKey *key, uint64_t hash)
+{
+    int mask = pool->n_slots - 1;
+    int i    = (int) (hash & mask);
+
+    while (pool->slots[i]) {
+        if (pool->hashes[i] == hash &&
+            pool_key_matches(pool, pool->slots[i], key))
+            break;
+        i = (i + 1) & mask;
+    }
+
+    return i;
+}
+
+/* doubles the number of slots of pool and rehashes the cross sections */
+static void
+pool_grow(XSPool pool)
+{
+    int           i;
+    int           j;
+    int           n_old  = pool->n_slots;
+    CrossSection *slots  = pool->slots;
+    uint64_t *    hashes = pool->hashes;
+
+    pool->n_slots *= 2;
+    pool->slots =
+        mem_calloc(pool->n_slots, sizeof(CrossSection), __FILE__, __LINE__);
+    pool->hashes =
+        mem_calloc(pool->n_slots, sizeof(uint64_t), __FILE__, __LINE__);
+
+    for (i = 0; i < n_old; i++) {
+        if (!slots[i])
+            continue;
+        j = (int) (hashes[i] & (pool->n_slots - 1));
+        while (pool->slots[j])
+            j = (j + 1) & (pool->n_slots - 1);
+        pool->slots[j]  = slots[i];
+        pool->hashes[j] = hashes[i];
+    }
+
+    mem_free(hashes, __FILE__, __LINE__);
+    mem_free(slots, __FILE__, __LINE__);
+}
+
+XSPool
+xs_pool_new(double tolerance)
+{
+    assert(tolerance >= 0);
+
+    XSPool pool;
+    NEW(pool);
+
+    pool->tolerance = tolerance;
+    pool->n_xs      = 0;
+    pool->n_slots   = POOL_MIN_SLOTS;
+    pool->slots =
+        mem_calloc(POOL_MIN_SLOTS, sizeof(CrossSection), __FILE__, __LINE__);
+    pool->hashes =
+        mem_calloc(POOL_MIN_SLOTS, sizeof(uint64_t), __FILE__, __LINE__);
+
+    return pool;
+}
+
+void
+xs_pool_free(XSPool pool)
+{
+    if (pool == NULL)
+        return;
+
+    int i;
+
+    for (i = 0; i < pool->n_slots; i++) {
+        if (pool->slots[i])
+            xs_free(pool->slots[i]);
+    }
+
+    mem_free(pool->hashes, __FILE__, __LINE__);
+    mem_free(pool->slots, __FILE__, __LINE__);
+    FREE(pool);
+}
+
+int
+xs_pool_size(XSPool pool)
+{
+    assert(pool);
+    return pool->n_xs;
+}
+
+CrossSection
+xs_pool_intern(XSPool           pool,
+               CoArray          ca,
+               int              n_roughness,
+               double *         roughness,
+               double *         z_roughness,
+               const Constants *constants,
+               double *         y_offset)
+{
+    assert(pool && ca && y_offset);
+    assert(n_roughness >= 1 && roughness);
+    assert(n_roughness == 1 || z_roughness);
+    assert(isfinite(coarray_min_y(ca)));
+
+    int          i;
+    uint64_t     hash;
+    CrossSection xs;
+    PoolKey      key;
+    Constants    defaults = const_defaults();
+
+    key.ca          = ca;
+    key.y_offset    = coarray_min_y(ca);
+    key.n_roughness = n_roughness;
+    key.roughness   = roughness;
+    key.z_roughness = z_roughness;
+    key.constants   = constants ? constants : &defaults;
+
+    *y_offset = key.y_offset;
+
+    hash = pool_hash(pool, &key);
+    i    = pool_find(pool, &key, hash);
+    if (pool->slots[i])
+        return xs_ref(pool->slots[i]);
+
+    /* keep the table at most half full */
+    if (2 * (pool->n_xs + 1) > pool->n_slots) {
+        pool_grow(pool);
+        i = pool_find(pool, &key, hash);
+    }
+
+    xs = xs_new_adopt(coarray_add_y(ca, -key.y_offset),
+                      n_roughness,
+                      roughness,
+                      z_roughness,
+                      key.constants);
+
+    pool->slots[i]  = xs;
+    pool->hashes[i] = hash;
+    pool->n_xs++;
+
+    return xs_ref(xs);
+}
+
+int
+xs_pool_build_table(XSPool       pool,
+                    CrossSection xs,
+                    double       h_lo,
+                    double       h_hi,
+                    double       max_error)
+{
+    assert(pool && xs);
+
+    if (xs->table)
+        return 0;
+
+    xs_build_table(xs, h_lo, h_hi, max_error);
+
+    return 1;
+}
@@ -1,6 +1,595 @@
+#include "mem.h"
 #include <assert.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define THREAD_LOCAL __declspec(thread)
+#define COUNT_ALLOCATION() _InterlockedIncrement(&n_allocations)
+#define LOAD_N_ALLOCATIONS() _InterlockedOr(&n_allocations, 0)
+#else
+#define THREAD_LOCAL __thread
+#define COUNT_ALLOCATION()                                                     \
+    __atomic_fetch_add(&n_allocations, 1, __ATOMIC_RELAXED)
+#define LOAD_N_ALLOCATIONS() __atomic_load_n(&n_allocations, __ATOMIC_RELAXED)
+#endif
+
+#if defined(__GNUC__)
+#define NORETURN __attribute__((noreturn))
+#else
+#define NORETURN
+#endif
+
+/* alignment of arena allocations, suitable for any type */
+#define ARENA_ALIGN 16
+
+/* number of allocations made, used to check allocation budgets. The count is
+ * updated atomically because worker threads allocate. */
+static long n_allocations = 0;
+
+/* arena that the allocation functions use on the calling thread */
+static THREAD_LOCAL Arena current_arena = NULL;
+
+typedef struct ArenaBlock ArenaBlock;
+
+/* block of arena memory, the allocations follow the block header */
+struct ArenaBlock {
+    ArenaBlock *next; /* previously filled block */
+    char *      ptr;  /* start of unused memory */
+    char *      end;  /* end of the block */
+};
+
+struct Arena {
+    ArenaBlock *blocks;     /* blocks of the arena, the newest first */
+    long        block_size; /* minimum number of bytes in a block */
+    long        n_bytes;    /* bytes allocated since the last reset */
+    uintptr_t   lo;         /* lowest address of any block */
+    uintptr_t   hi;         /* end of the highest block */
+};
+
+/* each arena allocation is preceded by its size, padded to the alignment */
+typedef union {
+    long nbytes;
+    char pad[ARENA_ALIGN];
+} ArenaHeader;
+
+static NORETURN void
+allocation_failure(const char *file, int line)
+{
+    if (file == NULL)
+        fprintf(stderr, "Memory allocation failure");
+    else {
+        fprintf(stderr, "Memory allocation failure %s:%d", file, line);
+    }
+    abort();
+}
+
+/* allocation profiler
+ *
+ * Call sites and live heap allocations are kept in open addressing hash
+ * tables with linear probing. The tables are allocated with malloc()
+ * directly so that the profiler does not record itself. */
+
+/* a heap allocation that has not been freed */
+typedef struct {
+    const void *ptr;
+    long        nbytes;
+    int         site; /* index of the call site in sites */
+} LiveAllocation;
+
+static bool            profile_on     = false;
+static MemSiteStats *  sites          = NULL; /* call sites in order seen */
+static int             n_sites        = 0;
+static int             sites_capacity = 0;
+static int *           site_slots     = NULL; /* indices of sites, or -1 */
+static int             n_site_slots   = 0;
+static LiveAllocation *live           = NULL; /* ptr is NULL if empty */
+static long            n_live_slots   = 0;
+static long            n_live         = 0;
+static long            live_bytes     = 0;
+static long            max_live_bytes = 0;
+
+static size_t
+hash_pointer(const void *ptr)
+{
+    size_t h = (size_t) (uintptr_t) ptr;
+    h ^= h >> 17;
+    h *= (size_t) 0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 29);
+}
+
+/* hashes the contents of file, which may be stored at more than one address
+ * for one file name */
+static size_t
+hash_site(const char *file, int line)
+{
+    size_t h = (size_t) 14695981039346656037ULL;
+
+    for (; *file; file++) {
+        h ^= (unsigned char) *file;
+        h *= (size_t) 1099511628211ULL;
+    }
+
+    return h ^ ((size_t) line * 0x85EBCA6BU);
+}
+
+static bool
+same_site(const MemSiteStats *site, const char *file, int line)
+{
+    return site->line == line &&
+           (site->file == file || strcmp(site->file, file) == 0);
+}
+
+/* returns the index of the call site file:line, or -1 if it is not recorded */
+static int
+profile_site_find(const char *file, int line)
+{
+    size_t mask;
+    size_t i;
+
+    if (n_site_slots == 0)
+        return -1;
+
+    mask = n_site_slots - 1;
+    for (i = hash_site(file, line) & mask; site_slots[i] >= 0;
+         i = (i + 1) & mask) {
+        if (same_site(&sites[site_slots[i]], file, line))
+            return site_slots[i];
+    }
+
+    return -1;
+}
+
+static void *
+profile_calloc(long count, long nbytes)
+{
+    void *ptr = calloc(count, nbytes);
+    if (ptr == NULL)
+        allocation_failure(__FILE__, __LINE__);
+    return ptr;
+}
+
+static void
+site_slots_insert(int index)
+{
+    size_t mask = n_site_slots - 1;
+    size_t i    = hash_site(sites[index].file, sites[index].line) & mask;
+
+    while (site_slots[i] >= 0)
+        i = (i + 1) & mask;
+    site_slots[i] = index;
+}
+
+/* returns the index of the call site file:line, adding it if needed */
+static int
+profile_site_index(const char *file, int line)
+{
+    int    index = profile_site_find(file, line);
+    size_t i;
+
+    if (index >= 0)
+        return index;
+
+    if (n_sites == sites_capacity) {
+        sites_capacity = sites_capacity ? 2 * sites_capacity : 64;
+        sites          = realloc(sites, sites_capacity * sizeof(MemSiteStats));
+        if (sites == NULL)
+            allocation_failure(__FILE__, __LINE__);
+    }
+
+    index        = n_sites++;
+    sites[index] = (MemSiteStats){ file, line, 0, 0, 0, 0, 0 };
+
+    /* keep the site table at most half full */
+    if (2 * n_sites > n_site_slots) {
+        free(site_slots);
+        n_site_slots = n_site_slots ? 2 * n_site_slots : 128;
+        site_slots   = profile_calloc(n_site_slots, sizeof(int));
+        for (i = 0; i < (size_t) n_site_slots; i++)
+            site_slots[i] = -1;
+        for (int j = 0; j < n_sites; j++)
+            site_slots_insert(j);
+    } else {
+        site_slots_insert(index);
+    }
+
+    return index;
+}
+
+static void
+live_insert(LiveAllocation allocation)
+{
+    size_t mask = n_live_slots - 1;
+    size_t i    = hash_pointer(allocation.ptr) & mask;
+
+    while (live[i].ptr)
+        i = (i + 1) & mask;
+    live[i] = allocation;
+}
+
+static void
+profile_record(void *ptr, long nbytes, const char *file, int line)
+{
+    int             site = profile_site_index(file, line);
+    LiveAllocation *old_live;
+    long            old_n_slots;
+
+    sites[site].n_allocations++;
+    sites[site].n_bytes += nbytes;
+    sites[site].n_live++;
+    sites[site].live_bytes += nbytes;
+    if (sites[site].live_bytes > sites[site].max_live_bytes)
+        sites[site].max_live_bytes = sites[site].live_bytes;
+
+    live_bytes += nbytes;
+    if (live_bytes > max_live_bytes)
+        max_live_bytes = live_bytes;
+
+    /* keep the live allocation table at most half full */
+    if (2 * (n_live + 1) > n_live_slots) {
+        old_live     = live;
+        old_n_slots  = n_live_slots;
+        n_live_slots = n_live_slots ? 2 * n_live_slots : 1024;
+        live         = profile_calloc(n_live_slots, sizeof(LiveAllocation));
+        for (long i = 0; i < old_n_slots; i++) {
+            if (old_live[i].ptr)
+                live_insert(old_live[i]);
+        }
+        free(old_live);
+    }
+
+    live_insert((LiveAllocation){ ptr, nbytes, site });
+    n_live++;
+}
+
+/* stops tracking ptr if it is a recorded live allocation */
+static void
+profile_forget(const void *ptr)
+{
+    size_t mask = n_live_slots - 1;
+    size_t i    = hash_pointer(ptr) & mask;
+    size_t j;
+    size_t home;
+    int    site;
+
+    while (live[i].ptr != ptr) {
+        if (live[i].ptr == NULL)
+            return;
+        i = (i + 1) & mask;
+    }
+
+    site = live[i].site;
+    sites[site].n_live--;
+    sites[site].live_bytes -= live[i].nbytes;
+    live_bytes -= live[i].nbytes;
+    n_live--;
+
+    /* shift later entries of the probe sequence back into the hole */
+    for (j = (i + 1) & mask; live[j].ptr; j = (j + 1) & mask) {
+        home = hash_pointer(live[j].ptr) & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            live[i] = live[j];
+            i       = j;
+        }
+    }
+    live[i].ptr = NULL;
+}
+
+void
+mem_profile_enable(bool enable)
+{
+    profile_on = enable;
+}
+
+bool
+mem_profile_enabled(void)
+{
+    return profile_on;
+}
+
+void
+mem_profile_reset(void)
+{
+    free(sites);
+    free(site_slots);
+    free(live);
+
+    sites          = NULL;
+    n_sites        = 0;
+    sites_capacity = 0;
+    site_slots     = NULL;
+    n_site_slots   = 0;
+    live           = NULL;
+    n_live_slots   = 0;
+    n_live         = 0;
+    live_bytes     = 0;
+    max_live_bytes = 0;
+}
+
+bool
+mem_profile_site(const char *file, int line, MemSiteStats *stats)
+{
+    assert(file && stats);
+
+    int index = profile_site_find(file, line);
+
+    if (index < 0) {
+        *stats = (MemSiteStats){ file, line, 0, 0, 0, 0, 0 };
+        return false;
+    }
+
+    *stats = sites[index];
+
+    return true;
+}
+
+static int
+site_compare(const void *a, const void *b)
+{
+    const MemSiteStats *site_a = a;
+    const MemSiteStats *site_b = b;
+
+    return (site_a->n_bytes < site_b->n_bytes) -
+           (site_a->n_bytes > site_b->n_bytes);
+}
+
+int
+mem_profile_sites(MemSiteStats *stats, int max_sites)
+{
+    assert(max_sites == 0 || stats);
+
+    MemSiteStats *sorted;
+
+    if (n_sites == 0)
+        return 0;
+
+    sorted = profile_calloc(n_sites, sizeof(MemSiteStats));
+    memcpy(sorted, sites, n_sites * sizeof(MemSiteStats));
+    qsort(sorted, n_sites, sizeof(MemSiteStats), site_compare);
+    memcpy(stats,
+           sorted,
+           (max_sites < n_sites ? max_sites : n_sites) * sizeof(MemSiteStats));
+    free(sorted);
+
+    return n_sites;
+}
+
+void
+mem_profile_totals(MemSiteStats *totals)
+{
+    assert(totals);
+
+    *totals                = (MemSiteStats){ NULL, 0, 0, 0, 0, 0, 0 };
+    totals->n_live         = n_live;
+    totals->live_bytes     = live_bytes;
+    totals->max_live_bytes = max_live_bytes;
+    for (int i = 0; i < n_sites; i++) {
+        totals->n_allocations += sites[i].n_allocations;
+        totals->n_bytes += sites[i].n_bytes;
+    }
+}
+
+void
+mem_profile_report(FILE *stream)
+{
+    assert(stream);
+
+    int           i;
+    MemSiteStats  totals;
+    MemSiteStats *sorted;
+
+    mem_profile_totals(&totals);
+
+    fprintf(stream,
+            "%12s %14s %10s %14s %14s  %s\n",
+            "allocations",
+            "bytes",
+            "live",
+            "live bytes",
+            "max live",
+            "call site");
+
+    if (n_sites > 0) {
+        sorted = profile_calloc(n_sites, sizeof(MemSiteStats));
+        mem_profile_sites(sorted, n_sites);
+        for (i = 0; i < n_sites; i++) {
+            fprintf(stream,
+                    "%12ld %14ld %10ld %14ld %14ld  %s:%d\n",
+                    sorted[i].n_allocations,
+                    sorted[i].n_bytes,
+                    sorted[i].n_live,
+                    sorted[i].live_bytes,
+                    sorted[i].max_live_bytes,
+                    sorted[i].file,
+                    sorted[i].line);
+        }
+        free(sorted);
+    }
+
+    fprintf(stream,
+            "%12ld %14ld %10ld %14ld %14ld  total\n",
+            totals.n_allocations,
+            totals.n_bytes,
+            totals.n_live,
+            totals.live_bytes,
+            totals.max_live_bytes);
+}
+
+static long
+align_up(long nbytes)
+{
+    return (nbytes + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+}
+
+static ArenaBlock *
+arena_block_new(long nbytes, const char *file, int line)
+{
+    long        header = align_up(sizeof(ArenaBlock));
+    ArenaBlock *block;
+
+    COUNT_ALLOCATION();
+    block = malloc(header + nbytes);
+    if (block == NULL)
+        allocation_failure(file, line);
+
+    if (profile_on)
+        profile_record(block, header + nbytes, file, line);
+
+    block->next = NULL;
+    block->ptr  = (char *) block + header;
+    block->end  = block->ptr + nbytes;
+
+    return block;
+}
+
+static void
+arena_block_free(ArenaBlock *block)
+{
+    if (n_live > 0)
+        profile_forget(block);
+    free(block);
+}
+
+/* adds a new block of at least nbytes to the front of the blocks of arena */
+static void
+arena_push_block(Arena arena, long nbytes, const char *file, int line)
+{
+    ArenaBlock *block = arena_block_new(nbytes, file, line);
+
+    if (arena->blocks == NULL || (uintptr_t) block < arena->lo)
+        arena->lo = (uintptr_t) block;
+    if (arena->blocks == NULL || (uintptr_t) block->end > arena->hi)
+        arena->hi = (uintptr_t) block->end;
+
+    block->next   = arena->blocks;
+    arena->blocks = block;
+}
+
+Arena
+mem_arena_new(long block_size)
+{
+    assert(block_size > 0);
+
+    /* the arena itself is never allocated from the current arena */
+    Arena arena = malloc(sizeof(*arena));
+
+    COUNT_ALLOCATION();
+    if (arena == NULL)
+        allocation_failure(__FILE__, __LINE__);
+
+    arena->block_size = align_up(block_size);
+    arena->blocks     = NULL;
+    arena->n_bytes    = 0;
+    arena_push_block(arena, arena->block_size, __FILE__, __LINE__);
+
+    return arena;
+}
+
+void
+mem_arena_free(Arena arena)
+{
+    assert(arena);
+    assert(arena != current_arena);
+
+    ArenaBlock *block;
+
+    while (arena->blocks) {
+        block         = arena->blocks;
+        arena->blocks = block->next;
+        arena_block_free(block);
+    }
+
+    free(arena);
+}
+
+void *
+mem_arena_alloc(Arena arena, long nbytes, const char *file, int line)
+{
+    assert(arena);
+    assert(nbytes > 0);
+
+    ArenaHeader *header;
+    long         size = sizeof(ArenaHeader) + align_up(nbytes);
+
+    if (arena->blocks->end - arena->blocks->ptr < size) {
+        arena_push_block(arena,
+                         size > arena->block_size ? size : arena->block_size,
+                         file,
+                         line);
+    }
+
+    header         = (ArenaHeader *) arena->blocks->ptr;
+    header->nbytes = nbytes;
+    arena->blocks->ptr += size;
+    arena->n_bytes += size;
+
+    return header + 1;
+}
+
+void
+mem_arena_reset(Arena arena)
+{
+    assert(arena);
+
+    ArenaBlock *block;
+    long        header = align_up(sizeof(ArenaBlock));
+
+    /* replace the blocks with one block that holds everything allocated
+     * since the last reset */
+    if (arena->blocks->next) {
+        while (arena->blocks) {
+            block         = arena->blocks;
+            arena->blocks = block->next;
+            arena_block_free(block);
+        }
+        if (arena->n_bytes > arena->block_size)
+            arena->block_size = arena->n_bytes;
+        arena_push_block(arena, arena->block_size, __FILE__, __LINE__);
+    }
+
+    arena->blocks->ptr = (char *) arena->blocks + header;
+    arena->n_bytes     = 0;
+}
+
+bool
+mem_arena_owns(Arena arena, const void *ptr)
+{
+    assert(arena);
+
+    ArenaBlock *block;
+    uintptr_t   p = (uintptr_t) ptr;
+
+    /* Pointers outside the range of the blocks, such as heap memory freed
+     * while the arena is current, are rejected without visiting the blocks.
+     * A reset leaves a single block, so in steady use at most one block is
+     * visited. */
+    if (p <= arena->lo || p >= arena->hi)
+        return false;
+
+    for (block = arena->blocks; block; block = block->next) {
+        if ((uintptr_t) block < p && p < (uintptr_t) block->ptr)
+            return true;
+    }
+
+    return false;
+}
+
+Arena
+mem_arena_set_current(Arena arena)
+{
+    Arena previous = current_arena;
+    current_arena  = arena;
+    return previous;
+}
+
+Arena
+mem_arena_current(void)
+{
+    return current_arena;
+}
 
 void *
 mem_alloc(long nbytes, const char *file, int line)
@@ -9,16 +598,17 @@ mem_alloc(long nbytes, const char *file, int line)
     assert(nbytes > 0);
     void *ptr;
 
+    if (current_arena)
+        return mem_arena_alloc(current_arena, nbytes, file, line);
+
+    COUNT_ALLOCATION();
     ptr = malloc(nbytes);
 
-    if (ptr == NULL) {
-        if (file == NULL)
-            fprintf(stderr, "Memory allocation failure");
-        else {
-            fprintf(stderr, "Memory allocation failure %s:%d", file, line);
-        }
-        abort();
-    }
+    if (ptr == NULL)
+        allocation_failure(file, line);
+
+    if (profile_on)
+        profile_record(ptr, nbytes, file, line);
 
     return ptr;
 }
@@ -31,23 +621,75 @@ mem_calloc(long count, long nbytes, const char *file, int line)
 
     void *ptr;
 
+    if (current_arena) {
+        ptr = mem_arena_alloc(current_arena, count * nbytes, file, line);
+        memset(ptr, 0, count * nbytes);
+        return ptr;
+    }
+
+    COUNT_ALLOCATION();
     ptr = calloc(count, nbytes);
 
-    if (ptr == NULL) {
-        if (file == NULL)
-            fprintf(stderr, "Memory allocation failure");
-        else {
-            fprintf(stderr, "Memory allocation failure %s:%d", file, line);
-        }
-        abort();
-    }
+    if (ptr == NULL)
+        allocation_failure(file, line);
+
+    if (profile_on)
+        profile_record(ptr, count * nbytes, file, line);
 
     return ptr;
 }
 
+void *
+mem_resize(void *ptr, long nbytes, const char *file, int line)
+{
+    assert(ptr);
+    assert(nbytes > 0);
+
+    void *new_ptr;
+    long  old_nbytes;
+
+    if (current_arena && mem_arena_owns(current_arena, ptr)) {
+        old_nbytes = ((ArenaHeader *) ptr - 1)->nbytes;
+        if (nbytes <= old_nbytes)
+            return ptr;
+        new_ptr = mem_arena_alloc(current_arena, nbytes, file, line);
+        memcpy(new_ptr, ptr, old_nbytes);
+        return new_ptr;
+    }
+
+    if (n_live > 0)
+        profile_forget(ptr);
+
+    COUNT_ALLOCATION();
+    new_ptr = realloc(ptr, nbytes);
+
+    if (new_ptr == NULL)
+        allocation_failure(file, line);
+
+    if (profile_on)
+        profile_record(new_ptr, nbytes, file, line);
+
+    return new_ptr;
+}
+
 void
 mem_free(void *ptr, const char *file, int line)
 {
-    if (ptr)
-        free(ptr);
+    if (ptr == NULL)
+        return;
+
+    /* arena memory is released when the arena is reset */
+    if (current_arena && mem_arena_owns(current_arena, ptr))
+        return;
+
+    if (n_live > 0)
+        profile_forget(ptr);
+
+    free(ptr);
+}
+
+long
+mem_n_allocations(void)
+{
+    return LOAD_N_ALLOCATIONS();
 }
@@ -1,12 +1,126 @@
+#ifndef MEM_INCLUDED
+#define MEM_INCLUDED
+
+#include <stdbool.h>
+#include <stdio.h>
+
 extern void *
 mem_alloc(long nbytes, const char *file, int line);
 
 extern void *
 mem_calloc(long count, long nbytes, const char *file, int line);
 
+extern void *
+mem_resize(void *ptr, long nbytes, const char *file, int line);
+
 extern void
 mem_free(void *ptr, const char *file, int line);
 
+/* returns the number of heap allocations made: calls to mem_alloc(),
+ * mem_calloc(), and mem_resize() that were not served by an arena, and the
+ * allocations of arenas and their blocks. Calls from every thread are
+ * counted, and threads may allocate concurrently. An unchanged count means
+ * that no heap memory was allocated. */
+extern long
+mem_n_allocations(void);
+
+/* region of memory that is allocated from by bumping a pointer and is
+ * released all at once */
+typedef struct Arena *Arena;
+
+/* creates an arena that allocates blocks of at least block_size bytes from
+ * the heap as it grows */
+extern Arena
+mem_arena_new(long block_size);
+
+/* frees an arena and all of the memory allocated from it */
+extern void
+mem_arena_free(Arena arena);
+
+/* allocates nbytes from an arena, aligned for any type */
+extern void *
+mem_arena_alloc(Arena arena, long nbytes, const char *file, int line);
+
+/* releases all of the memory allocated from an arena for reuse. If the arena
+ * has grown past its first block, the blocks are replaced with a single block
+ * large enough for everything allocated since the last reset. */
+extern void
+mem_arena_reset(Arena arena);
+
+/* Returns true if ptr was allocated from an arena and the arena has not been
+ * reset since. Pointers outside the blocks of the arena are rejected with a
+ * range check, and the blocks are only visited for pointers within it. */
+extern bool
+mem_arena_owns(Arena arena, const void *ptr);
+
+/* Makes arena the current arena of the calling thread and returns the
+ * previous current arena, which may be NULL. While a thread has a current
+ * arena, mem_alloc(), mem_calloc(), and mem_resize() allocate from it and
+ * mem_free() ignores memory that it owns. Memory allocated from the arena
+ * must not be passed to mem_free() or mem_resize() after the arena stops
+ * being current. Pass NULL to allocate from the heap again. */
+extern Arena
+mem_arena_set_current(Arena arena);
+
+/* returns the current arena of the calling thread, or NULL */
+extern Arena
+mem_arena_current(void);
+
+/* allocation statistics of one call site */
+typedef struct {
+    const char *file;
+    int         line;
+    long        n_allocations;  /* heap allocations made */
+    long        n_bytes;        /* bytes allocated */
+    long        n_live;         /* allocations not yet freed */
+    long        live_bytes;     /* bytes not yet freed */
+    long        max_live_bytes; /* high-water mark of live_bytes */
+} MemSiteStats;
+
+/* Starts or stops recording heap allocations by call site. Recording is off
+ * by default and costs nothing while off. Frees of allocations recorded
+ * before recording stopped are still tracked. The profiler is not
+ * thread-safe and should only be enabled while one thread allocates. */
+extern void
+mem_profile_enable(bool enable);
+
+/* returns true if heap allocations are being recorded */
+extern bool
+mem_profile_enabled(void);
+
+/* discards all recorded statistics and stops tracking live allocations */
+extern void
+mem_profile_reset(void);
+
+/* Stores the statistics of the call site file:line in stats. Returns false
+ * and stores zeros if nothing was recorded at the call site. Call sites are
+ * identified by the contents of file, so allocations recorded with copies of
+ * a file name at different addresses belong to one call site, and
+ * max_live_bytes is the high-water mark of their combined live bytes. */
+extern bool
+mem_profile_site(const char *file, int line, MemSiteStats *stats);
+
+/* Stores the statistics of up to max_sites call sites in sites, sorted by
+ * decreasing bytes allocated, and returns the number of call sites with
+ * recorded allocations. */
+extern int
+mem_profile_sites(MemSiteStats *sites, int max_sites);
+
+/* Stores the totals over all call sites in totals, with file set to NULL and
+ * max_live_bytes the high-water mark of all live bytes. */
+extern void
+mem_profile_totals(MemSiteStats *totals);
+
+/* writes a report of the recorded statistics, sorted by decreasing bytes
+ * allocated, to stream */
+extern void
+mem_profile_report(FILE *stream);
+
 #define ALLOC(nbytes) mem_alloc((nbytes), __FILE__, __LINE__)
 #define NEW(p) ((p) = ALLOC((long) sizeof *(p)))
+#define RESIZE(ptr, nbytes) mem_resize((ptr), (nbytes), __FILE__, __LINE__)
 #define FREE(ptr) ((void) (mem_free((ptr), __FILE__, __LINE__), (ptr) = 0))
+#define ARENA_ALLOC(arena, nbytes)                                             \
+    mem_arena_alloc((arena), (nbytes), __FILE__, __LINE__)
+
+#endif
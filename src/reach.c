@@ -1,31 +1,31 @@
 #include "mem.h"
-#include "redblackbst.h"
+#include "rootsolve.h"
+#include "threadpool.h"
 #include <assert.h>
 #include <math.h>
-#include <panthera/constants.h>
 #include <panthera/reach.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 
 typedef struct ReachNode *ReachNode;
 
 struct Reach {
-    ReachNode * nodes; /* array of nodes */
-    RedBlackBST tree;  /* reach node tree */
+    ReachNode *nodes;    /* array of nodes ordered by distance downstream */
+    int        n_nodes;  /* number of nodes in the array */
+    int        capacity; /* number of nodes the array can hold */
+    bool       frozen;   /* true if the reach was created by reach_freeze() */
+    double *   x;        /* distance downstream of each node, if frozen */
+    double *   y;        /* thalweg elevation of each node, if frozen */
 };
 
-int
-key_compare_func(const void *x, const void *y)
-{
-    double x_key = *(double *) x;
-    double y_key = *(double *) y;
-
-    if (x_key < y_key)
-        return -1;
-    else if (x_key > y_key)
-        return 1;
-    else
-        return 0;
-}
+/* a node being added by reach_put_xs_many() and its position in the input */
+typedef struct {
+    ReachNode node;
+    double    x;
+    int       index;
+} NewNode;
 
 Reach
 reach_new(void)
@@ -33,8 +33,12 @@ reach_new(void)
     Reach reach;
     NEW(reach);
 
-    reach->nodes = NULL;
-    reach->tree  = redblackbst_new(&key_compare_func);
+    reach->nodes    = NULL;
+    reach->n_nodes  = 0;
+    reach->capacity = 0;
+    reach->frozen   = false;
+    reach->x        = NULL;
+    reach->y        = NULL;
 
     return reach;
 }
@@ -44,78 +48,99 @@ reach_free(Reach reach)
 {
     assert(reach);
 
-    int         n;
-    RedBlackBST tree = reach->tree;
-    n                = redblackbst_size(tree);
-
-    if (n > 0) {
-
-        void **tree_keys = mem_calloc(n, sizeof(void *), __FILE__, __LINE__);
+    for (int i = 0; i < reach->n_nodes; i++)
+        reachnode_free(reach->nodes[i]);
 
-        Item *item;
+    if (reach->nodes)
+        mem_free(reach->nodes, __FILE__, __LINE__);
+    if (reach->x)
+        mem_free(reach->x, __FILE__, __LINE__);
+    if (reach->y)
+        mem_free(reach->y, __FILE__, __LINE__);
 
-        redblackbst_keys(tree, tree_keys);
+    FREE(reach);
+}
 
-        for (int i = 0; i < n; i++) {
-            item = redblackbst_get(tree, tree_keys[i]);
-            redblackbst_delete(tree, tree_keys[i]);
-            FREE(item->key);
-            FREE(item->value);
-            redblackbst_free_item(item);
-        }
-        mem_free(tree_keys, __FILE__, __LINE__);
-    }
+/* Grows the node array of reach to hold at least capacity nodes. */
+static void
+reserve(Reach reach, int capacity)
+{
+    if (capacity <= reach->capacity)
+        return;
 
-    redblackbst_free(tree);
+    if (capacity < 2 * reach->capacity)
+        capacity = 2 * reach->capacity;
 
     if (reach->nodes)
-        mem_free(reach->nodes, __FILE__, __LINE__);
+        reach->nodes = RESIZE(reach->nodes, capacity * sizeof(ReachNode));
+    else
+        reach->nodes = ALLOC(capacity * sizeof(ReachNode));
 
-    FREE(reach);
+    reach->capacity = capacity;
 }
 
-static void
-create_array(Reach reach)
+/* Returns the index of the first node of reach that is not upstream of x. */
+static int
+lower_bound(Reach reach, double x)
 {
-    int n = redblackbst_size(reach->tree);
+    int lo = 0;
+    int hi = reach->n_nodes;
+    int mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (reachnode_x(reach->nodes[mid]) < x)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
 
-    if (n == 0)
-        return;
+    return lo;
+}
 
-    void **     keys  = mem_calloc(n, sizeof(void *), __FILE__, __LINE__);
-    ReachNode * nodes = mem_calloc(n, sizeof(ReachNode *), __FILE__, __LINE__);
-    Item *      item;
-    RedBlackBST tree;
+Reach
+reach_freeze(Reach reach)
+{
+    assert(reach);
 
-    tree = reach->tree;
+    int       i;
+    int       n = reach->n_nodes;
+    ReachNode node;
+    Reach     frozen = reach_new();
 
-    redblackbst_keys(tree, keys);
+    reserve(frozen, n);
+    if (n > 0) {
+        frozen->x = mem_calloc(n, sizeof(double), __FILE__, __LINE__);
+        frozen->y = mem_calloc(n, sizeof(double), __FILE__, __LINE__);
+    }
 
-    for (int i = 0; i < n; i++) {
-        item     = redblackbst_get(tree, keys[i]);
-        nodes[i] = (ReachNode) item->value;
-        redblackbst_free_item(item);
-        item = NULL;
+    for (i = 0; i < n; i++) {
+        node             = reach->nodes[i];
+        frozen->x[i]     = reachnode_x(node);
+        frozen->y[i]     = reachnode_y(node);
+        frozen->nodes[i] = reachnode_new(frozen->x[i],
+                                         frozen->y[i],
+                                         reachnode_xs(node));
     }
 
-    reach->nodes = nodes;
+    frozen->n_nodes = n;
+    frozen->frozen  = true;
 
-    mem_free(keys, __FILE__, __LINE__);
+    return frozen;
 }
 
-static void
-free_array(Reach reach)
+int
+reach_is_frozen(Reach reach)
 {
-    if (reach->nodes)
-        mem_free(reach->nodes, __FILE__, __LINE__);
-    reach->nodes = NULL;
+    assert(reach);
+    return reach->frozen;
 }
 
 int
 reach_size(Reach reach)
 {
     assert(reach);
-    return redblackbst_size(reach->tree);
+    return reach->n_nodes;
 }
 
 void
@@ -123,13 +148,15 @@ reach_stream_distance(Reach reach, double *x)
 {
     assert(reach && x);
 
-    if (reach->nodes == NULL)
-        create_array(reach);
-
     int       i;
-    int       n = redblackbst_size(reach->tree);
+    int       n = reach->n_nodes;
     ReachNode node;
 
+    if (reach->frozen) {
+        memcpy(x, reach->x, n * sizeof(double));
+        return;
+    }
+
     for (i = 0; i < n; i++) {
         node     = *(reach->nodes + i);
         *(x + i) = reachnode_x(node);
@@ -141,27 +168,40 @@ reach_elevation(Reach reach, double *y)
 {
     assert(reach && y);
 
-    if (reach->nodes == NULL)
-        create_array(reach);
-
     int       i;
-    int       n = redblackbst_size(reach->tree);
+    int       n = reach->n_nodes;
     ReachNode node;
 
+    if (reach->frozen) {
+        memcpy(y, reach->y, n * sizeof(double));
+        return;
+    }
+
     for (i = 0; i < n; i++) {
         node     = *(reach->nodes + i);
         *(y + i) = reachnode_y(node);
     }
 }
 
+const double *
+reach_stream_distance_data(Reach reach)
+{
+    assert(reach && reach->frozen);
+    return reach->x;
+}
+
+const double *
+reach_elevation_data(Reach reach)
+{
+    assert(reach && reach->frozen);
+    return reach->y;
+}
+
 ReachNodeProps
 reach_rnp(Reach reach, int i, double wse, double q)
 {
     assert(reach);
-    assert(0 <= i && i < redblackbst_size(reach->tree));
-
-    if (reach->nodes == NULL)
-        create_array(reach);
+    assert(0 <= i && i < reach->n_nodes);
 
     ReachNode node = *(reach->nodes + i);
 
@@ -170,25 +210,804 @@ reach_rnp(Reach reach, int i, double wse, double q)
     return rnp;
 }
 
+/* number of nodes in each block evaluated by reach_rnp_many() */
+#define RNP_BLOCK 256
+
+/* arguments of reach_rnp_many() shared by its blocks */
+typedef struct {
+    Reach         reach;
+    const double *wse;
+    const double *q;
+    RNPArrays *   out;
+} RNPData;
+
+static void
+rnp_block(int begin, int end, void *data)
+{
+    int       i;
+    double    g;
+    double    area;
+    double    velocity;
+    double    conveyance;
+    ReachNode node;
+    XSPValues xsp;
+
+    RNPData *  rnp_data = data;
+    RNPArrays *out      = rnp_data->out;
+
+    for (i = begin; i < end; i++) {
+        node = rnp_data->reach->nodes[i];
+        g    = xs_constants(reachnode_xs(node)).gravity;
+        xs_hydraulic_properties_masked(
+            reachnode_xs(node),
+            rnp_data->wse[i] - reachnode_y(node),
+            XS_MASK_AREA | XS_MASK_TOP_WIDTH | XS_MASK_HYDRAULIC_DEPTH |
+                XS_MASK_CONVEYANCE | XS_MASK_VELOCITY_COEFF,
+            &xsp);
+
+        area       = xsp.values[XS_AREA];
+        conveyance = xsp.values[XS_CONVEYANCE];
+        velocity   = rnp_data->q[i] / area;
+
+        if (out->velocity)
+            out->velocity[i] = velocity;
+        if (out->friction_slope)
+            out->friction_slope[i] =
+                rnp_data->q[i] * rnp_data->q[i] / (conveyance * conveyance);
+        if (out->velocity_head)
+            out->velocity_head[i] = xsp.values[XS_VELOCITY_COEFF] *
+                                    velocity * velocity / (2 * g);
+        if (out->area)
+            out->area[i] = area;
+        if (out->top_width)
+            out->top_width[i] = xsp.values[XS_TOP_WIDTH];
+        if (out->froude)
+            out->froude[i] =
+                velocity / sqrt(g * xsp.values[XS_HYDRAULIC_DEPTH]);
+    }
+}
+
+void
+reach_rnp_many(Reach         reach,
+               const double *wse,
+               const double *q,
+               RNPArrays *   out,
+               int           n_threads)
+{
+    assert(reach && wse && q && out);
+
+    RNPData data = { reach, wse, q, out };
+
+    threadpool_parallel_for(
+        n_threads, reach->n_nodes, RNP_BLOCK, rnp_block, &data);
+}
+
 void
 reach_put_xs(Reach reach, double x, double y, CrossSection xs)
 {
     assert(reach && xs);
-
-    double *tree_key;
+    assert(!reach->frozen);
 
     ReachNode node = reachnode_new(x, y, xs);
+    int       i    = lower_bound(reach, x);
+
+    if (i < reach->n_nodes && reachnode_x(reach->nodes[i]) == x) {
+        reachnode_free(reach->nodes[i]);
+        reach->nodes[i] = node;
+        return;
+    }
+
+    reserve(reach, reach->n_nodes + 1);
+    memmove(reach->nodes + i + 1,
+            reach->nodes + i,
+            (reach->n_nodes - i) * sizeof(ReachNode));
+    reach->nodes[i] = node;
+    reach->n_nodes++;
+}
+
+/* orders new nodes by distance downstream and then by input position */
+static int
+new_node_compare(const void *a, const void *b)
+{
+    const NewNode *node_a = a;
+    const NewNode *node_b = b;
+
+    if (node_a->x < node_b->x)
+        return -1;
+    if (node_a->x > node_b->x)
+        return 1;
+
+    return (node_a->index > node_b->index) - (node_a->index < node_b->index);
+}
+
+void
+reach_put_xs_many(Reach               reach,
+                  int                 n,
+                  const double *      x,
+                  const double *      y,
+                  const CrossSection *xs)
+{
+    assert(reach && n >= 0);
+    assert(!reach->frozen);
+
+    int        i;
+    int        j;
+    int        k;
+    int        n_new;
+    int        n_old = reach->n_nodes;
+    NewNode *  new_nodes;
+    ReachNode *old_nodes;
+
+    if (n == 0)
+        return;
+
+    assert(x && y && xs);
+
+    new_nodes = mem_calloc(n, sizeof(NewNode), __FILE__, __LINE__);
+    for (i = 0; i < n; i++) {
+        new_nodes[i].node  = reachnode_new(x[i], y[i], xs[i]);
+        new_nodes[i].x     = x[i];
+        new_nodes[i].index = i;
+    }
+
+    qsort(new_nodes, n, sizeof(NewNode), new_node_compare);
+
+    /* the last of the new nodes at a distance replaces the others */
+    for (i = 0, n_new = 0; i < n; i++) {
+        if (i + 1 < n && new_nodes[i + 1].x == new_nodes[i].x)
+            reachnode_free(new_nodes[i].node);
+        else
+            new_nodes[n_new++] = new_nodes[i];
+    }
+
+    /* merge the new nodes with the existing nodes, which are moved to a new
+     * array, replacing existing nodes at the same distances */
+    old_nodes       = reach->nodes;
+    reach->nodes    = NULL;
+    reach->n_nodes  = 0;
+    reach->capacity = 0;
+    reserve(reach, n_old + n_new);
+
+    for (i = 0, j = 0, k = 0; i < n_old || j < n_new; k++) {
+        if (j == n_new ||
+            (i < n_old && reachnode_x(old_nodes[i]) < new_nodes[j].x)) {
+            reach->nodes[k] = old_nodes[i++];
+            continue;
+        }
+
+        if (i < n_old && reachnode_x(old_nodes[i]) == new_nodes[j].x)
+            reachnode_free(old_nodes[i++]);
+        reach->nodes[k] = new_nodes[j++].node;
+    }
+
+    reach->n_nodes = k;
+
+    if (old_nodes)
+        mem_free(old_nodes, __FILE__, __LINE__);
+    mem_free(new_nodes, __FILE__, __LINE__);
+}
+
+/* standard step solver */
+#define STEP_X_TOL 1e-8
+#define STEP_MAX_ITERATIONS 100
+#define STEP_MAX_BRACKET 64
+
+typedef struct {
+    ReachNode node;      /* node being solved */
+    double    q;         /* discharge at node */
+    double    half_dx;   /* half of the distance from the previous node */
+    double    energy_bc; /* energy of the previous node less its head loss */
+} StepData;
+
+/* energy equation residual between the node being solved and the previous
+ * node */
+static double
+step_zero_deriv(double wse, void *function_data, double *deriv)
+{
+    StepData *data = (StepData *) function_data;
+    RNPValues rnp;
+    RNPValues drnp;
+
+    reachnode_properties_deriv(data->node, wse, data->q, &rnp, &drnp);
+
+    *deriv = 1 + drnp.values[RN_VELOCITY_HEAD] +
+             data->half_dx * drnp.values[RN_FRICTION_SLOPE];
+
+    return wse + rnp.values[RN_VELOCITY_HEAD] +
+           data->half_dx * rnp.values[RN_FRICTION_SLOPE] - data->energy_bc;
+}
+
+static double
+step_zero(double wse, void *function_data)
+{
+    double deriv;
+    return step_zero_deriv(wse, function_data, &deriv);
+}
+
+/* Solves the water surface elevation at node j from the water surface
+ * elevation at node i. The solution is bracketed between critical depth and
+ * a depth above it for a subcritical solution, or a depth below it for a
+ * supercritical solution. */
+static double
+step_node(ReachNode    node_j,
+          double       q_j,
+          ReachNode    node_i,
+          double       q_i,
+          double       wse_i,
+          bool         supercritical,
+          XSSolveInfo *info)
+{
+    int          n_evaluations = 0;
+    double       y_j           = reachnode_y(node_j);
+    CrossSection xs            = reachnode_xs(node_j);
+    double       h_min         = xs_min_y(xs);
+    double       h_c;
+    double       a;
+    double       b;
+    double       fa;
+    double       fb;
+    bool         bracketed = false;
+    RNPValues    rnp_i;
+    XSSolveInfo  c_info;
+    StepData     data;
+
+    RootSolution sol = { false, 0, 0, NAN, NAN };
+
+    reachnode_properties_into(node_i, wse_i, q_i, &rnp_i);
+
+    data.node      = node_j;
+    data.q         = q_j;
+    data.half_dx   = (reachnode_x(node_j) - reachnode_x(node_i)) / 2;
+    data.energy_bc = wse_i + rnp_i.values[RN_VELOCITY_HEAD] -
+                     data.half_dx * rnp_i.values[RN_FRICTION_SLOPE];
+
+    h_c = xs_critical_depth_solve(xs, q_j, NAN, &c_info);
+    n_evaluations += c_info.n_evaluations;
+
+    a  = y_j + h_c;
+    fa = step_zero(a, &data);
+    n_evaluations++;
+
+    if (fa <= 0) {
+        if (supercritical) {
+            bracketed = root_bracket_toward(&step_zero,
+                                            &data,
+                                            a,
+                                            fa,
+                                            y_j + h_min,
+                                            &b,
+                                            &fb,
+                                            STEP_MAX_BRACKET,
+                                            &n_evaluations);
+        } else {
+            b         = a + (h_c - h_min);
+            bracketed = root_bracket_up(&step_zero,
+                                        &data,
+                                        a,
+                                        fa,
+                                        &b,
+                                        &fb,
+                                        STEP_MAX_BRACKET,
+                                        &n_evaluations);
+        }
+    }
+
+    /* start from the depth of the previous node */
+    if (bracketed)
+        sol = root_newton(&step_zero_deriv,
+                          &data,
+                          a,
+                          fa,
+                          b,
+                          fb,
+                          wse_i - reachnode_y(node_i) + y_j,
+                          STEP_X_TOL,
+                          STEP_MAX_ITERATIONS);
+
+    if (info) {
+        info->converged     = sol.converged;
+        info->n_iterations  = sol.n_iterations;
+        info->n_evaluations = n_evaluations + sol.n_evaluations;
+        info->residual      = sol.residual;
+    }
+
+    return sol.x;
+}
+
+int
+reach_standard_step(Reach          reach,
+                    const double * q,
+                    double         wse_bc,
+                    reach_boundary bc_location,
+                    double *       wse,
+                    XSSolveInfo *  info)
+{
+    assert(reach && q && wse);
+
+    int  n = reach->n_nodes;
+    int  first;
+    int  direction;
+    int  i;
+    int  j;
+    int  n_solved = 0;
+    bool supercritical;
+
+    if (n == 0)
+        return 0;
 
-    Item *item = redblackbst_get(reach->tree, &x);
-    if (item) {
-        tree_key = item->key;
-        FREE(item->value);
-        redblackbst_free_item(item);
+    if (bc_location == REACH_DOWNSTREAM) {
+        first         = n - 1;
+        direction     = -1;
+        supercritical = false;
     } else {
-        tree_key  = mem_alloc(sizeof(double), __FILE__, __LINE__);
-        *tree_key = x;
+        first         = 0;
+        direction     = 1;
+        supercritical = true;
+    }
+
+    for (j = 0; j < n; j++) {
+        wse[j] = NAN;
+        if (info)
+            info[j] = (XSSolveInfo){ 0, 0, 0, NAN };
+    }
+
+    wse[first] = wse_bc;
+    if (info)
+        info[first] = (XSSolveInfo){ 1, 0, 0, 0 };
+    n_solved = 1;
+
+    for (i = first, j = first + direction; 0 <= j && j < n;
+         i = j, j += direction) {
+        wse[j] = step_node(*(reach->nodes + j),
+                           q[j],
+                           *(reach->nodes + i),
+                           q[i],
+                           wse[i],
+                           supercritical,
+                           info ? info + j : NULL);
+        if (isnan(wse[j]))
+            break;
+        n_solved++;
+    }
+
+    return n_solved;
+}
+
+/* number of profiles in each block evaluated by reach_standard_step_many() */
+#define PROFILE_BLOCK 1
+
+/* arguments of reach_standard_step_many() shared by its blocks */
+typedef struct {
+    Reach          reach;
+    const double * q;
+    const double * wse_bc;
+    reach_boundary bc_location;
+    double *       wse;
+    XSSolveInfo *  info;
+    int *          n_solved;
+} ProfileData;
+
+static void
+profile_block(int begin, int end, void *data)
+{
+    int          i;
+    int          n_solved;
+    ProfileData *p = data;
+    long         n = p->reach->n_nodes;
+
+    for (i = begin; i < end; i++) {
+        n_solved = reach_standard_step(p->reach,
+                                       p->q + i * n,
+                                       p->wse_bc[i],
+                                       p->bc_location,
+                                       p->wse + i * n,
+                                       p->info ? p->info + i * n : NULL);
+        if (p->n_solved)
+            p->n_solved[i] = n_solved;
+    }
+}
+
+void
+reach_standard_step_many(Reach          reach,
+                         int            n_profiles,
+                         const double * q,
+                         const double * wse_bc,
+                         reach_boundary bc_location,
+                         double *       wse,
+                         XSSolveInfo *  info,
+                         int *          n_solved,
+                         int            n_threads)
+{
+    assert(reach && (n_profiles == 0 || (q && wse_bc && wse)));
+
+    ProfileData data = { reach, q, wse_bc, bc_location, wse, info, n_solved };
+
+    threadpool_parallel_for(
+        n_threads, n_profiles, PROFILE_BLOCK, profile_block, &data);
+}
+
+/* simultaneous solver */
+#define SIMUL_TOL 1e-8
+#define SIMUL_MAX_ITERATIONS 50
+
+/* properties of a node used by one row of the simultaneous solution */
+typedef struct {
+    double x;          /* distance downstream */
+    double energy;     /* water surface elevation plus velocity head */
+    double d_energy;   /* derivative of energy */
+    double sf;         /* friction slope */
+    double d_sf;       /* derivative of friction slope */
+    double wse_bottom; /* lowest water surface elevation of cross section */
+} SimulNode;
+
+/* lowest water surface elevation of the cross section of a node */
+static double
+wse_bottom(ReachNode node)
+{
+    return reachnode_y(node) + xs_min_y(reachnode_xs(node));
+}
+
+static void
+simul_node(ReachNode node, double wse, double q, SimulNode *sn)
+{
+    RNPValues rnp;
+    RNPValues drnp;
+
+    reachnode_properties_deriv(node, wse, q, &rnp, &drnp);
+
+    sn->x          = reachnode_x(node);
+    sn->energy     = wse + rnp.values[RN_VELOCITY_HEAD];
+    sn->d_energy   = 1 + drnp.values[RN_VELOCITY_HEAD];
+    sn->sf         = rnp.values[RN_FRICTION_SLOPE];
+    sn->d_sf       = drnp.values[RN_FRICTION_SLOPE];
+    sn->wse_bottom = wse_bottom(node);
+}
+
+/* Computes the residual of the energy equation between an upstream and a
+ * downstream node and its derivatives with respect to the water surface
+ * elevations of the two nodes. */
+static double
+energy_row(const SimulNode *up,
+           const SimulNode *down,
+           double *         d_up,
+           double *         d_down)
+{
+    double half_dx = (down->x - up->x) / 2;
+
+    *d_up   = -up->d_energy + half_dx * up->d_sf;
+    *d_down = down->d_energy + half_dx * down->d_sf;
+
+    return down->energy - up->energy + half_dx * (up->sf + down->sf);
+}
+
+void
+reach_energy_residuals(Reach         reach,
+                       const double *wse,
+                       const double *q,
+                       double *      residual,
+                       double *      dres_dwse_lo,
+                       double *      dres_dwse_hi)
+{
+    assert(reach && wse && q && residual);
+    assert((dres_dwse_lo == NULL) == (dres_dwse_hi == NULL));
+
+    int       n = reach->n_nodes;
+    int       i;
+    double    half_dx;
+    RNPValues rnp_i;
+    RNPValues rnp_next;
+
+    SimulNode node_i;
+    SimulNode node_next;
+
+    if (n < 2)
+        return;
+
+    /* each node is evaluated once and shared by the rows on either side */
+    if (dres_dwse_lo) {
+        simul_node(*(reach->nodes + n - 1), wse[n - 1], q[n - 1], &node_next);
+        for (i = n - 2; i >= 0; i--) {
+            simul_node(*(reach->nodes + i), wse[i], q[i], &node_i);
+            residual[i] = energy_row(
+                &node_i, &node_next, dres_dwse_lo + i, dres_dwse_hi + i);
+            node_next = node_i;
+        }
+        return;
+    }
+
+    reachnode_properties_into(
+        *(reach->nodes + n - 1), wse[n - 1], q[n - 1], &rnp_next);
+    for (i = n - 2; i >= 0; i--) {
+        reachnode_properties_into(*(reach->nodes + i), wse[i], q[i], &rnp_i);
+
+        half_dx     = (rnp_next.values[RN_X] - rnp_i.values[RN_X]) / 2;
+        residual[i] = wse[i + 1] + rnp_next.values[RN_VELOCITY_HEAD] -
+                      wse[i] - rnp_i.values[RN_VELOCITY_HEAD] +
+                      half_dx * (rnp_i.values[RN_FRICTION_SLOPE] +
+                                 rnp_next.values[RN_FRICTION_SLOPE]);
+        rnp_next    = rnp_i;
+    }
+}
+
+/* Applies a Newton step to a water surface elevation. The step is limited to
+ * between halving and doubling the depth of the node, which keeps the water
+ * surface above the bottom of the cross section and keeps the linearization
+ * from extrapolating far from the current estimate on long reaches. */
+static double
+simul_update(double wse, double dy, double wse_bottom)
+{
+    double depth = wse - wse_bottom;
+
+    if (dy < -0.5 * depth)
+        dy = -0.5 * depth;
+    else if (dy > depth)
+        dy = depth;
+
+    return wse + dy;
+}
+
+int
+reach_simultaneous(Reach         reach,
+                   const double *q,
+                   double        wse_bc,
+                   double *      wse,
+                   XSSolveInfo * info)
+{
+    assert(reach && q && wse);
+
+    int    n = reach->n_nodes;
+    int    i;
+    int    iteration;
+    int    n_evaluations = 0;
+    bool   converged     = false;
+    double depth_bc;
+    double f;       /* energy equation residual */
+    double f_max;   /* largest absolute residual of an iteration */
+    double diag;    /* derivative of residual with respect to wse[i] */
+    double upper;   /* derivative of residual with respect to wse[i + 1] */
+    double dy;      /* Newton step of wse[i] */
+    double dy_next; /* Newton step of wse[i + 1] */
+
+    SimulNode node_i;
+    SimulNode node_next;
+
+    if (n == 0) {
+        if (info)
+            *info = (XSSolveInfo){ 1, 0, 0, 0 };
+        return 1;
+    }
+
+    depth_bc = wse_bc - reachnode_y(*(reach->nodes + n - 1));
+    for (i = 0; i < n; i++)
+        wse[i] = reachnode_y(*(reach->nodes + i)) + depth_bc;
+
+    for (iteration = 1; iteration <= SIMUL_MAX_ITERATIONS; iteration++) {
+
+        /* boundary condition row */
+        f_max   = fabs(wse[n - 1] - wse_bc);
+        dy_next = wse_bc - wse[n - 1];
+
+        simul_node(*(reach->nodes + n - 1), wse[n - 1], q[n - 1], &node_next);
+        n_evaluations++;
+        wse[n - 1] = wse_bc;
+
+        /* each row i depends on wse[i] and wse[i + 1], so the system is
+         * solved by back substitution while sweeping upstream */
+        for (i = n - 2; i >= 0; i--) {
+            simul_node(*(reach->nodes + i), wse[i], q[i], &node_i);
+            n_evaluations++;
+
+            f = energy_row(&node_i, &node_next, &diag, &upper);
+
+            if (fabs(f) > f_max || isnan(f))
+                f_max = fabs(f);
+
+            dy        = -(f + upper * dy_next) / diag;
+            wse[i]    = simul_update(wse[i], dy, node_i.wse_bottom);
+            dy_next   = dy;
+            node_next = node_i;
+        }
+
+        if (isnan(f_max))
+            break;
+
+        if (f_max < SIMUL_TOL) {
+            converged = true;
+            break;
+        }
+    }
+
+    if (iteration > SIMUL_MAX_ITERATIONS)
+        iteration = SIMUL_MAX_ITERATIONS;
+
+    if (info) {
+        info->converged     = converged;
+        info->n_iterations  = iteration;
+        info->n_evaluations = n_evaluations;
+        info->residual      = f_max;
+    }
+
+    return converged;
+}
+
+/* boundary value solver */
+#define BV_MIN_LAMBDA 1e-9
+
+/* Returns the sum of squared energy residuals of a profile with the discharge
+ * of every node in qs, or NAN if a residual cannot be computed. */
+static double
+bv_residual_norm(Reach         reach,
+                 const double *wse,
+                 const double *qs,
+                 double *      residual,
+                 int *         n_evaluations)
+{
+    int    i;
+    int    n      = reach->n_nodes;
+    double f_norm = 0;
+
+    reach_energy_residuals(reach, wse, qs, residual, NULL, NULL);
+    *n_evaluations += n;
+
+    for (i = 0; i < n - 1; i++)
+        f_norm += residual[i] * residual[i];
+
+    return f_norm;
+}
+
+/* Returns the largest fraction of step, not more than lambda, that does not
+ * double or halve value. */
+static double
+step_limit(double lambda, double step, double value)
+{
+    if (step * lambda > value)
+        return value / step;
+    if (step * lambda < -0.5 * value)
+        return -0.5 * value / step;
+
+    return lambda;
+}
+
+int
+reach_boundary_value(Reach reach, double *wse, double *q, XSSolveInfo *info)
+{
+    assert(reach && wse && q);
+
+    int    n = reach->n_nodes;
+    int    i;
+    int    iteration;
+    int    n_evaluations = 0;
+    bool   converged     = false;
+    double f_max;   /* largest absolute residual of an iteration */
+    double f_norm;  /* sum of squared residuals of an iteration */
+    double d_q;     /* derivative of residual with respect to discharge */
+    double dq;      /* Newton step of discharge */
+    double alpha;   /* Newton step of wse[i + 1] is alpha + beta * dq */
+    double beta;
+    double q_i;     /* discharge at the start of an iteration */
+    double lambda;  /* fraction of the Newton step taken */
+    double *residual;
+    double *diag;   /* derivatives of residuals with respect to wse[i] */
+    double *upper;  /* derivatives of residuals with respect to wse[i + 1] */
+    double *alphas;
+    double *betas;
+    double *wse_i;  /* water surface elevations at the start of an iteration */
+    double *qs;     /* discharge of each node */
+
+    assert(n >= 2);
+
+    if (!(*q > 0)) {
+        if (info)
+            *info = (XSSolveInfo){ 0, 0, 0, NAN };
+        return 0;
+    }
+
+    /* the Newton step of each unknown water surface elevation is a linear
+     * function of the discharge step, alphas[i] + betas[i] * dq */
+    residual = mem_calloc(7 * n, sizeof(double), __FILE__, __LINE__);
+    diag     = residual + n;
+    upper    = diag + n;
+    alphas   = upper + n;
+    betas    = alphas + n;
+    wse_i    = betas + n;
+    qs       = wse_i + n;
+
+    for (iteration = 1; iteration <= SIMUL_MAX_ITERATIONS; iteration++) {
+
+        q_i    = *q;
+        f_max  = 0;
+        f_norm = 0;
+
+        for (i = 0; i < n; i++)
+            qs[i] = q_i;
+
+        reach_energy_residuals(reach, wse, qs, residual, diag, upper);
+        n_evaluations += n;
+
+        for (i = 0; i < n - 1; i++) {
+            if (fabs(residual[i]) > f_max || isnan(residual[i]))
+                f_max = fabs(residual[i]);
+            f_norm += residual[i] * residual[i];
+        }
+
+        /* wse[n - 1] is known */
+        alpha = 0;
+        beta  = 0;
+
+        /* each row i depends on wse[i], wse[i + 1], and discharge, so the
+         * steps are expressed in terms of the discharge step while sweeping
+         * upstream, and row 0 determines the discharge step */
+        for (i = n - 2; i > 0; i--) {
+            /* velocity head and friction slope are proportional to the
+             * square of discharge */
+            d_q = 2 * (residual[i] - (wse[i + 1] - wse[i])) / q_i;
+
+            alphas[i] = -(residual[i] + upper[i] * alpha) / diag[i];
+            betas[i]  = -(d_q + upper[i] * beta) / diag[i];
+
+            alpha = alphas[i];
+            beta  = betas[i];
+        }
+
+        d_q = 2 * (residual[0] - (wse[1] - wse[0])) / q_i;
+        dq  = -(residual[0] + upper[0] * alpha) / (d_q + upper[0] * beta);
+
+        if (isnan(f_max) || isnan(dq))
+            break;
+
+        if (f_max < SIMUL_TOL)
+            converged = true;
+
+        /* scale the step so that discharge and the depth at each node are
+         * not more than doubled or less than halved */
+        lambda = step_limit(1, dq, q_i);
+        for (i = 1; i < n - 1; i++) {
+            wse_i[i] = wse[i];
+            lambda   = step_limit(lambda,
+                                alphas[i] + betas[i] * dq,
+                                wse[i] - wse_bottom(*(reach->nodes + i)));
+        }
+
+        /* halve the step until the sum of squared residuals decreases */
+        while (lambda >= BV_MIN_LAMBDA) {
+            *q = q_i + lambda * dq;
+            for (i = 0; i < n; i++)
+                qs[i] = *q;
+            for (i = 1; i < n - 1; i++)
+                wse[i] = wse_i[i] + lambda * (alphas[i] + betas[i] * dq);
+
+            if (converged ||
+                bv_residual_norm(reach, wse, qs, residual, &n_evaluations) <
+                    (1 - 1e-4 * lambda) * f_norm)
+                break;
+
+            lambda /= 2;
+        }
+
+        if (converged)
+            break;
+
+        /* the residuals cannot be reduced along the Newton direction, so
+         * the estimate from the start of the iteration is returned */
+        if (lambda < BV_MIN_LAMBDA) {
+            *q = q_i;
+            for (i = 1; i < n - 1; i++)
+                wse[i] = wse_i[i];
+            break;
+        }
+    }
+
+    mem_free(residual, __FILE__, __LINE__);
+
+    if (iteration > SIMUL_MAX_ITERATIONS)
+        iteration = SIMUL_MAX_ITERATIONS;
+
+    if (info) {
+        info->converged     = converged;
+        info->n_iterations  = iteration;
+        info->n_evaluations = n_evaluations;
+        info->residual      = f_max;
     }
 
-    redblackbst_put(reach->tree, tree_key, node);
-    free_array(reach);
+    return converged;
 }
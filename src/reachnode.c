@@ -1,10 +1,9 @@
 #include "mem.h"
 #include <assert.h>
-#include <panthera/constants.h>
 #include <panthera/reachnode.h>
 
 struct ReachNodeProps {
-    double *properties;
+    RNPValues values;
 };
 
 static ReachNodeProps
@@ -12,7 +11,6 @@ rnp_new(void)
 {
     ReachNodeProps rnp;
     NEW(rnp);
-    rnp->properties = mem_calloc(N_RN, sizeof(double), __FILE__, __LINE__);
     return rnp;
 }
 
@@ -20,27 +18,20 @@ void
 rnp_free(ReachNodeProps rnp)
 {
     assert(rnp);
-    mem_free(rnp->properties, __FILE__, __LINE__);
     FREE(rnp);
 }
 
-static void
-rnp_set(ReachNodeProps rnp, rn_prop prop, double value)
-{
-    assert(rnp);
-    *(rnp->properties + prop) = value;
-}
-
 double
 rnp_get(ReachNodeProps rnp, rn_prop prop)
 {
     assert(rnp);
-    return *(rnp->properties + prop);
+    return rnp->values.values[prop];
 }
 
 struct ReachNode {
-    double       x; /* distance downstream */
-    double       y; /* thalweg elevation */
+    double       x;       /* distance downstream */
+    double       y;       /* thalweg elevation */
+    double       gravity; /* acceleration due to gravity of xs */
     CrossSection xs;
 };
 
@@ -53,9 +44,10 @@ reachnode_new(double x, double y, CrossSection xs)
     ReachNode node;
     NEW(node);
 
-    node->x  = x;
-    node->y  = y;
-    node->xs = xs;
+    node->x       = x;
+    node->y       = y;
+    node->gravity = xs_constants(xs).gravity;
+    node->xs      = xs;
 
     return node;
 }
@@ -81,6 +73,13 @@ reachnode_y(ReachNode node)
     return node->y;
 }
 
+CrossSection
+reachnode_xs(ReachNode node)
+{
+    assert(node);
+    return node->xs;
+}
+
 CrossSectionProps
 reachnode_xsp(ReachNode node, double y)
 {
@@ -89,30 +88,89 @@ reachnode_xsp(ReachNode node, double y)
     return xs_hydraulic_properties(node->xs, h);
 }
 
-ReachNodeProps
-reachnode_properties(ReachNode node, double wse, double q)
+void
+reachnode_properties_into(ReachNode node, double wse, double q, RNPValues *rnp)
 {
-    assert(node);
+    assert(node && rnp);
+
+    XSPValues xsp;
+    xs_hydraulic_properties_masked(node->xs,
+                                   wse - node->y,
+                                   XS_MASK_AREA | XS_MASK_CONVEYANCE |
+                                       XS_MASK_VELOCITY_COEFF,
+                                   &xsp);
 
-    CrossSectionProps xsp            = reachnode_xsp(node, wse);
-    double            area           = xsp_get(xsp, XS_AREA);
-    double            conveyance     = xsp_get(xsp, XS_CONVEYANCE);
-    double            velocity_coeff = xsp_get(xsp, XS_VELOCITY_COEFF);
-    xsp_free(xsp);
+    double area           = xsp.values[XS_AREA];
+    double conveyance     = xsp.values[XS_CONVEYANCE];
+    double velocity_coeff = xsp.values[XS_VELOCITY_COEFF];
 
     double velocity       = q / area;
     double friction_slope = (q * q) / (conveyance * conveyance);
     double velocity_head =
-        velocity_coeff * velocity * velocity / (2 * const_gravity());
+        velocity_coeff * velocity * velocity / (2 * node->gravity);
+
+    rnp->values[RN_X]              = node->x;
+    rnp->values[RN_Y]              = node->y;
+    rnp->values[RN_WSE]            = wse;
+    rnp->values[RN_DISCHARGE]      = q;
+    rnp->values[RN_VELOCITY]       = velocity;
+    rnp->values[RN_FRICTION_SLOPE] = friction_slope;
+    rnp->values[RN_VELOCITY_HEAD]  = velocity_head;
+}
+
+void
+reachnode_properties_deriv(ReachNode  node,
+                           double     wse,
+                           double     q,
+                           RNPValues *rnp,
+                           RNPValues *drnp)
+{
+    assert(node && rnp && drnp);
+
+    XSPValues xsp;
+    XSPValues dxsp;
+    xs_hydraulic_properties_deriv(node->xs, wse - node->y, &xsp, &dxsp);
+
+    double g              = node->gravity;
+    double area           = xsp.values[XS_AREA];
+    double top_width      = xsp.values[XS_TOP_WIDTH];
+    double conveyance     = xsp.values[XS_CONVEYANCE];
+    double velocity_coeff = xsp.values[XS_VELOCITY_COEFF];
+    double d_conveyance   = dxsp.values[XS_CONVEYANCE];
+    double d_vel_coeff    = dxsp.values[XS_VELOCITY_COEFF];
+
+    double velocity       = q / area;
+    double friction_slope = (q * q) / (conveyance * conveyance);
+    double velocity_head  = velocity_coeff * velocity * velocity / (2 * g);
+
+    rnp->values[RN_X]              = node->x;
+    rnp->values[RN_Y]              = node->y;
+    rnp->values[RN_WSE]            = wse;
+    rnp->values[RN_DISCHARGE]      = q;
+    rnp->values[RN_VELOCITY]       = velocity;
+    rnp->values[RN_FRICTION_SLOPE] = friction_slope;
+    rnp->values[RN_VELOCITY_HEAD]  = velocity_head;
+
+    /* dA/dwse is the top width */
+    drnp->values[RN_X]              = 0;
+    drnp->values[RN_Y]              = 0;
+    drnp->values[RN_WSE]            = 1;
+    drnp->values[RN_DISCHARGE]      = 0;
+    drnp->values[RN_VELOCITY]       = -velocity * top_width / area;
+    drnp->values[RN_FRICTION_SLOPE] = -2 * friction_slope * d_conveyance /
+                                      conveyance;
+    drnp->values[RN_VELOCITY_HEAD] =
+        velocity * velocity / (2 * g) *
+        (d_vel_coeff - 2 * velocity_coeff * top_width / area);
+}
+
+ReachNodeProps
+reachnode_properties(ReachNode node, double wse, double q)
+{
+    assert(node);
 
     ReachNodeProps rnp = rnp_new();
-    rnp_set(rnp, RN_X, reachnode_x(node));
-    rnp_set(rnp, RN_Y, reachnode_y(node));
-    rnp_set(rnp, RN_WSE, wse);
-    rnp_set(rnp, RN_DISCHARGE, q);
-    rnp_set(rnp, RN_VELOCITY, velocity);
-    rnp_set(rnp, RN_FRICTION_SLOPE, friction_slope);
-    rnp_set(rnp, RN_VELOCITY_HEAD, velocity_head);
+    reachnode_properties_into(node, wse, q, &rnp->values);
 
     return rnp;
 }
@@ -21,11 +21,53 @@ struct TreeNode {
     TreeNode *r; /* right */
 };
 
+/* first and largest number of tree nodes in a slab of the node pool */
+#define SLAB_MIN_NODES 16
+#define SLAB_MAX_NODES 1024
+
+/* block of tree nodes allocated together */
+typedef struct Slab Slab;
+
+struct Slab {
+    Slab *   next;
+    int      n_nodes;
+    TreeNode nodes[];
+};
+
+struct RedBlackBST {
+    TreeNode *     root;
+    KeyCompareFunc compare_func;
+    Slab *         slabs;     /* slabs of the node pool, newest first */
+    int            slab_used; /* nodes handed out from the newest slab */
+    TreeNode *     free_list; /* released nodes, linked through l */
+};
+
 static TreeNode *
-tree_node_new(const void *key, void *value)
+tree_node_new(RedBlackBST tree, const void *key, void *value)
 {
     TreeNode *node;
-    NEW(node);
+    Slab *    slab;
+    int       n_nodes;
+
+    if (tree->free_list) {
+        node            = tree->free_list;
+        tree->free_list = node->l;
+    } else {
+        if (tree->slabs == NULL || tree->slab_used == tree->slabs->n_nodes) {
+            n_nodes = tree->slabs ? 2 * tree->slabs->n_nodes : SLAB_MIN_NODES;
+            if (n_nodes > SLAB_MAX_NODES)
+                n_nodes = SLAB_MAX_NODES;
+
+            slab = ALLOC((long) (sizeof(Slab) + n_nodes * sizeof(TreeNode)));
+
+            slab->next      = tree->slabs;
+            slab->n_nodes   = n_nodes;
+            tree->slabs     = slab;
+            tree->slab_used = 0;
+        }
+        node = tree->slabs->nodes + tree->slab_used++;
+    }
+
     node->size  = 1;
     node->color = RED;
     node->key   = key;
@@ -35,20 +77,12 @@ tree_node_new(const void *key, void *value)
     return node;
 }
 
+/* returns a node to the pool of tree */
 static void
-tree_node_free(TreeNode *node)
+tree_node_free(RedBlackBST tree, TreeNode *node)
 {
-    FREE(node);
-}
-
-static void
-tree_free(TreeNode *node)
-{
-    if (node) {
-        tree_free(node->l);
-        tree_free(node->r);
-        tree_node_free(node);
-    }
+    node->l         = tree->free_list;
+    tree->free_list = node;
 }
 
 static int
@@ -82,17 +116,20 @@ static TreeNode *
 tree_get(TreeNode *node, KeyCompareFunc compare_func, const void *key)
 {
     assert(compare_func && key);
-    if (node == NULL)
-        return NULL;
 
-    int cmp = compare_func(key, node->key);
+    int cmp;
 
-    if (cmp < 0)
-        return tree_get(node->l, compare_func, key);
-    else if (cmp > 0)
-        return tree_get(node->r, compare_func, key);
-    else
-        return node;
+    while (node) {
+        cmp = compare_func(key, node->key);
+        if (cmp < 0)
+            node = node->l;
+        else if (cmp > 0)
+            node = node->r;
+        else
+            return node;
+    }
+
+    return NULL;
 }
 
 static bool
@@ -205,36 +242,38 @@ tree_move_red_right(TreeNode *node)
 
 /* delete the node with the minimum x rooted at node */
 static TreeNode *
-tree_delete_min(TreeNode *node)
+tree_delete_min(RedBlackBST tree, TreeNode *node)
 {
 
     if (node->l == NULL) {
-        tree_node_free(node);
+        tree_node_free(tree, node);
         return NULL;
     }
 
     if (!tree_is_red(node->l) && !tree_is_red(node->l->l))
         node = tree_move_red_left(node);
 
-    node->l = tree_delete_min(node->l);
+    node->l = tree_delete_min(tree, node->l);
     return tree_balance(node);
 }
 
 /* delete the node with the given key rooted at node */
 static TreeNode *
-tree_delete(TreeNode *node, KeyCompareFunc compare_func, const void *key)
+tree_delete(RedBlackBST tree, TreeNode *node, const void *key)
 {
+    KeyCompareFunc compare_func = tree->compare_func;
+
     assert(tree_get(node, compare_func, key) != NULL);
 
     if (compare_func(key, node->key) < 0) {
         if (!tree_is_red(node->l) && !tree_is_red(node->l->l))
             node = tree_move_red_left(node);
-        node->l = tree_delete(node->l, compare_func, key);
+        node->l = tree_delete(tree, node->l, key);
     } else {
         if (tree_is_red(node->l))
             node = tree_rotate_right(node);
         if (compare_func(key, node->key) == 0 && node->r == NULL) {
-            tree_node_free(node);
+            tree_node_free(tree, node);
             return NULL;
         }
         if (!tree_is_red(node->r) && !tree_is_red(node->r->l))
@@ -244,9 +283,9 @@ tree_delete(TreeNode *node, KeyCompareFunc compare_func, const void *key)
             node->key       = min_r->key;
             node->value     = min_r->value;
             min_r->value    = NULL;
-            node->r         = tree_delete_min(node->r);
+            node->r         = tree_delete_min(tree, node->r);
         } else
-            node->r = tree_delete(node->r, compare_func, key);
+            node->r = tree_delete(tree, node->r, key);
     }
     return tree_balance(node);
 }
@@ -263,21 +302,20 @@ tree_keys(TreeNode *node, int i, void **key_array)
 }
 
 static TreeNode *
-tree_put(TreeNode *     node,
-         KeyCompareFunc compare_func,
-         const void *   key,
-         void *         value)
+tree_put(RedBlackBST tree, TreeNode *node, const void *key, void *value)
 {
     if (!node)
-        return tree_node_new(key, value);
+        return tree_node_new(tree, key, value);
 
-    if (compare_func(key, node->key) < 0)
-        node->l = tree_put(node->l, compare_func, key, value);
-    else if (compare_func(key, node->key) > 0)
-        node->r = tree_put(node->r, compare_func, key, value);
+    int cmp = tree->compare_func(key, node->key);
+
+    if (cmp < 0)
+        node->l = tree_put(tree, node->l, key, value);
+    else if (cmp > 0)
+        node->r = tree_put(tree, node->r, key, value);
     else {
-        /* should not be reached */
-        assert(true);
+        node->key   = key;
+        node->value = value;
     }
 
     /* fix any right-leaning links */
@@ -291,11 +329,6 @@ tree_put(TreeNode *     node,
     return node;
 }
 
-struct RedBlackBST {
-    TreeNode *     root;
-    KeyCompareFunc compare_func;
-};
-
 RedBlackBST
 redblackbst_new(KeyCompareFunc compare_func)
 {
@@ -304,6 +337,9 @@ redblackbst_new(KeyCompareFunc compare_func)
     NEW(tree);
     tree->root         = NULL;
     tree->compare_func = compare_func;
+    tree->slabs        = NULL;
+    tree->slab_used    = 0;
+    tree->free_list    = NULL;
     return tree;
 }
 
@@ -311,7 +347,15 @@ void
 redblackbst_free(RedBlackBST tree)
 {
     assert(tree);
-    tree_free(tree->root);
+
+    Slab *slab;
+
+    while (tree->slabs) {
+        slab        = tree->slabs;
+        tree->slabs = slab->next;
+        FREE(slab);
+    }
+
     FREE(tree);
 }
 
@@ -364,11 +408,19 @@ redblackbst_get(RedBlackBST tree, const void *key)
     return item;
 }
 
+void *
+redblackbst_get_value(RedBlackBST tree, const void *key)
+{
+    assert(tree && key);
+    TreeNode *node = tree_get(tree->root, tree->compare_func, key);
+    return node ? node->value : NULL;
+}
+
 void
 redblackbst_put(RedBlackBST tree, const void *key, void *value)
 {
     assert(tree && key && value);
-    tree->root        = tree_put(tree->root, tree->compare_func, key, value);
+    tree->root        = tree_put(tree, tree->root, key, value);
     tree->root->color = BLACK;
 }
 
@@ -390,7 +442,7 @@ redblackbst_delete(RedBlackBST tree, const void *key)
     if (!tree_is_red(tree->root->l) && !tree_is_red(tree->root->r))
         tree->root->color = RED;
 
-    tree->root = tree_delete(tree->root, tree->compare_func, key);
+    tree->root = tree_delete(tree, tree->root, key);
     if (redblackbst_size(tree) > 0)
         tree->root->color = BLACK;
 }
@@ -401,3 +453,64 @@ redblackbst_keys(RedBlackBST tree, void **keys)
     assert(tree && keys);
     tree_keys(tree->root, 0, keys);
 }
+
+/* pushes node and the chain of left children of node that are not below lo
+ * onto the stack of cursor */
+static void
+cursor_push_left(RedBlackBSTCursor *cursor, TreeNode *node)
+{
+    while (node) {
+        if (cursor->lo && cursor->compare_func(node->key, cursor->lo) < 0) {
+            node = node->r;
+            continue;
+        }
+        assert(cursor->depth < REDBLACKBST_MAX_HEIGHT);
+        cursor->stack[cursor->depth++] = node;
+        node                           = node->l;
+    }
+}
+
+void
+redblackbst_cursor_init(RedBlackBST        tree,
+                        RedBlackBSTCursor *cursor,
+                        const void *       lo,
+                        const void *       hi)
+{
+    assert(tree && cursor);
+
+    cursor->compare_func = tree->compare_func;
+    cursor->lo           = lo;
+    cursor->hi           = hi;
+    cursor->depth        = 0;
+
+    cursor_push_left(cursor, tree->root);
+}
+
+bool
+redblackbst_cursor_next(RedBlackBSTCursor *cursor,
+                        const void **      key,
+                        void **            value)
+{
+    assert(cursor);
+
+    TreeNode *node;
+
+    if (cursor->depth == 0)
+        return false;
+
+    node = cursor->stack[--cursor->depth];
+
+    if (cursor->hi && cursor->compare_func(node->key, cursor->hi) > 0) {
+        cursor->depth = 0;
+        return false;
+    }
+
+    cursor_push_left(cursor, node->r);
+
+    if (key)
+        *key = node->key;
+    if (value)
+        *value = node->value;
+
+    return true;
+}
@@ -44,11 +44,41 @@ typedef struct {
     void *value;
 } Item;
 
+/**
+ * REDBLACKBST_MAX_HEIGHT:
+ *
+ * Upper bound of the height of a #RedBlackBST, which is at most twice the
+ * base 2 logarithm of the number of items
+ */
+#define REDBLACKBST_MAX_HEIGHT 64
+
+/**
+ * RedBlackBSTCursor:
+ * @compare_func: the #KeyCompareFunc of the tree
+ * @lo:           lower bound of the keys visited, or `NULL`
+ * @hi:           upper bound of the keys visited, or `NULL`
+ * @depth:        number of tree nodes on @stack
+ * @stack:        tree nodes that remain to be visited
+ *
+ * In-order cursor over the items of a #RedBlackBST. A cursor is usually
+ * declared on the stack and is initialized with redblackbst_cursor_init().
+ * The members should not be accessed directly.
+ */
+typedef struct {
+    KeyCompareFunc   compare_func;
+    const void *     lo;
+    const void *     hi;
+    int              depth;
+    struct TreeNode *stack[REDBLACKBST_MAX_HEIGHT];
+} RedBlackBSTCursor;
+
 /**
  * redblackbst_new:
  * @compare_func: a #KeyCompareFunc
  *
  * Creates a new #RedBlackBST. The tree must be freed with redblackbst_free().
+ * The nodes of the tree are taken from a pool owned by the tree, which is
+ * grown in slabs of nodes, and nodes of deleted items are reused.
  *
  * Returns: a new search tree
  */
@@ -59,7 +89,9 @@ redblackbst_new(KeyCompareFunc compare_func);
  * redblackbst_free:
  * @tree: a #RedBlackBST
  *
- * Frees @tree, does not free the keys or the values contained in @tree.
+ * Frees @tree and its node pool, does not free the keys or the values
+ * contained in @tree. The time taken is proportional to the number of slabs
+ * in the pool.
  *
  * Returns: none
  */
@@ -112,13 +144,27 @@ redblackbst_max_key(RedBlackBST tree);
  * If @key is matches a key contained in @tree, then this function returns an
  * #Item with references to the key, value pair contained in the tree node. The
  * returned item is newly created and must be freed with
- * redblackbst_free_item().
+ * redblackbst_free_item(). Use redblackbst_get_value() to look up a value
+ * without allocating memory.
  *
  * Returns: an item with references to a key, value pair
  */
 extern Item *
 redblackbst_get(RedBlackBST tree, const void *key);
 
+/**
+ * redblackbst_get_value:
+ * @tree: a #RedBlackBST
+ * @key: a key
+ *
+ * Looks up @key in @tree without allocating memory.
+ *
+ * Returns: the value of the item in @tree with a key equal to @key, or `NULL`
+ * if @tree does not contain @key
+ */
+extern void *
+redblackbst_get_value(RedBlackBST tree, const void *key);
+
 /**
  * redblackbst_put:
  * @tree: a #RedBlackBST
@@ -167,10 +213,46 @@ redblackbst_delete(RedBlackBST tree, const void *key);
  * Fills @keys with references to the keys contained in @tree. `keys` must be
  * previously allocated with the number of elements equal to the number of
  * items in @tree. Use redblackbst_size() to get the number of items in @tree.
+ * Use a #RedBlackBSTCursor to visit the items without copying the keys.
  *
  * Returns: None
  */
 extern void
 redblackbst_keys(RedBlackBST tree, void **keys);
 
+/**
+ * redblackbst_cursor_init:
+ * @tree:   a #RedBlackBST
+ * @cursor: location of the cursor to initialize
+ * @lo:     lower bound of the keys to visit, or `NULL` for no lower bound
+ * @hi:     upper bound of the keys to visit, or `NULL` for no upper bound
+ *
+ * Initializes @cursor to visit the items of @tree with keys between @lo and
+ * @hi, inclusive, in key order. The cursor keeps the path to the next item on
+ * a fixed-size stack and no memory is allocated. Putting or deleting items in
+ * @tree invalidates @cursor.
+ *
+ * Returns: None
+ */
+extern void
+redblackbst_cursor_init(RedBlackBST        tree,
+                        RedBlackBSTCursor *cursor,
+                        const void *       lo,
+                        const void *       hi);
+
+/**
+ * redblackbst_cursor_next:
+ * @cursor: a #RedBlackBSTCursor
+ * @key:    location to store the key of the next item, or `NULL`
+ * @value:  location to store the value of the next item, or `NULL`
+ *
+ * Advances @cursor to the next item in key order.
+ *
+ * Returns: true if an item was visited, false if no items remain
+ */
+extern bool
+redblackbst_cursor_next(RedBlackBSTCursor *cursor,
+                        const void **      key,
+                        void **            value);
+
 #endif
@@ -0,0 +1,293 @@
+#include "rootsolve.h"
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+
+static inline bool
+same_sign(double f_1, double f_2)
+{
+    return (f_1 > 0 && f_2 > 0) || (f_1 < 0 && f_2 < 0);
+}
+
+/* Returns a solution at an end of the bracket if the function is zero there.
+ * Returns a solution that has not converged if the bracket is not valid. */
+static bool
+check_bracket(double a, double fa, double b, double fb, RootSolution *sol)
+{
+    if (fa == 0) {
+        sol->converged = true;
+        sol->x         = a;
+        sol->residual  = fa;
+        return false;
+    }
+
+    if (fb == 0) {
+        sol->converged = true;
+        sol->x         = b;
+        sol->residual  = fb;
+        return false;
+    }
+
+    if (isnan(a) || isnan(b) || isnan(fa) || isnan(fb) || same_sign(fa, fb))
+        return false;
+
+    return true;
+}
+
+bool
+root_bracket_up(RootFunc func,
+                void *   func_data,
+                double   a,
+                double   fa,
+                double * b,
+                double * fb,
+                int      max_expand,
+                int *    n_evaluations)
+{
+    assert(func && b && fb && n_evaluations);
+
+    int    i;
+    double width = *b - a;
+
+    if (!(width > 0))
+        return false;
+
+    *fb = func(*b, func_data);
+    (*n_evaluations)++;
+
+    for (i = 0; i < max_expand && same_sign(fa, *fb); i++) {
+        width *= 2;
+        *b  = a + width;
+        *fb = func(*b, func_data);
+        (*n_evaluations)++;
+    }
+
+    return !isnan(*fb) && !same_sign(fa, *fb);
+}
+
+bool
+root_bracket_toward(RootFunc func,
+                    void *   func_data,
+                    double   a,
+                    double   fa,
+                    double   limit,
+                    double * b,
+                    double * fb,
+                    int      max_steps,
+                    int *    n_evaluations)
+{
+    assert(func && b && fb && n_evaluations);
+
+    int i;
+
+    *b  = a;
+    *fb = fa;
+
+    for (i = 0; i < max_steps; i++) {
+        *b  = limit + 0.5 * (*b - limit);
+        *fb = func(*b, func_data);
+        (*n_evaluations)++;
+
+        if (isnan(*fb))
+            return false;
+        if (!same_sign(fa, *fb))
+            return true;
+    }
+
+    return false;
+}
+
+RootSolution
+root_brent(RootFunc func,
+           void *   func_data,
+           double   a,
+           double   fa,
+           double   b,
+           double   fb,
+           double   x_tol,
+           int      max_iterations)
+{
+    assert(func);
+
+    int    i;
+    double c  = b;
+    double fc = fb;
+    double d  = b - a;
+    double e  = d;
+    double p;
+    double q;
+    double r;
+    double s;
+    double tol;
+    double xm;
+    double min_1;
+    double min_2;
+
+    RootSolution sol = { false, 0, 0, NAN, NAN };
+
+    if (!check_bracket(a, fa, b, fb, &sol))
+        return sol;
+
+    for (i = 1; i <= max_iterations; i++) {
+        sol.n_iterations = i;
+
+        if (same_sign(fb, fc)) {
+            c  = a;
+            fc = fa;
+            d  = b - a;
+            e  = d;
+        }
+
+        /* b is the best estimate and c is on the other side of the root */
+        if (fabs(fc) < fabs(fb)) {
+            a  = b;
+            b  = c;
+            c  = a;
+            fa = fb;
+            fb = fc;
+            fc = fa;
+        }
+
+        tol = 2 * DBL_EPSILON * fabs(b) + 0.5 * x_tol;
+        xm  = 0.5 * (c - b);
+
+        if (fabs(xm) <= tol || fb == 0) {
+            sol.converged = true;
+            break;
+        }
+
+        if (fabs(e) >= tol && fabs(fa) > fabs(fb)) {
+            /* secant or inverse quadratic interpolation */
+            s = fb / fa;
+            if (a == c) {
+                p = 2 * xm * s;
+                q = 1 - s;
+            } else {
+                q = fa / fc;
+                r = fb / fc;
+                p = s * (2 * xm * q * (q - r) - (b - a) * (r - 1));
+                q = (q - 1) * (r - 1) * (s - 1);
+            }
+
+            if (p > 0)
+                q = -q;
+            p = fabs(p);
+
+            min_1 = 3 * xm * q - fabs(tol * q);
+            min_2 = fabs(e * q);
+
+            if (2 * p < (min_1 < min_2 ? min_1 : min_2)) {
+                e = d;
+                d = p / q;
+            } else {
+                d = xm;
+                e = d;
+            }
+        } else {
+            d = xm;
+            e = d;
+        }
+
+        a  = b;
+        fa = fb;
+        b += fabs(d) > tol ? d : copysign(tol, xm);
+        fb = func(b, func_data);
+        sol.n_evaluations++;
+
+        if (isnan(fb))
+            break;
+    }
+
+    sol.x        = sol.converged ? b : NAN;
+    sol.residual = fb;
+
+    return sol;
+}
+
+RootSolution
+root_newton(RootFuncDeriv func,
+            void *        func_data,
+            double        a,
+            double        fa,
+            double        b,
+            double        fb,
+            double        x0,
+            double        x_tol,
+            int           max_iterations)
+{
+    assert(func);
+
+    int    i;
+    double lo; /* end of bracket with a negative function value */
+    double hi; /* end of bracket with a positive function value */
+    double x;
+    double fx;
+    double dfx;
+    double x_new;
+    double dx;
+    double dx_old;
+
+    RootSolution sol = { false, 0, 0, NAN, NAN };
+
+    if (!check_bracket(a, fa, b, fb, &sol))
+        return sol;
+
+    if (fa < 0) {
+        lo = a;
+        hi = b;
+    } else {
+        lo = b;
+        hi = a;
+    }
+
+    if ((x0 - a) * (x0 - b) < 0)
+        x = x0;
+    else
+        x = 0.5 * (a + b);
+
+    dx     = fabs(b - a);
+    dx_old = dx;
+    fx     = func(x, func_data, &dfx);
+    sol.n_evaluations++;
+
+    for (i = 1; i <= max_iterations; i++) {
+        sol.n_iterations = i;
+
+        if (isnan(fx))
+            break;
+
+        if (fx == 0) {
+            sol.converged = true;
+            break;
+        }
+
+        if (fx < 0)
+            lo = x;
+        else
+            hi = x;
+
+        /* take a bisection step if the Newton step leaves the bracket or
+         * does not halve the step taken two iterations ago */
+        x_new = x - fx / dfx;
+        if (!isfinite(x_new) || (x_new - lo) * (x_new - hi) >= 0 ||
+            fabs(2 * fx) > fabs(dx_old * dfx)) {
+            x_new = 0.5 * (lo + hi);
+        }
+
+        dx_old = dx;
+        dx     = x_new - x;
+        x      = x_new;
+        fx     = func(x, func_data, &dfx);
+        sol.n_evaluations++;
+
+        if (fabs(dx) <= x_tol || fabs(hi - lo) <= x_tol) {
+            sol.converged = !isnan(fx);
+            break;
+        }
+    }
+
+    sol.x        = sol.converged ? x : NAN;
+    sol.residual = fx;
+
+    return sol;
+}
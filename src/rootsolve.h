@@ -0,0 +1,167 @@
+#ifndef ROOT_SOLVE_INCLUDED
+#define ROOT_SOLVE_INCLUDED
+
+#include <stdbool.h>
+
+/**
+ * SECTION: rootsolve.h
+ * @short_description: Bracketing root finders
+ * @title: Bracketing root finders
+ *
+ * Safeguarded root finders that keep a bracket around the root. The solvers
+ * keep their state on the stack and do not allocate memory.
+ */
+
+/**
+ * RootSolution:
+ * @converged:     indicates if a solution has been found
+ * @n_iterations:  the number of iterations taken during the solution
+ * @n_evaluations: the number of function evaluations taken during the
+ *                 solution
+ * @x:             the computed x value of the solution, `NAN` if no solution
+ *                 is found
+ * @residual:      the function value at @x
+ *
+ * Root finder solution
+ */
+typedef struct {
+    bool   converged;
+    int    n_iterations;
+    int    n_evaluations;
+    double x;
+    double residual;
+} RootSolution;
+
+/**
+ * RootFunc:
+ * @x:         x-value of function to compute
+ * @func_data: data used for computation of the function
+ *
+ * Returns: the function value at @x
+ */
+typedef double (*RootFunc)(double x, void *func_data);
+
+/**
+ * RootFuncDeriv:
+ * @x:         x-value of function to compute
+ * @func_data: data used for computation of the function
+ * @deriv:     location to store the derivative of the function at @x
+ *
+ * Returns: the function value at @x
+ */
+typedef double (*RootFuncDeriv)(double x, void *func_data, double *deriv);
+
+/**
+ * root_bracket_up:
+ * @func:          a #RootFunc
+ * @func_data:     data used by @func
+ * @a:             lower end of the initial bracket
+ * @fa:            function value at @a
+ * @b:             location of the upper end of the bracket
+ * @fb:            location to store the function value at @b
+ * @max_expand:    the maximum number of times the bracket is expanded
+ * @n_evaluations: location of a function evaluation counter to increment
+ *
+ * Evaluates @func at *@b and, while @func has the same sign at @a and *@b,
+ * moves *@b upward, doubling the width of the bracket each time.
+ *
+ * Returns: true if a sign change is bracketed between @a and *@b
+ */
+extern bool
+root_bracket_up(RootFunc func,
+                void *   func_data,
+                double   a,
+                double   fa,
+                double * b,
+                double * fb,
+                int      max_expand,
+                int *    n_evaluations);
+
+/**
+ * root_bracket_toward:
+ * @func:          a #RootFunc
+ * @func_data:     data used by @func
+ * @a:             one end of the bracket
+ * @fa:            function value at @a
+ * @limit:         a value that the other end of the bracket approaches
+ * @b:             location to store the other end of the bracket
+ * @fb:            location to store the function value at @b
+ * @max_steps:     the maximum number of function evaluations
+ * @n_evaluations: location of a function evaluation counter to increment
+ *
+ * Searches between @a and @limit for a sign change of @func. *@b starts at
+ * the midpoint of @a and @limit and is moved toward @limit, halving its
+ * distance to @limit each time, until @func has opposite signs at @a and
+ * *@b. @func is never evaluated at @limit.
+ *
+ * Returns: true if a sign change is bracketed between @a and *@b
+ */
+extern bool
+root_bracket_toward(RootFunc func,
+                    void *   func_data,
+                    double   a,
+                    double   fa,
+                    double   limit,
+                    double * b,
+                    double * fb,
+                    int      max_steps,
+                    int *    n_evaluations);
+
+/**
+ * root_brent:
+ * @func:           a #RootFunc
+ * @func_data:      data used by @func
+ * @a:              one end of a bracket
+ * @fa:             function value at @a
+ * @b:              other end of a bracket
+ * @fb:             function value at @b
+ * @x_tol:          acceptable error in x
+ * @max_iterations: the maximum number of iterations
+ *
+ * Finds a root of @func between @a and @b with Brent's method, which combines
+ * inverse quadratic interpolation and the secant method with bisection. @fa
+ * and @fb must have opposite signs.
+ *
+ * Returns: the solution
+ */
+extern RootSolution
+root_brent(RootFunc func,
+           void *   func_data,
+           double   a,
+           double   fa,
+           double   b,
+           double   fb,
+           double   x_tol,
+           int      max_iterations);
+
+/**
+ * root_newton:
+ * @func:           a #RootFuncDeriv
+ * @func_data:      data used by @func
+ * @a:              one end of a bracket
+ * @fa:             function value at @a
+ * @b:              other end of a bracket
+ * @fb:             function value at @b
+ * @x0:             initial estimate of the root
+ * @x_tol:          acceptable error in x
+ * @max_iterations: the maximum number of iterations
+ *
+ * Finds a root of @func between @a and @b with Newton's method. Newton steps
+ * that leave the bracket or do not reduce it quickly enough are replaced with
+ * bisection steps. @fa and @fb must have opposite signs. If @x0 is not within
+ * the bracket, the first iterate is the midpoint of the bracket.
+ *
+ * Returns: the solution
+ */
+extern RootSolution
+root_newton(RootFuncDeriv func,
+            void *        func_data,
+            double        a,
+            double        fa,
+            double        b,
+            double        fb,
+            double        x0,
+            double        x_tol,
+            int           max_iterations);
+
+#endif
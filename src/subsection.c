@@ -1,148 +1,705 @@
 #include "subsection.h"
-#include "list.h"
+#include "coarray.h"
 #include "mem.h"
 #include <assert.h>
 #include <math.h>
 #include <panthera/crosssection.h>
-#include <panthera/constants.h>
 #include <stddef.h>
+#include <string.h>
+
+/* runtime selection of AVX2 and AVX-512 batch kernels is supported on x86
+ * with GCC and Clang, other targets use the generic kernel */
+#if (defined(__GNUC__) || defined(__clang__)) &&                             \
+    (defined(__x86_64__) || defined(__i386__))
+#define BATCH_DISPATCH
+#include <immintrin.h>
+#endif
+
+/* Geometry of a subsection, which does not depend on roughness. Subsections
+ * created with subsection_with_roughness() share the geometry of the
+ * subsection they are created from. */
+typedef struct {
+    int     ref_count; /* number of subsections sharing the geometry */
+    CoArray array;     /* coordinate array */
+    int     n_pieces;  /* number of geometry pieces */
+    double *piece_y;   /* lower elevation of each piece */
+    double *piece_a;   /* area at piece_y */
+    double *piece_p;   /* wetted perimeter at piece_y */
+    double *piece_t;   /* top width at piece_y */
+    double *piece_dp;  /* wetted perimeter slope within each piece */
+    double *piece_dt;  /* top width slope within each piece */
+} Geometry;
 
 /* subsection interface */
 struct Subsection {
-    CoArray array; /* coordinate array */
-    double  n;     /* Manning's n */
-    double  min_y; /* activation depth */
+    Geometry *geometry; /* shared geometry */
+    double    n;        /* Manning's n */
+    double    manning;  /* Manning conversion factor */
+    double    k_coeff;  /* Manning conversion factor divided by n */
+    double    min_y;    /* activation depth */
 };
 
+static int
+compare_double(const void *a, const void *b)
+{
+    double a_value = *(const double *) a;
+    double b_value = *(const double *) b;
+    return (a_value > b_value) - (a_value < b_value);
+}
+
+/* returns the index of the last piece with a lower elevation at or below y,
+ * or -1 if y is below the lowest piece */
+static inline int
+piece_index(const Geometry *g, double y)
+{
+    const double *piece_y = g->piece_y;
+
+    int lo = 0;
+    int hi = g->n_pieces;
+    int mid;
+
+    if (!(piece_y[0] <= y))
+        return -1;
+
+    /* piece_y[lo] <= y < piece_y[hi] */
+    while (hi - lo > 1) {
+        mid = (lo + hi) / 2;
+        if (piece_y[mid] <= y)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+/* Builds the piecewise polynomial representation of the subsection geometry.
+ * Between consecutive coordinate elevations, the top width and wetted
+ * perimeter are linear and the area is quadratic in y. Each piece stores the
+ * values at its lower elevation and the slopes of top width and wetted
+ * perimeter within the piece. The pieces are built in one sweep over the
+ * sorted elevations: a sloped segment adds to the slopes of the pieces it
+ * spans and a horizontal segment adds a step to the values at its elevation.
+ * Geometry with a non-finite coordinate is a single piece of NAN values that
+ * starts below every elevation, so its properties are NAN at every depth.
+ */
+static void
+build_pieces(Geometry *g)
+{
+    int           n  = coarray_length(g->array);
+    const double *ya = coarray_y(g->array);
+    const double *za = coarray_z(g->array);
+
+    int    i;
+    int    k;
+    int    k_lo;
+    int    k_hi;
+    int    m = 0;
+    double lo;
+    double hi;
+    double dy;
+    double dz;
+    double length;
+    double t_slope;
+    double p_slope;
+    int    n_sloped;
+
+    for (i = 0; i < n; i++) {
+        if (!isfinite(ya[i]) || !isfinite(za[i]))
+            break;
+    }
+
+    if (i < n) {
+        g->n_pieces = 1;
+        g->piece_y  = mem_calloc(6, sizeof(double), __FILE__, __LINE__);
+        g->piece_a  = g->piece_y + 1;
+        g->piece_p  = g->piece_y + 2;
+        g->piece_t  = g->piece_y + 3;
+        g->piece_dp = g->piece_y + 4;
+        g->piece_dt = g->piece_y + 5;
+
+        g->piece_y[0] = -INFINITY;
+        for (k = 1; k < 6; k++)
+            g->piece_y[k] = NAN;
+        return;
+    }
+
+    /* sorted, unique coordinate elevations */
+    double *elevations = mem_calloc(n, sizeof(double), __FILE__, __LINE__);
+    memcpy(elevations, ya, n * sizeof(double));
+    qsort(elevations, n, sizeof(double), &compare_double);
+    for (i = 0; i < n; i++) {
+        if (m == 0 || elevations[i] != elevations[m - 1])
+            elevations[m++] = elevations[i];
+    }
+
+    g->n_pieces = m;
+    g->piece_y  = mem_calloc(6 * m, sizeof(double), __FILE__, __LINE__);
+    g->piece_a  = g->piece_y + m;
+    g->piece_p  = g->piece_y + 2 * m;
+    g->piece_t  = g->piece_y + 3 * m;
+    g->piece_dp = g->piece_y + 4 * m;
+    g->piece_dt = g->piece_y + 5 * m;
+    memcpy(g->piece_y, elevations, m * sizeof(double));
+    mem_free(elevations, __FILE__, __LINE__);
+
+    /* changes in slope, steps in value, and changes in the number of sloped
+     * segments at each elevation, stored in the piece arrays until the sweep
+     * below */
+    double *d_t_slope = mem_calloc(4 * m, sizeof(double), __FILE__, __LINE__);
+    double *d_p_slope = d_t_slope + m;
+    double *d_sloped  = d_t_slope + 2 * m;
+    double *step_p    = d_t_slope + 3 * m;
+
+    for (i = 1; i < n; i++) {
+        lo     = ya[i - 1] < ya[i] ? ya[i - 1] : ya[i];
+        hi     = ya[i - 1] < ya[i] ? ya[i] : ya[i - 1];
+        dy     = hi - lo;
+        dz     = za[i] - za[i - 1];
+        length = sqrt(dy * dy + dz * dz);
+        k_lo   = piece_index(g, lo);
+        if (dy > 0) {
+            k_hi = piece_index(g, hi);
+            d_t_slope[k_lo] += dz / dy;
+            d_p_slope[k_lo] += length / dy;
+            d_sloped[k_lo] += 1;
+            d_t_slope[k_hi] -= dz / dy;
+            d_p_slope[k_hi] -= length / dy;
+            d_sloped[k_hi] -= 1;
+        } else {
+            g->piece_t[k_lo] += dz;
+            step_p[k_lo] += length;
+        }
+    }
+
+    /* sweep up through the pieces */
+    t_slope  = 0;
+    p_slope  = 0;
+    n_sloped = 0;
+    for (k = 0; k < m; k++) {
+        if (k > 0) {
+            dy              = g->piece_y[k] - g->piece_y[k - 1];
+            g->piece_a[k]   = g->piece_a[k - 1] +
+                            (g->piece_t[k - 1] + 0.5 * t_slope * dy) * dy;
+            g->piece_t[k]  += g->piece_t[k - 1] + t_slope * dy;
+            g->piece_p[k]   = g->piece_p[k - 1] + p_slope * dy;
+        }
+        g->piece_p[k] += step_p[k];
+
+        t_slope += d_t_slope[k];
+        p_slope += d_p_slope[k];
+        n_sloped += (int) d_sloped[k];
+
+        /* remove round-off left over when every sloped segment has ended */
+        if (n_sloped == 0) {
+            t_slope = 0;
+            p_slope = 0;
+        }
+
+        g->piece_dt[k] = t_slope;
+        g->piece_dp[k] = p_slope;
+    }
+
+    mem_free(d_t_slope, __FILE__, __LINE__);
+}
+
 /* Allocates memory and creates a new Subsection */
 Subsection
 subsection_new(CoArray ca, double roughness, double activation_depth)
 {
+    Constants constants = const_defaults();
+
+    return subsection_new_with_constants(
+        ca, roughness, activation_depth, &constants);
+}
+
+Subsection
+subsection_new_with_constants(CoArray          ca,
+                              double           roughness,
+                              double           activation_depth,
+                              const Constants *constants)
+{
+    return subsection_new_adopt(
+        coarray_copy(ca), roughness, activation_depth, constants);
+}
+
+Subsection
+subsection_new_adopt(CoArray          ca,
+                     double           roughness,
+                     double           activation_depth,
+                     const Constants *constants)
+{
+    assert(ca);
     assert((int) (roughness > 0));
+    assert(constants);
 
     Subsection ss;
     NEW(ss);
 
-    ss->array = coarray_copy(ca);
-    ss->n     = roughness;
-    ss->min_y = activation_depth;
+    NEW(ss->geometry);
+    ss->geometry->ref_count = 1;
+    ss->geometry->array     = ca;
+    build_pieces(ss->geometry);
+
+    ss->n       = roughness;
+    ss->manning = constants->manning;
+    ss->k_coeff = constants->manning / roughness;
+    ss->min_y   = activation_depth;
 
     return ss;
 }
 
+Subsection
+subsection_with_roughness(Subsection ss, double roughness)
+{
+    assert(ss);
+    assert((int) (roughness > 0));
+
+    Subsection new_ss;
+    NEW(new_ss);
+
+    new_ss->geometry = ss->geometry;
+    new_ss->geometry->ref_count++;
+
+    new_ss->n       = roughness;
+    new_ss->manning = ss->manning;
+    new_ss->k_coeff = ss->manning / roughness;
+    new_ss->min_y   = ss->min_y;
+
+    return new_ss;
+}
+
 /* Frees memory from a previously allocated Subsection */
 void
 subsection_free(Subsection ss)
 {
-    coarray_free(ss->array);
+    Geometry *g = ss->geometry;
+
+    if (--g->ref_count == 0) {
+        coarray_free(g->array);
+        mem_free(g->piece_y, __FILE__, __LINE__);
+        FREE(g);
+    }
+
     FREE(ss);
 }
 
-/* Calculates hydraulic properties for the subsection.
- * Returns a new CrossSectionProps.
- */
-CrossSectionProps
-subsection_properties(Subsection ss, double y)
+/* Evaluates the piece containing y. Below the lowest coordinate the
+ * subsection is dry. */
+static inline void
+piece_eval(Subsection ss,
+           double     y,
+           double *   area,
+           double *   perimeter,
+           double *   top_width,
+           double *   dp,
+           double *   dt)
 {
-    assert(ss);
+    const Geometry *g = ss->geometry;
+    int             k = piece_index(g, y);
+    double          dy;
+    double          dry;
+
+    if (k < 0) {
+        dry        = isnan(y) ? NAN : 0;
+        *area      = dry;
+        *perimeter = dry;
+        *top_width = dry;
+        if (dp) {
+            *dp = dry;
+            *dt = dry;
+        }
+        return;
+    }
 
-    CoArray sa;
+    dy         = y - g->piece_y[k];
+    *area      = g->piece_a[k] +
+                 (g->piece_t[k] + 0.5 * g->piece_dt[k] * dy) * dy;
+    *perimeter = g->piece_p[k] + g->piece_dp[k] * dy;
+    *top_width = g->piece_t[k] + g->piece_dt[k] * dy;
 
-    double area      = 0;
-    double perimeter = 0;
-    double top_width = 0;
-    double hydraulic_radius;
-    double conveyance;
+    if (dp) {
+        *dp = g->piece_dp[k];
+        *dt = g->piece_dt[k];
+    }
+}
 
-    CrossSectionProps xsp = xsp_new();
+void
+subsection_geometry(Subsection ss,
+                    double     y,
+                    double *   area,
+                    double *   perimeter,
+                    double *   top_width)
+{
+    assert(ss && area && perimeter && top_width);
+    piece_eval(ss, y, area, perimeter, top_width, NULL, NULL);
+}
 
-    int n;
+void
+subsection_geometry_deriv(Subsection ss,
+                          double     y,
+                          double *   area,
+                          double *   perimeter,
+                          double *   top_width,
+                          double *   d_perimeter,
+                          double *   d_top_width)
+{
+    assert(ss && area && perimeter && top_width);
+    assert(d_perimeter && d_top_width);
+    piece_eval(ss, y, area, perimeter, top_width, d_perimeter, d_top_width);
+}
 
-    /* return 0 subsection values if this subsection isn't activated */
-    if (y <= coarray_min_y(ss->array) || y <= ss->min_y) {
-        sa = NULL;
-        n  = 0;
-    }
-    /* otherwise calculate the values */
-    else {
-        sa = coarray_subarray_y(ss->array, y);
-        n  = coarray_length(sa);
+/* The batch kernels integrate area, wetted perimeter, and top width of a
+ * BATCH_CHUNK sized block of depths. The segment loop is on the outside and
+ * the loop over depths is on the inside and free of branches. Each segment is
+ * wet to a fraction f of its height, where f is clamped between 0 and 1. A
+ * horizontal segment is wet if it is at or below the depth.
+ */
+/* subsections with more segments than this are evaluated in batches from
+ * their geometry pieces, one depth at a time, instead of with the segment
+ * kernels */
+#ifndef BATCH_MAX_SEGMENTS
+#define BATCH_MAX_SEGMENTS 32
+#endif
+
+typedef void (*geometry_chunk_fn)(int                    n,
+                                  const double *restrict ya,
+                                  const double *restrict za,
+                                  const double *restrict y,
+                                  double *restrict       a,
+                                  double *restrict       p,
+                                  double *restrict       t);
+
+/* segment values shared by every depth in a block */
+#define SEGMENT_VALUES(ya, za, i, lo, dy, dz, length)                         \
+    do {                                                                       \
+        lo     = ya[i - 1] < ya[i] ? ya[i - 1] : ya[i];                        \
+        dy     = fabs(ya[i] - ya[i - 1]);                                      \
+        dz     = za[i] - za[i - 1];                                            \
+        length = sqrt(dy * dy + dz * dz);                                      \
+    } while (0)
+
+static void
+geometry_chunk_generic(int                    n,
+                       const double *restrict ya,
+                       const double *restrict za,
+                       const double *restrict y,
+                       double *restrict       a,
+                       double *restrict       p,
+                       double *restrict       t)
+{
+    int    i;
+    int    j;
+    double lo;
+    double dy;
+    double dy_inv;
+    double dz;
+    double length;
+    double f;
+
+    for (j = 0; j < BATCH_CHUNK; j++) {
+        a[j] = 0;
+        p[j] = 0;
+        t[j] = 0;
     }
 
-    int i;
+    for (i = 1; i < n; i++) {
 
-    /* depth for c1 and c2 */
-    double d1;
-    double d2;
+        SEGMENT_VALUES(ya, za, i, lo, dy, dz, length);
+
+        if (dy > 0) {
+            dy_inv = 1 / dy;
+            for (j = 0; j < BATCH_CHUNK; j++) {
+                f = (y[j] - lo) * dy_inv;
+                f = f < 0 ? 0 : f;
+                f = f > 1 ? 1 : f;
+                a[j] += f * dz * ((y[j] - lo) - 0.5 * f * dy);
+                p[j] += f * length;
+                t[j] += f * dz;
+            }
+        } else {
+            for (j = 0; j < BATCH_CHUNK; j++) {
+                f = y[j] >= lo ? 1.0 : 0.0;
+                a[j] += f * dz * (y[j] - lo);
+                p[j] += f * length;
+                t[j] += f * dz;
+            }
+        }
+    }
+}
 
-    /* distances for perimeter */
+#ifdef BATCH_DISPATCH
+__attribute__((target("avx2"))) static void
+geometry_chunk_avx2(int                    n,
+                    const double *restrict ya,
+                    const double *restrict za,
+                    const double *restrict y,
+                    double *restrict       a,
+                    double *restrict       p,
+                    double *restrict       t)
+{
+    int    i;
+    int    j;
+    double lo;
     double dy;
     double dz;
+    double length;
+
+    __m256d zero = _mm256_setzero_pd();
+    __m256d one  = _mm256_set1_pd(1);
+    __m256d half = _mm256_set1_pd(0.5);
+    __m256d v_lo, v_dy, v_dy_inv, v_dz, v_length;
+    __m256d v_h, f, v_a;
+
+    for (j = 0; j < BATCH_CHUNK; j += 4) {
+        _mm256_storeu_pd(a + j, zero);
+        _mm256_storeu_pd(p + j, zero);
+        _mm256_storeu_pd(t + j, zero);
+    }
 
-    double y1;
-    double z1;
+    for (i = 1; i < n; i++) {
 
-    double y2;
-    double z2;
+        SEGMENT_VALUES(ya, za, i, lo, dy, dz, length);
+
+        v_lo     = _mm256_set1_pd(lo);
+        v_dy     = _mm256_set1_pd(dy);
+        v_dy_inv = _mm256_set1_pd(1 / dy);
+        v_dz     = _mm256_set1_pd(dz);
+        v_length = _mm256_set1_pd(length);
+
+        for (j = 0; j < BATCH_CHUNK; j += 4) {
+
+            /* height of the depth above the bottom of the segment */
+            v_h = _mm256_sub_pd(_mm256_loadu_pd(y + j), v_lo);
+
+            if (dy > 0) {
+                f = _mm256_mul_pd(v_h, v_dy_inv);
+                f = _mm256_max_pd(zero, _mm256_min_pd(one, f));
+                v_a = _mm256_sub_pd(
+                    v_h, _mm256_mul_pd(_mm256_mul_pd(half, f), v_dy));
+            } else {
+                f   = _mm256_and_pd(_mm256_cmp_pd(v_h, zero, _CMP_GE_OQ), one);
+                v_a = v_h;
+            }
+
+            v_a = _mm256_mul_pd(_mm256_mul_pd(f, v_dz), v_a);
+            _mm256_storeu_pd(a + j, _mm256_add_pd(_mm256_loadu_pd(a + j), v_a));
+            _mm256_storeu_pd(
+                p + j,
+                _mm256_add_pd(_mm256_loadu_pd(p + j),
+                              _mm256_mul_pd(f, v_length)));
+            _mm256_storeu_pd(
+                t + j,
+                _mm256_add_pd(_mm256_loadu_pd(t + j), _mm256_mul_pd(f, v_dz)));
+        }
+    }
+}
 
-    Coordinate c1;
-    Coordinate c2;
+__attribute__((target("avx512f"))) static void
+geometry_chunk_avx512(int                    n,
+                      const double *restrict ya,
+                      const double *restrict za,
+                      const double *restrict y,
+                      double *restrict       a,
+                      double *restrict       p,
+                      double *restrict       t)
+{
+    int    i;
+    int    j;
+    double lo;
+    double dy;
+    double dz;
+    double length;
+
+    __m512d   zero = _mm512_setzero_pd();
+    __m512d   one  = _mm512_set1_pd(1);
+    __m512d   half = _mm512_set1_pd(0.5);
+    __m512d   v_lo, v_dy, v_dy_inv, v_dz, v_length;
+    __m512d   v_h, f, v_a;
+    __mmask8  wet;
+
+    for (j = 0; j < BATCH_CHUNK; j += 8) {
+        _mm512_storeu_pd(a + j, zero);
+        _mm512_storeu_pd(p + j, zero);
+        _mm512_storeu_pd(t + j, zero);
+    }
 
     for (i = 1; i < n; i++) {
 
-        c1 = coarray_get(sa, i - 1);
-        c2 = coarray_get(sa, i);
-
-        if (c1) {
-            y1 = c1->y;
-            z1 = c1->z;
-        } else {
-            y1 = NAN;
-            z1 = NAN;
+        SEGMENT_VALUES(ya, za, i, lo, dy, dz, length);
+
+        v_lo     = _mm512_set1_pd(lo);
+        v_dy     = _mm512_set1_pd(dy);
+        v_dy_inv = _mm512_set1_pd(1 / dy);
+        v_dz     = _mm512_set1_pd(dz);
+        v_length = _mm512_set1_pd(length);
+
+        for (j = 0; j < BATCH_CHUNK; j += 8) {
+
+            /* height of the depth above the bottom of the segment */
+            v_h = _mm512_sub_pd(_mm512_loadu_pd(y + j), v_lo);
+
+            if (dy > 0) {
+                f = _mm512_mul_pd(v_h, v_dy_inv);
+                f = _mm512_max_pd(zero, _mm512_min_pd(one, f));
+                v_a = _mm512_sub_pd(
+                    v_h, _mm512_mul_pd(_mm512_mul_pd(half, f), v_dy));
+            } else {
+                wet = _mm512_cmp_pd_mask(v_h, zero, _CMP_GE_OQ);
+                f   = _mm512_mask_blend_pd(wet, zero, one);
+                v_a = v_h;
+            }
+
+            v_a = _mm512_mul_pd(_mm512_mul_pd(f, v_dz), v_a);
+            _mm512_storeu_pd(a + j, _mm512_add_pd(_mm512_loadu_pd(a + j), v_a));
+            _mm512_storeu_pd(
+                p + j,
+                _mm512_add_pd(_mm512_loadu_pd(p + j),
+                              _mm512_mul_pd(f, v_length)));
+            _mm512_storeu_pd(
+                t + j,
+                _mm512_add_pd(_mm512_loadu_pd(t + j), _mm512_mul_pd(f, v_dz)));
         }
+    }
+}
+#endif
+
+/* batch kernel, replaced by the widest kernel supported by the running
+ * processor before main() so that worker threads only ever read it */
+static geometry_chunk_fn geometry_chunk_kernel = &geometry_chunk_generic;
+
+#ifdef BATCH_DISPATCH
+__attribute__((constructor)) static void
+geometry_chunk_select(void)
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        geometry_chunk_kernel = &geometry_chunk_avx512;
+    else if (__builtin_cpu_supports("avx2"))
+        geometry_chunk_kernel = &geometry_chunk_avx2;
+}
+#endif
+
+void
+subsection_properties_batch(Subsection    ss,
+                            int           n,
+                            const double *y,
+                            double *      area,
+                            double *      perimeter,
+                            double *      top_width,
+                            double *      conveyance)
+{
+    assert(ss && (n == 0 || y));
+    assert(area && perimeter && top_width && conveyance);
+
+    int           n_coords = coarray_length(ss->geometry->array);
+    const double *ya       = coarray_y(ss->geometry->array);
+    const double *za       = coarray_z(ss->geometry->array);
+    double        y_min    = coarray_min_y(ss->geometry->array);
+    double        k_coeff  = ss->k_coeff;
 
-        if (c2) {
-            y2 = c2->y;
-            z2 = c2->z;
+    double y_chunk[BATCH_CHUNK];
+    double a_chunk[BATCH_CHUNK];
+    double p_chunk[BATCH_CHUNK];
+    double t_chunk[BATCH_CHUNK];
+
+    int i;
+    int j;
+    int m;
+
+    if (ss->min_y > y_min)
+        y_min = ss->min_y;
+
+    for (i = 0; i < n; i += BATCH_CHUNK) {
+
+        /* pad the last chunk with its last depth */
+        m = n - i < BATCH_CHUNK ? n - i : BATCH_CHUNK;
+        memcpy(y_chunk, y + i, m * sizeof(double));
+        for (j = m; j < BATCH_CHUNK; j++)
+            y_chunk[j] = y_chunk[m - 1];
+
+        if (n_coords - 1 > BATCH_MAX_SEGMENTS) {
+            for (j = 0; j < m; j++)
+                piece_eval(ss,
+                           y_chunk[j],
+                           a_chunk + j,
+                           p_chunk + j,
+                           t_chunk + j,
+                           NULL,
+                           NULL);
         } else {
-            y2 = NAN;
-            z2 = NAN;
+            geometry_chunk_kernel(
+                n_coords, ya, za, y_chunk, a_chunk, p_chunk, t_chunk);
         }
 
-        coord_free(c1);
-        coord_free(c2);
-
-        /* if y1 or y2 is NAN, continue */
-        if (isnan(y1) || isnan(y2)) {
-            continue;
+        /* zero values are returned for depths where the subsection is not
+         * activated */
+        for (j = 0; j < m; j++) {
+            if (y_chunk[j] <= y_min) {
+                area[i + j]       = 0;
+                perimeter[i + j]  = 0;
+                top_width[i + j]  = 0;
+                conveyance[i + j] = 0;
+            } else {
+                area[i + j]      = a_chunk[j];
+                perimeter[i + j] = p_chunk[j];
+                top_width[i + j] = t_chunk[j];
+                conveyance[i + j] =
+                    k_coeff * a_chunk[j] *
+                    pow(a_chunk[j] / p_chunk[j], 2.0 / 3.0);
+            }
         }
+    }
+}
 
-        /* calculate area by trapezoidal integration */
-        d1 = y - y1;
-        d2 = y - y2;
-        area += 0.5 * (d1 + d2) * (z2 - z1);
+/* Computes conveyance with Manning's equation */
+double
+subsection_conveyance(Subsection ss, double area, double perimeter)
+{
+    assert(ss);
+    return ss->k_coeff * area * pow(area / perimeter, 2.0 / 3.0);
+}
 
-        /* calculate perimeter */
-        dy = y2 - y1;
-        dz = z2 - z1;
-        perimeter += sqrt(dy * dy + dz * dz);
+/* Calculates hydraulic properties for the subsection into xsp. */
+void
+subsection_properties_into(Subsection ss, double y, XSPValues *xsp)
+{
+    assert(ss && xsp);
 
-        /* calculate top width */
-        top_width += z2 - z1;
-    }
+    double area      = 0;
+    double perimeter = 0;
+    double top_width = 0;
+    double hydraulic_radius;
+    double conveyance;
+
+    /* calculate the values if this subsection is activated, otherwise return
+     * 0 subsection values */
+    if (!(y <= coarray_min_y(ss->geometry->array) || y <= ss->min_y))
+        subsection_geometry(ss, y, &area, &perimeter, &top_width);
 
     hydraulic_radius = area / perimeter;
-    conveyance =
-        const_manning() / ss->n * area * pow(hydraulic_radius, 2.0 / 3.0);
+    conveyance       = subsection_conveyance(ss, area, perimeter);
 
-    xsp_set(xsp, XS_AREA, area);
-    xsp_set(xsp, XS_TOP_WIDTH, top_width);
-    xsp_set(xsp, XS_WETTED_PERIMETER, perimeter);
-    xsp_set(xsp, XS_HYDRAULIC_RADIUS, hydraulic_radius);
-    xsp_set(xsp, XS_CONVEYANCE, conveyance);
+    for (int i = 0; i < N_XSP; i++)
+        xsp->values[i] = NAN;
+
+    xsp->values[XS_AREA]             = area;
+    xsp->values[XS_TOP_WIDTH]        = top_width;
+    xsp->values[XS_WETTED_PERIMETER] = perimeter;
+    xsp->values[XS_HYDRAULIC_RADIUS] = hydraulic_radius;
+    xsp->values[XS_CONVEYANCE]       = conveyance;
+}
+
+/* Calculates hydraulic properties for the subsection.
+ * Returns a new CrossSectionProps.
+ */
+CrossSectionProps
+subsection_properties(Subsection ss, double y)
+{
+    assert(ss);
 
-    if (sa)
-        coarray_free(sa);
+    CrossSectionProps xsp = xsp_new();
+    subsection_properties_into(ss, y, xsp_values(xsp));
 
     return xsp;
 }
@@ -158,17 +715,20 @@ bool
 subsection_activated(Subsection ss, double y)
 {
     assert(ss);
-    return (y <= coarray_min_y(ss->array) || y <= ss->min_y);
+    return (y <= coarray_min_y(ss->geometry->array) || y <= ss->min_y);
 }
 
 double
 subsection_z(Subsection ss)
 {
     assert(ss);
-    int        n = coarray_length(ss->array);
-    double     z;
-    Coordinate c = coarray_get(ss->array, n - 1);
-    z            = c->z;
-    coord_free(c);
-    return z;
+    int n = coarray_length(ss->geometry->array);
+    return coarray_z(ss->geometry->array)[n - 1];
+}
+
+CoArray
+subsection_coarray(Subsection ss)
+{
+    assert(ss);
+    return ss->geometry->array;
 }
@@ -2,6 +2,7 @@
 #define SUBSECTION_INCLUDED
 
 #include "xsproperties.h"
+#include <panthera/constants.h>
 #include <panthera/crosssection.h>
 #include <stdbool.h>
 
@@ -28,14 +29,72 @@ typedef struct Subsection *Subsection;
  *
  * Creates a new subsection with coordinates defined in @ca and roughness
  * @roughness. @y_activation defines the y-value at which the new subsection
- * will compute cross section properties. The returned subsection is newly
- * created and must be freed with subsection_free().
+ * will compute cross section properties. Conveyance is computed with the
+ * default Manning conversion factor at the time @ss is created. The returned
+ * subsection is newly created and must be freed with subsection_free().
  *
  * Returns: a new subsection
  */
 extern Subsection
 subsection_new(CoArray ca, double roughness, double y_activation);
 
+/**
+ * subsection_new_with_constants:
+ * @ca:           a #CoArray defining the coordinates in the new subsection
+ * @roughness:    a roughness value for the new subsection
+ * @y_activation: a y-value defining the activation of this subsection
+ * @constants:    physical constants of the new subsection
+ *
+ * Creates a new subsection like subsection_new() that computes conveyance
+ * with the Manning conversion factor of @constants instead of the default.
+ *
+ * Returns: a new subsection
+ */
+extern Subsection
+subsection_new_with_constants(CoArray          ca,
+                              double           roughness,
+                              double           y_activation,
+                              const Constants *constants);
+
+/**
+ * subsection_new_adopt:
+ * @ca:           a #CoArray defining the coordinates in the new subsection
+ * @roughness:    a roughness value for the new subsection
+ * @y_activation: a y-value defining the activation of this subsection
+ * @constants:    physical constants of the new subsection
+ *
+ * Creates a new subsection like subsection_new_with_constants() that takes
+ * ownership of @ca instead of copying it. @ca may be a view made with
+ * coarray_subarray_view(). It is freed with the subsection and must not be
+ * used by the caller after the call.
+ *
+ * Returns: a new subsection
+ */
+extern Subsection
+subsection_new_adopt(CoArray          ca,
+                     double           roughness,
+                     double           y_activation,
+                     const Constants *constants);
+
+/**
+ * subsection_with_roughness:
+ * @ss:        a #Subsection
+ * @roughness: a roughness value for the new subsection
+ *
+ * Creates a new subsection with the coordinates, activation, and constants of
+ * @ss and roughness @roughness. The geometry of @ss, which does not depend on
+ * roughness, is shared with the new subsection instead of being rebuilt, so
+ * only the conveyance coefficient is computed. The shared geometry is
+ * reference counted and is freed with the last subsection that uses it.
+ * Subsections that share geometry must be created and freed from one thread
+ * at a time. The returned subsection is newly created and must be freed with
+ * subsection_free().
+ *
+ * Returns: a new subsection
+ */
+extern Subsection
+subsection_with_roughness(Subsection ss, double roughness);
+
 /**
  * subsection_free:
  * @ss: a #Subsection
@@ -59,6 +118,121 @@ subsection_free(Subsection ss);
 extern CrossSectionProps
 subsection_properties(Subsection ss, double y);
 
+/**
+ * subsection_properties_into:
+ * @ss:  a #Subsection
+ * @y:   a y-value for computing properties
+ * @xsp: location to store the subsection properties
+ *
+ * Computes the area, top width, wetted perimeter, hydraulic radius, and
+ * conveyance of @ss at a y value and stores them in @xsp. The remaining
+ * properties in @xsp are set to `NAN`. No memory is allocated.
+ *
+ * Returns: nothing
+ */
+extern void
+subsection_properties_into(Subsection ss, double y, XSPValues *xsp);
+
+/**
+ * subsection_geometry:
+ * @ss:        a #Subsection
+ * @y:         a y-value for computing properties
+ * @area:      location to store the wetted area
+ * @perimeter: location to store the wetted perimeter
+ * @top_width: location to store the top width
+ *
+ * Computes the area, wetted perimeter, and top width of @ss below @y. The
+ * geometry of @ss is stored as pieces between consecutive coordinate
+ * elevations, built when @ss is created, within which the area is quadratic
+ * and the wetted perimeter and top width are linear in @y. The values are
+ * exact and are computed with a binary search over the pieces and a
+ * polynomial evaluation. No memory is allocated. Activation of @ss is not
+ * checked.
+ *
+ * Returns: nothing
+ */
+extern void
+subsection_geometry(Subsection ss,
+                    double     y,
+                    double *   area,
+                    double *   perimeter,
+                    double *   top_width);
+
+/**
+ * subsection_geometry_deriv:
+ * @ss:          a #Subsection
+ * @y:           a y-value for computing properties
+ * @area:        location to store the wetted area
+ * @perimeter:   location to store the wetted perimeter
+ * @top_width:   location to store the top width
+ * @d_perimeter: location to store the derivative of the wetted perimeter
+ * @d_top_width: location to store the derivative of the top width
+ *
+ * Computes the same values as subsection_geometry() along with the
+ * derivatives of the wetted perimeter and top width with respect to @y, in
+ * the same evaluation. The derivatives are the slopes of the geometry piece
+ * containing @y. At coordinate elevations the derivatives are taken from
+ * above. The derivative of the area is the top width. No memory is
+ * allocated.
+ *
+ * Returns: nothing
+ */
+extern void
+subsection_geometry_deriv(Subsection ss,
+                          double     y,
+                          double *   area,
+                          double *   perimeter,
+                          double *   top_width,
+                          double *   d_perimeter,
+                          double *   d_top_width);
+
+/**
+ * subsection_conveyance:
+ * @ss:        a #Subsection
+ * @area:      wetted area of @ss
+ * @perimeter: wetted perimeter of @ss
+ *
+ * Returns: the conveyance of @ss computed from its wetted area and perimeter
+ */
+extern double
+subsection_conveyance(Subsection ss, double area, double perimeter);
+
+/**
+ * BATCH_CHUNK:
+ *
+ * Number of depths processed together by subsection_properties_batch()
+ */
+#define BATCH_CHUNK 64
+
+/**
+ * subsection_properties_batch:
+ * @ss:         a #Subsection
+ * @n:          number of y-values
+ * @y:          array of @n y-values
+ * @area:       array of @n values to store the area
+ * @perimeter:  array of @n values to store the wetted perimeter
+ * @top_width:  array of @n values to store the top width
+ * @conveyance: array of @n values to store the conveyance
+ *
+ * Computes the area, wetted perimeter, top width, and conveyance of @ss at
+ * each y-value in @y. All of the values are 0 at y-values where @ss is not
+ * activated. Depths are processed in blocks of #BATCH_CHUNK. Subsections
+ * with few segments are integrated with a kernel vectorized across depths,
+ * with AVX2 and AVX-512 kernels selected at run time on processors that
+ * support them. Larger subsections are evaluated from their geometry pieces.
+ * No memory is allocated.
+ *
+ * Returns: nothing
+ */
+extern void
+subsection_properties_batch(Subsection    ss,
+                            int           n,
+                            const double *y,
+                            double *      area,
+                            double *      perimeter,
+                            double *      top_width,
+                            double *      conveyance);
+
 /**
  * subsection_roughness:
  * @ss: a #Subsection
@@ -89,4 +263,15 @@ subsection_activated(Subsection ss, double y);
 extern double
 subsection_z(Subsection ss);
 
+/**
+ * subsection_coarray:
+ * @ss: a #Subsection
+ *
+ * The returned coordinate array is owned by @ss and must not be freed.
+ *
+ * Returns: the coordinate array of @ss
+ */
+extern CoArray
+subsection_coarray(Subsection ss);
+
 #endif
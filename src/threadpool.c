@@ -0,0 +1,222 @@
+#include "threadpool.h"
+#include "mem.h"
+#include <assert.h>
+#include <stdbool.h>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+struct ThreadPool {
+    int n_threads; /* number of threads, including the calling thread */
+#if !defined(_WIN32)
+    int             n_workers;  /* number of worker threads started */
+    pthread_t *     workers;    /* worker threads */
+    pthread_mutex_t lock;       /* protects the fields below */
+    pthread_cond_t  work_ready; /* signaled when blocks are available */
+    pthread_cond_t  work_done;  /* signaled when the last block finishes */
+    ThreadPoolFunc  func;       /* function of the range, NULL if idle */
+    void *          data;       /* data passed to func */
+    int             n;          /* number of indices in the range */
+    int             block_size; /* number of indices in each block */
+    int             next;       /* first index of the next unclaimed block */
+    int             n_active;   /* number of blocks being evaluated */
+    bool            shutdown;   /* true when the workers should exit */
+#endif
+};
+
+#if !defined(_WIN32)
+/* Claims and evaluates blocks until none are left. The lock must be held and
+ * is held on return. */
+static void
+run_blocks(ThreadPool pool)
+{
+    int            begin;
+    int            end;
+    ThreadPoolFunc func = pool->func;
+    void *         data = pool->data;
+
+    while (pool->next < pool->n) {
+        begin = pool->next;
+        end   = pool->n - begin > pool->block_size ? begin + pool->block_size
+                                                   : pool->n;
+        pool->next = end;
+        pool->n_active++;
+        pthread_mutex_unlock(&pool->lock);
+
+        func(begin, end, data);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->n_active--;
+    }
+
+    if (pool->n_active == 0)
+        pthread_cond_signal(&pool->work_done);
+}
+
+static void *
+worker(void *arg)
+{
+    ThreadPool pool = arg;
+
+    pthread_mutex_lock(&pool->lock);
+
+    for (;;) {
+        while (!pool->shutdown &&
+               (pool->func == NULL || pool->next >= pool->n))
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+
+        if (pool->shutdown)
+            break;
+
+        run_blocks(pool);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+#endif
+
+ThreadPool
+threadpool_new(int n_threads)
+{
+    ThreadPool pool;
+    NEW(pool);
+
+    pool->n_threads = 1;
+
+#if !defined(_WIN32)
+    int i;
+
+    pool->n_workers  = 0;
+    pool->workers    = NULL;
+    pool->func       = NULL;
+    pool->data       = NULL;
+    pool->n          = 0;
+    pool->block_size = 1;
+    pool->next       = 0;
+    pool->n_active   = 0;
+    pool->shutdown   = false;
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+
+    if (n_threads > 1) {
+        pool->workers = mem_calloc(
+            n_threads - 1, sizeof(pthread_t), __FILE__, __LINE__);
+
+        for (i = 0; i < n_threads - 1; i++) {
+            if (pthread_create(pool->workers + pool->n_workers, NULL, worker,
+                               pool) == 0)
+                pool->n_workers++;
+        }
+    }
+
+    pool->n_threads = pool->n_workers + 1;
+#else
+    (void) n_threads;
+#endif
+
+    return pool;
+}
+
+void
+threadpool_free(ThreadPool pool)
+{
+    assert(pool);
+
+#if !defined(_WIN32)
+    int i;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 0; i < pool->n_workers; i++)
+        pthread_join(pool->workers[i], NULL);
+
+    pthread_cond_destroy(&pool->work_done);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_mutex_destroy(&pool->lock);
+
+    if (pool->workers)
+        FREE(pool->workers);
+#endif
+
+    FREE(pool);
+}
+
+int
+threadpool_n_threads(ThreadPool pool)
+{
+    assert(pool);
+
+    return pool->n_threads;
+}
+
+void
+threadpool_run(ThreadPool     pool,
+               int            n,
+               int            block_size,
+               ThreadPoolFunc func,
+               void *         data)
+{
+    assert(pool && func && block_size > 0);
+
+    if (n <= 0)
+        return;
+
+#if !defined(_WIN32)
+    if (pool->n_workers > 0 && n > block_size) {
+        pthread_mutex_lock(&pool->lock);
+
+        pool->func       = func;
+        pool->data       = data;
+        pool->n          = n;
+        pool->block_size = block_size;
+        pool->next       = 0;
+        pthread_cond_broadcast(&pool->work_ready);
+
+        run_blocks(pool);
+        while (pool->n_active > 0)
+            pthread_cond_wait(&pool->work_done, &pool->lock);
+
+        pool->func = NULL;
+        pool->data = NULL;
+
+        pthread_mutex_unlock(&pool->lock);
+        return;
+    }
+#endif
+
+    func(0, n, data);
+}
+
+void
+threadpool_parallel_for(int            n_threads,
+                        int            n,
+                        int            block_size,
+                        ThreadPoolFunc func,
+                        void *         data)
+{
+    assert(func && block_size > 0);
+
+    ThreadPool pool;
+    int        n_blocks = n > 0 ? (n - 1) / block_size + 1 : 0;
+
+    if (n_threads > n_blocks)
+        n_threads = n_blocks;
+
+    if (n_threads <= 1) {
+        if (n > 0)
+            func(0, n, data);
+        return;
+    }
+
+    pool = threadpool_new(n_threads);
+    threadpool_run(pool, n, block_size, func, data);
+    threadpool_free(pool);
+}
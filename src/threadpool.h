@@ -0,0 +1,115 @@
+#ifndef THREAD_POOL_INCLUDED
+#define THREAD_POOL_INCLUDED
+
+/**
+ * SECTION: threadpool.h
+ * @short_description: Thread pool
+ * @title: Thread pool
+ *
+ * A pool of worker threads that evaluates independent blocks of a range of
+ * indices. The calling thread takes part in the work. Blocks are claimed in
+ * order by whichever thread is free, so work functions that write only the
+ * outputs of their own indices give the same results for any number of
+ * threads. Threads are not used on Windows, where work is always done by the
+ * calling thread.
+ */
+
+/**
+ * ThreadPool:
+ *
+ * Pool of worker threads
+ */
+typedef struct ThreadPool *ThreadPool;
+
+/**
+ * ThreadPoolFunc:
+ * @begin: first index of the block
+ * @end:   one past the last index of the block
+ * @data:  data passed to threadpool_run()
+ *
+ * Evaluates the indices from @begin up to @end. The function is called from
+ * several threads at once with different blocks.
+ *
+ * Returns: nothing
+ */
+typedef void (*ThreadPoolFunc)(int begin, int end, void *data);
+
+/**
+ * threadpool_new:
+ * @n_threads: number of threads, including the calling thread
+ *
+ * Creates a thread pool and starts @n_threads - 1 worker threads. Fewer
+ * workers are started if threads cannot be created. The returned pool is
+ * newly created and must be freed with threadpool_free().
+ *
+ * Returns: a new thread pool
+ */
+extern ThreadPool
+threadpool_new(int n_threads);
+
+/**
+ * threadpool_free:
+ * @pool: a #ThreadPool
+ *
+ * Stops the worker threads of @pool and frees @pool.
+ *
+ * Returns: nothing
+ */
+extern void
+threadpool_free(ThreadPool pool);
+
+/**
+ * threadpool_n_threads:
+ * @pool: a #ThreadPool
+ *
+ * Returns: the number of threads in @pool, including the calling thread
+ */
+extern int
+threadpool_n_threads(ThreadPool pool);
+
+/**
+ * threadpool_run:
+ * @pool:       a #ThreadPool
+ * @n:          number of indices
+ * @block_size: number of indices in each block
+ * @func:       a #ThreadPoolFunc
+ * @data:       data passed to @func
+ *
+ * Divides the indices from 0 up to @n into blocks of @block_size indices and
+ * calls @func for each block from the worker threads of @pool and the
+ * calling thread. Returns when all blocks have been evaluated. A pool runs
+ * one range at a time and must not be used by two threads at once. No memory
+ * is allocated.
+ *
+ * Returns: nothing
+ */
+extern void
+threadpool_run(ThreadPool     pool,
+               int            n,
+               int            block_size,
+               ThreadPoolFunc func,
+               void *         data);
+
+/**
+ * threadpool_parallel_for:
+ * @n_threads:  maximum number of threads, including the calling thread
+ * @n:          number of indices
+ * @block_size: number of indices in each block
+ * @func:       a #ThreadPoolFunc
+ * @data:       data passed to @func
+ *
+ * Evaluates the indices from 0 up to @n with threadpool_run() on a pool
+ * created for the call. The number of threads is limited to the number of
+ * blocks. If only one thread is used, @func is called once for all of the
+ * indices on the calling thread and no memory is allocated.
+ *
+ * Returns: nothing
+ */
+extern void
+threadpool_parallel_for(int            n_threads,
+                        int            n,
+                        int            block_size,
+                        ThreadPoolFunc func,
+                        void *         data);
+
+#endif
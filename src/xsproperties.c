@@ -5,7 +5,7 @@
 /* cross section properties interface */
 
 struct CrossSectionProps {
-    double *properties;
+    XSPValues values;
 };
 
 CrossSectionProps
@@ -13,7 +13,8 @@ xsp_new(void)
 {
     CrossSectionProps xsp;
     NEW(xsp);
-    xsp->properties = mem_calloc(N_XSP, sizeof(double), __FILE__, __LINE__);
+    for (int i = 0; i < N_XSP; i++)
+        xsp->values.values[i] = 0;
     return xsp;
 }
 
@@ -21,7 +22,6 @@ void
 xsp_free(CrossSectionProps xsp)
 {
     assert(xsp);
-    mem_free(xsp->properties, __FILE__, __LINE__);
     FREE(xsp);
 }
 
@@ -29,38 +29,44 @@ CrossSectionProps
 xsp_copy(CrossSectionProps xsp)
 {
     assert(xsp);
-    double            value;
     CrossSectionProps new_xsp = xsp_new();
-    for (int i = 0; i < N_XSP; i++) {
-        value = xsp_get(xsp, i);
-        xsp_set(new_xsp, i, value);
-    }
+    new_xsp->values           = xsp->values;
     return new_xsp;
 }
 
+XSPValues *
+xsp_values(CrossSectionProps xsp)
+{
+    assert(xsp);
+    return &xsp->values;
+}
+
 double
 xsp_get(CrossSectionProps xsp, xs_prop prop)
 {
     assert(xsp);
-    return *(xsp->properties + prop);
+    return xsp->values.values[prop];
 }
 
 void
 xsp_set(CrossSectionProps xsp, xs_prop prop, double value)
 {
     assert(xsp);
-    *(xsp->properties + prop) = value;
+    xsp->values.values[prop] = value;
 }
 
-CrossSectionProps
-xsp_interp_depth(CrossSectionProps xsp1, CrossSectionProps xsp2, double depth)
+void
+xsp_values_interp_depth(const XSPValues *xsp1,
+                        const XSPValues *xsp2,
+                        double           depth,
+                        XSPValues *      xsp)
 {
-    double d1 = *(xsp1->properties + XS_DEPTH);
-    double d2 = *(xsp2->properties + XS_DEPTH);
+    assert(xsp1 && xsp2 && xsp);
 
-    assert(d1 <= depth && depth <= d2);
+    double d1 = xsp1->values[XS_DEPTH];
+    double d2 = xsp2->values[XS_DEPTH];
 
-    CrossSectionProps xsp = xsp_new();
+    assert(d1 <= depth && depth <= d2);
 
     double prop1;
     double prop2;
@@ -68,11 +74,19 @@ xsp_interp_depth(CrossSectionProps xsp1, CrossSectionProps xsp2, double depth)
     int i;
 
     for (i = 0; i < N_XSP; i++) {
-        prop1 = *(xsp1->properties + i);
-        prop2 = *(xsp2->properties + i);
-        *(xsp->properties + i) =
-            (prop2 - prop1) / (d2 - d1) * (depth - d1) + prop1;
+        prop1 = xsp1->values[i];
+        prop2 = xsp2->values[i];
+        xsp->values[i] = (prop2 - prop1) / (d2 - d1) * (depth - d1) + prop1;
     }
+}
+
+CrossSectionProps
+xsp_interp_depth(CrossSectionProps xsp1, CrossSectionProps xsp2, double depth)
+{
+    assert(xsp1 && xsp2);
+
+    CrossSectionProps xsp = xsp_new();
+    xsp_values_interp_depth(&xsp1->values, &xsp2->values, depth, &xsp->values);
 
     return xsp;
 }
@@ -17,6 +17,18 @@ xsp_new(void);
 extern CrossSectionProps
 xsp_copy(CrossSectionProps xsp);
 
+/**
+ * xsp_values:
+ * @xsp: a #CrossSectionProps
+ *
+ * Returns a pointer to the property values stored in @xsp. The values are
+ * owned by @xsp and are valid until @xsp is freed.
+ *
+ * Returns: the property values of @xsp
+ */
+extern XSPValues *
+xsp_values(CrossSectionProps xsp);
+
 /**
  * xsp_set:
  * @xsp: a #CrossSectionProps
@@ -46,4 +58,22 @@ xsp_set(CrossSectionProps xsp, xs_prop prop, double value);
 extern CrossSectionProps
 xsp_interp_depth(CrossSectionProps xsp1, CrossSectionProps xsp2, double depth);
 
+/**
+ * xsp_values_interp_depth:
+ * @xsp1: an #XSPValues
+ * @xsp2: another #XSPValues
+ * @depth: a depth to interpolate properties
+ * @xsp: location to store the interpolated properties
+ *
+ * Interpolates property values between @xsp1 and @xsp2 and stores them in
+ * @xsp. The depth of @xsp1 must be less than or equal to the depth of @xsp2.
+ *
+ * Returns: nothing
+ */
+extern void
+xsp_values_interp_depth(const XSPValues *xsp1,
+                        const XSPValues *xsp2,
+                        double           depth,
+                        XSPValues *      xsp);
+
 #endif
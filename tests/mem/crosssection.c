@@ -113,6 +113,34 @@ test_xs_normal_depth(void)
     xs_free(xs);
 }
 
+void
+test_xs_table(void)
+{
+    int     n           = 5;
+    double  z[]         = { 0, 0, 0.5, 1, 1 };
+    double  y[]         = { 1, 0, 0, 0, 1 };
+    int     n_roughness = 1;
+    double  r[]         = { 0.030 };
+    double *z_r         = NULL;
+
+    CrossSectionProps xsp;
+
+    CoArray      ca = coarray_new(n, y, z);
+    CrossSection xs = xs_new(ca, n_roughness, r, z_r);
+    coarray_free(ca);
+
+    xs_build_table(xs, 0, 1, 1e-3);
+    for (double h = 0.1; h < 2; h += 0.1) {
+        xsp = xs_hydraulic_properties(xs, h);
+        xsp_free(xsp);
+    }
+
+    /* rebuild the table before freeing the cross section */
+    xs_build_table(xs, 0, 2, 1e-3);
+
+    xs_free(xs);
+}
+
 void
 test_crosssection(void)
 {
@@ -120,4 +148,5 @@ test_crosssection(void)
     test_xs_properties();
     test_xs_critical_depth();
     test_xs_normal_depth();
+    test_xs_table();
 }
@@ -0,0 +1,54 @@
+from unittest import TestCase
+
+import numpy as np
+
+from pantherapy.panthera import CrossSection
+from pantherapy.reach import Reach
+from pantherapy.steady.boundaryvalue import BoundaryValuePlan
+
+
+class TestBoundaryValueSolution(TestCase):
+
+    def test_fixed_ends(self):
+
+        y_xs = [10, 0, 0, 10]
+        z_xs = [0, 20, 30, 50]
+        roughness = 0.013
+
+        xs = CrossSection(y_xs, z_xs, roughness)
+
+        slope = 0.001
+        stream_distance = np.linspace(0, 1e3, num=50)
+        thalweg = stream_distance[::-1] * slope
+        reach = Reach()
+
+        for x, y in zip(stream_distance, thalweg):
+            reach.put(xs, x, y)
+
+        flow = 30
+        wse_sstep, _ = reach.standard_step(flow, 5, 'downstream')
+
+        wse_0 = np.linspace(wse_sstep[0], wse_sstep[-1], num=50)
+
+        plan = BoundaryValuePlan(reach)
+        solution = plan.solve(wse_0, 10)
+
+        self.assertAlmostEqual(solution.discharge(), flow, places=6)
+        np.testing.assert_allclose(solution.wse(), wse_sstep, atol=1e-6)
+
+    def test_two_nodes(self):
+
+        xs = CrossSection([10, 0, 0, 10], [0, 20, 30, 50], 0.013)
+
+        reach = Reach()
+        reach.put(xs, 0, 0.1)
+        reach.put(xs, 100, 0)
+
+        flow = 30
+        wse_sstep, _ = reach.standard_step(flow, 5, 'downstream')
+
+        plan = BoundaryValuePlan(reach)
+        solution = plan.solve(wse_sstep, 10)
+
+        self.assertAlmostEqual(solution.discharge(), flow, places=6)
+        np.testing.assert_allclose(solution.wse(), wse_sstep)
@@ -1,7 +1,10 @@
+#include <coarray.h>
 #include <glib.h>
+#include <math.h>
 #include <panthera/crosssection.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 void
 test_coarray_new(void)
@@ -88,6 +91,71 @@ test_coarray_subarray(void)
     coarray_free(ca1);
 }
 
+void
+test_coarray_new_adopt(void)
+{
+    int     n = 4;
+    double *y = malloc(n * sizeof(double));
+    double *z = malloc(n * sizeof(double));
+    CoArray ca;
+
+    for (int i = 0; i < n; i++) {
+        y[i] = 4 - i;
+        z[i] = i;
+    }
+
+    ca = coarray_new_adopt(n, y, z);
+
+    g_assert_true(coarray_y(ca) == y);
+    g_assert_true(coarray_z(ca) == z);
+    g_assert_true(coarray_length(ca) == n);
+    g_assert_true(coarray_max_y(ca) == 4);
+    g_assert_true(coarray_min_y(ca) == 1);
+
+    coarray_free(ca);
+}
+
+void
+test_coarray_subarray_view(void)
+{
+    int    n   = 5;
+    double y[] = { 1.5, 1, 0.5, 1, 1.5 };
+    double z[] = { 0, 1, 2, 3, 4 };
+
+    CoArray ca = coarray_new(n, y, z);
+
+    /* boundaries at coordinates view the values of ca */
+    CoArray view     = coarray_subarray_view(ca, 1, 3);
+    CoArray expected = coarray_subarray(ca, 1, 3);
+    g_assert_true(coarray_y(view) == coarray_y(ca) + 1);
+    g_assert_true(coarray_eq(view, expected) == 0);
+    g_assert_true(coarray_min_y(view) == 0.5);
+    g_assert_true(coarray_max_y(view) == 1);
+    coarray_free(expected);
+
+    /* a view of a view refers to the same values */
+    CoArray view2 = coarray_subarray_view(view, 2, 3);
+    g_assert_true(coarray_y(view2) == coarray_y(ca) + 2);
+    g_assert_true(coarray_length(view2) == 2);
+
+    /* views remain valid after the array is freed */
+    coarray_free(ca);
+    coarray_free(view);
+    g_assert_true(coarray_y(view2)[0] == 0.5);
+    g_assert_true(coarray_z(view2)[1] == 3);
+    coarray_free(view2);
+
+    /* interpolated boundaries are copied */
+    ca       = coarray_new(n, y, z);
+    view     = coarray_subarray_view(ca, 0.5, 3);
+    expected = coarray_subarray(ca, 0.5, 3);
+    g_assert_true(coarray_y(view) != coarray_y(ca));
+    g_assert_true(coarray_eq(view, expected) == 0);
+    coarray_free(expected);
+    coarray_free(view);
+    coarray_free(ca);
+}
+
 void
 test_coarray_subarray_y(void)
 {
@@ -110,6 +178,45 @@ test_coarray_subarray_y(void)
     coarray_free(ca1);
 }
 
+void
+test_coarray_subarray_y_gaps(void)
+{
+    int    n   = 5;
+    double y[] = { 2, 0, 2, 0, 2 };
+    double z[] = { 0, 1, 2, 3, 4 };
+
+    int    n_expected   = 7;
+    int    gap          = 3;
+    double y_expected[] = { 1, 0, 1, NAN, 1, 0, 1 };
+    double z_expected[] = { 0.5, 1, 1.5, NAN, 2.5, 3, 3.5 };
+
+    CoArray    ca = coarray_new(n, y, z);
+    CoArray    sa = coarray_subarray_y(ca, 1);
+    Coordinate c;
+
+    g_assert_true(coarray_length(sa) == n_expected);
+    g_assert_true(coarray_min_y(sa) == 0);
+    g_assert_true(coarray_max_y(sa) == 1);
+
+    for (int i = 0; i < n_expected; i++) {
+        c = coarray_get(sa, i);
+        if (i == gap) {
+            g_assert_true(c == NULL);
+            continue;
+        }
+        g_assert_true(c->y == y_expected[i] && c->z == z_expected[i]);
+        coord_free(c);
+    }
+
+    /* copies keep the NULL coordinates */
+    CoArray copy = coarray_copy(sa);
+    g_assert_true(coarray_eq(sa, copy) == 0);
+
+    coarray_free(ca);
+    coarray_free(sa);
+    coarray_free(copy);
+}
+
 void
 test_coarray_subarray_eq_z(void)
 {
@@ -245,12 +352,18 @@ main(int argc, char *argv[])
     g_test_init(&argc, &argv, NULL);
 
     g_test_add_func("/polonium-pollywog/coarray/new", test_coarray_new);
+    g_test_add_func("/polonium-pollywog/coarray/new_adopt",
+                    test_coarray_new_adopt);
     g_test_add_func("/polonium-pollywog/coarray/eq", test_coarray_eq);
     g_test_add_func("/polonium-pollywog/coarray/copy", test_coarray_copy);
     g_test_add_func("/polonium-pollywog/coarray/subarray",
                     test_coarray_subarray);
+    g_test_add_func("/polonium-pollywog/coarray/subarray/view",
+                    test_coarray_subarray_view);
     g_test_add_func("/polonium-pollywog/coarray/subarray_y",
                     test_coarray_subarray_y);
+    g_test_add_func("/polonium-pollywog/coarray/subarray_y/gaps",
+                    test_coarray_subarray_y_gaps);
     g_test_add_func("/polonium-pollywog/coarray/subarray/equal z",
                     test_coarray_subarray_eq_z);
     g_test_add_func("/polonium-pollywog/coarray/subarray/trapezoid geometry",
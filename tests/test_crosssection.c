@@ -1,5 +1,7 @@
 #include "testlib.h"
 #include <glib.h>
+#include <math.h>
+#include <mem.h>
 #include <panthera/crosssection.h>
 
 #define ABS_TOL 1e-13
@@ -570,6 +572,930 @@ test_normal_depth(void)
     xs_free(xs);
 }
 
+void
+test_depth_solve(void)
+{
+    int     i;
+    int     j;
+    int     n           = 9;
+    double  z[]         = { 0, 0.25, 0.5, 0.75, 1, 1.25, 1.5, 1.75, 2 };
+    double  y[]         = { 1, 0.5, 0, 0.5, 1, 0.5, 0, 0.5, 1 };
+    int     n_roughness = 3;
+    double  r[]         = { 0.05, 0.01, 0.05 };
+    double  z_r[]       = { 0.75, 1.25 };
+    double  y0[]        = { NAN, -100, 0, 0.5, 1e6 };
+    double  depth[]     = { 0.1, 0.5, 0.75, 1, 3, 50 };
+    double  slope       = 0.001;
+    double  critical_flow;
+    double  normal_flow;
+    double  solution;
+    long    n_allocations;
+
+    CoArray      ca = coarray_new(n, y, z);
+    CrossSection xs = xs_new(ca, n_roughness, r, z_r);
+    XSPValues    xsp;
+    XSSolveInfo  info;
+
+    /* solutions are found for poor initial depths and for depths above the
+     * maximum y-value of the cross section */
+    for (i = 0; i < 6; i++) {
+        xs_hydraulic_properties_into(xs, depth[i], &xsp);
+        critical_flow = xsp.values[XS_CRITICAL_FLOW];
+        normal_flow   = sqrt(slope) * xsp.values[XS_CONVEYANCE];
+
+        for (j = 0; j < 5; j++) {
+            n_allocations = mem_n_allocations();
+            solution =
+                xs_critical_depth_solve(xs, critical_flow, y0[j], &info);
+            g_assert_true(mem_n_allocations() == n_allocations);
+            g_assert_true(info.converged);
+            g_assert_true(info.n_evaluations >= info.n_iterations);
+            g_assert_true(test_is_close(solution, depth[i], 0, 1e-6));
+
+            solution = xs_normal_depth_solve(
+                xs, normal_flow, slope, y0[j], &info);
+            g_assert_true(mem_n_allocations() == n_allocations);
+            g_assert_true(info.converged);
+            g_assert_true(test_is_close(solution, depth[i], 0, 1e-6));
+        }
+    }
+
+    /* zero flow is at the minimum y-value and negative flow has no solution */
+    g_assert_true(xs_critical_depth(xs, 0, 1) == 0);
+    g_assert_true(isnan(xs_critical_depth_solve(xs, -1, 1, &info)));
+    g_assert_false(info.converged);
+    g_assert_true(isnan(xs_normal_depth(xs, 1, 0, 1)));
+
+    /* solutions using the property table satisfy the table values */
+    xs_build_table(xs, 0, 1, 1e-3);
+    for (i = 0; i < 4; i++) {
+        xs_hydraulic_properties_into(xs, depth[i], &xsp);
+        critical_flow = xsp.values[XS_CRITICAL_FLOW];
+        solution = xs_critical_depth_solve(xs, critical_flow, NAN, &info);
+        g_assert_true(info.converged);
+        xs_hydraulic_properties_into(xs, solution, &xsp);
+        g_assert_true(test_is_close(
+            xsp.values[XS_CRITICAL_FLOW], critical_flow, 0, 1e-6));
+    }
+
+    coarray_free(ca);
+    xs_free(xs);
+}
+
+void
+test_xs_table(void)
+{
+    int     i;
+    int     j;
+    int     n           = 9;
+    double  z[]         = { 0, 0.25, 0.5, 0.75, 1, 1.25, 1.5, 1.75, 2 };
+    double  y[]         = { 1, 0.5, 0, 0.5, 1, 0.5, 0, 0.5, 1 };
+    int     n_roughness = 3;
+    double  r[]         = { 0.05, 0.01, 0.05 };
+    double  z_r[]       = { 0.75, 1.25 };
+    double  max_error   = 1e-3;
+    double  depth;
+    double  exact_value;
+    double  table_value;
+
+    CoArray           ca    = coarray_new(n, y, z);
+    CrossSection      xs    = xs_new(ca, n_roughness, r, z_r);
+    CrossSection      exact = xs_new(ca, n_roughness, r, z_r);
+    CrossSectionProps xsp;
+    CrossSectionProps xsp_exact;
+
+    g_assert_true(xs_table_size(xs) == 0);
+    xs_build_table(xs, 0, 1, max_error);
+    g_assert_true(xs_table_size(xs) > 2);
+
+    /* depths within the table range are within the error bound */
+    for (i = 1; i < 200; i++) {
+        depth     = (double) i / 200;
+        xsp       = xs_hydraulic_properties(xs, depth);
+        xsp_exact = xs_hydraulic_properties(exact, depth);
+        for (j = 0; j < N_XSP; j++) {
+            exact_value = xsp_get(xsp_exact, j);
+            table_value = xsp_get(xsp, j);
+            g_assert_true(
+                test_is_close(table_value, exact_value, 0, 2 * max_error));
+        }
+        xsp_free(xsp);
+        xsp_free(xsp_exact);
+    }
+
+    /* depths outside of the table range are computed exactly */
+    xsp       = xs_hydraulic_properties(xs, 1.5);
+    xsp_exact = xs_hydraulic_properties(exact, 1.5);
+    for (j = 0; j < N_XSP; j++)
+        g_assert_true(xsp_get(xsp, j) == xsp_get(xsp_exact, j));
+    xsp_free(xsp);
+    xsp_free(xsp_exact);
+
+    xs_clear_table(xs);
+    g_assert_true(xs_table_size(xs) == 0);
+
+    coarray_free(ca);
+    xs_free(xs);
+    xs_free(exact);
+}
+
+void
+test_xs_properties_into(void)
+{
+    int     i;
+    int     j;
+    int     n           = 9;
+    double  z[]         = { 0, 0.25, 0.5, 0.75, 1, 1.25, 1.5, 1.75, 2 };
+    double  y[]         = { 1, 0.5, 0, 0.5, 1, 0.5, 0, 0.5, 1 };
+    int     n_roughness = 3;
+    double  r[]         = { 0.05, 0.01, 0.05 };
+    double  z_r[]       = { 0.75, 1.25 };
+    double  depth;
+    long    n_allocations;
+
+    CoArray           ca = coarray_new(n, y, z);
+    CrossSection      xs = xs_new(ca, n_roughness, r, z_r);
+    CrossSectionProps xsp;
+    XSPValues         values;
+
+    /* values match the values of the allocating interface */
+    for (i = 0; i < 30; i++) {
+        depth = (double) i / 20;
+        xsp   = xs_hydraulic_properties(xs, depth);
+        xs_hydraulic_properties_into(xs, depth, &values);
+        for (j = 0; j < N_XSP; j++) {
+            if (isnan(xsp_get(xsp, j)))
+                g_assert_true(isnan(values.values[j]));
+            else
+                g_assert_true(xsp_get(xsp, j) == values.values[j]);
+        }
+        xsp_free(xsp);
+    }
+
+    xs_hydraulic_properties_into(xs, NAN, &values);
+    for (j = 0; j < N_XSP; j++)
+        g_assert_true(isnan(values.values[j]));
+
+    /* no memory is allocated with or without a property table */
+    n_allocations = mem_n_allocations();
+    for (i = 0; i < 100; i++)
+        xs_hydraulic_properties_into(xs, (double) i / 50, &values);
+    g_assert_true(mem_n_allocations() == n_allocations);
+
+    xs_build_table(xs, 0, 1, 1e-3);
+    n_allocations = mem_n_allocations();
+    for (i = 0; i < 100; i++)
+        xs_hydraulic_properties_into(xs, (double) i / 50, &values);
+    g_assert_true(mem_n_allocations() == n_allocations);
+
+    coarray_free(ca);
+    xs_free(xs);
+}
+
+void
+test_xs_properties_batch(void)
+{
+    int     i;
+    int     j;
+    int     n           = 9;
+    double  z[]         = { 0, 0.25, 0.5, 0.75, 1, 1.25, 1.5, 1.75, 2 };
+    double  y[]         = { 1, 0.5, 0, 0.5, 1, 0.5, 0, 0.5, 1 };
+    int     n_roughness = 3;
+    double  r[]         = { 0.05, 0.01, 0.05 };
+    double  z_r[]       = { 0.75, 1.25 };
+    int     n_depths    = 203;
+    double  depths[203];
+    double  out[203 * N_XSP];
+    double  value;
+    long    n_allocations;
+
+    CoArray      ca = coarray_new(n, y, z);
+    CrossSection xs = xs_new(ca, n_roughness, r, z_r);
+    XSPValues    values;
+
+    /* depths below, within, and above the cross section, including depths
+     * at coordinate elevations and non-finite depths */
+    for (i = 0; i < 200; i++)
+        depths[i] = -0.25 + (double) i / 100;
+    depths[200] = NAN;
+    depths[201] = INFINITY;
+    depths[202] = 0.5;
+
+    n_allocations = mem_n_allocations();
+    xs_hydraulic_properties_batch(xs, n_depths, depths, out);
+    g_assert_true(mem_n_allocations() == n_allocations);
+
+    for (i = 0; i < n_depths; i++) {
+        xs_hydraulic_properties_into(xs, depths[i], &values);
+        for (j = 0; j < N_XSP; j++) {
+            value = out[j * n_depths + i];
+            if (isnan(values.values[j]))
+                g_assert_true(isnan(value));
+            else
+                g_assert_true(
+                    test_is_close(value, values.values[j], ABS_TOL, 1e-12));
+        }
+    }
+
+    coarray_free(ca);
+    xs_free(xs);
+}
+
+void
+test_xs_properties_masked(void)
+{
+    int     i;
+    int     j;
+    int     k;
+    int     n           = 9;
+    double  z[]         = { 0, 0.25, 0.5, 0.75, 1, 1.25, 1.5, 1.75, 2 };
+    double  y[]         = { 1, 0.5, 0, 0.5, 1, 0.5, 0, 0.5, 1 };
+    int     n_roughness = 3;
+    double  r[]         = { 0.05, 0.01, 0.05 };
+    double  z_r[]       = { 0.75, 1.25 };
+    double  depth;
+
+    unsigned int masks[] = {
+        XS_MASK_CONVEYANCE,
+        XS_MASK_AREA | XS_MASK_TOP_WIDTH | XS_MASK_CRITICAL_FLOW,
+        XS_MASK_VELOCITY_COEFF,
+        XS_MASK_HYDRAULIC_DEPTH | XS_MASK_HYDRAULIC_RADIUS,
+        XS_MASK_ALL
+    };
+    int n_masks = sizeof(masks) / sizeof(masks[0]);
+
+    CoArray      ca = coarray_new(n, y, z);
+    CrossSection xs = xs_new(ca, n_roughness, r, z_r);
+    XSPValues    values;
+    XSPValues    masked;
+
+    /* selected properties match the unmasked values */
+    for (i = 0; i < 30; i++) {
+        depth = (double) i / 20;
+        xs_hydraulic_properties_into(xs, depth, &values);
+        for (k = 0; k < n_masks; k++) {
+            xs_hydraulic_properties_masked(xs, depth, masks[k], &masked);
+            for (j = 0; j < N_XSP; j++) {
+                if (!(masks[k] & (1 << j)))
+                    continue;
+                if (isnan(values.values[j]))
+                    g_assert_true(isnan(masked.values[j]));
+                else
+                    g_assert_true(values.values[j] == masked.values[j]);
+            }
+        }
+    }
+
+    coarray_free(ca);
+    xs_free(xs);
+}
+
+void
+test_xs_properties_deriv(void)
+{
+    int     i;
+    int     j;
+    int     n           = 9;
+    double  z[]         = { 0, 0.25, 0.5, 0.75, 1, 1.25, 1.5, 1.75, 2 };
+    double  y[]         = { 1, 0.5, 0, 0.5, 1, 0.5, 0, 0.5, 1 };
+    int     n_roughness = 3;
+    double  r[]         = { 0.05, 0.01, 0.05 };
+    double  z_r[]       = { 0.75, 1.25 };
+    double  step        = 1e-6;
+    double  depth;
+    double  fd;
+
+    CoArray      ca = coarray_new(n, y, z);
+    CrossSection xs = xs_new(ca, n_roughness, r, z_r);
+    XSPValues    values;
+    XSPValues    deriv;
+    XSPValues    values_lo;
+    XSPValues    values_hi;
+
+    /* derivatives match central differences away from coordinate
+     * elevations, above and below the top of the cross section */
+    for (i = 0; i < 15; i++) {
+        depth = 0.03 + (double) i / 10;
+        xs_hydraulic_properties_deriv(xs, depth, &values, &deriv);
+        xs_hydraulic_properties_into(xs, depth - step, &values_lo);
+        xs_hydraulic_properties_into(xs, depth + step, &values_hi);
+        for (j = 0; j < N_XSP; j++) {
+            fd = (values_hi.values[j] - values_lo.values[j]) / (2 * step);
+            g_assert_true(test_is_close(deriv.values[j], fd, 1e-6, 1e-5));
+        }
+    }
+
+    /* derivatives at a coordinate elevation are taken from above */
+    depth = 0.5;
+    xs_hydraulic_properties_deriv(xs, depth, &values, &deriv);
+    xs_hydraulic_properties_into(xs, depth, &values_lo);
+    xs_hydraulic_properties_into(xs, depth + step, &values_hi);
+    fd = (values_hi.values[XS_TOP_WIDTH] - values_lo.values[XS_TOP_WIDTH]) /
+         step;
+    g_assert_true(test_is_close(deriv.values[XS_TOP_WIDTH], fd, 1e-6, 1e-5));
+
+    coarray_free(ca);
+    xs_free(xs);
+}
+
+void
+test_xs_with_roughness(void)
+{
+    int    i;
+    int    j;
+    int    k;
+    int    n           = 9;
+    double z[]         = { 0, 0.25, 0.5, 0.75, 1, 1.25, 1.5, 1.75, 2 };
+    double y[]         = { 1, 0.5, 0, 0.5, 1, 0.5, 0, 0.5, 1 };
+    int    n_roughness = 3;
+    double r[]         = { 0.05, 0.01, 0.05 };
+    double z_r[]       = { 0.75, 1.25 };
+    double r_sweep[3];
+    double depth;
+    long   n_allocations;
+
+    Constants    us = CONSTANTS_US;
+    CoArray      ca = coarray_new(n, y, z);
+    CrossSection xs = xs_new_with_constants(ca, n_roughness, r, z_r, &us);
+    CrossSection xs_sweep;
+    CrossSection xs_expected;
+    XSPValues    xsp;
+    XSPValues    xsp_expected;
+
+    for (i = 0; i < 100; i++) {
+        for (j = 0; j < n_roughness; j++)
+            r_sweep[j] = 0.01 + 0.0005 * i + 0.01 * j;
+
+        n_allocations = mem_n_allocations();
+        xs_sweep      = xs_with_roughness(xs, r_sweep);
+
+        /* the cross section, its subsection array, and one subsection for
+         * each roughness value */
+        g_assert_true(mem_n_allocations() - n_allocations <= 2 + n_roughness);
+
+        xs_expected =
+            xs_new_with_constants(ca, n_roughness, r_sweep, z_r, &us);
+
+        g_assert_true(xs_n_subsections(xs_sweep) == n_roughness);
+        g_assert_true(xs_constants(xs_sweep).manning == us.manning);
+
+        for (k = 0; k < 25; k++) {
+            depth = 0.05 * k;
+            xs_hydraulic_properties_into(xs_sweep, depth, &xsp);
+            xs_hydraulic_properties_into(xs_expected, depth, &xsp_expected);
+            for (j = 0; j < N_XSP; j++) {
+                if (isnan(xsp_expected.values[j]))
+                    g_assert_true(isnan(xsp.values[j]));
+                else
+                    g_assert_true(xsp.values[j] == xsp_expected.values[j]);
+            }
+        }
+
+        xs_free(xs_expected);
+
+        /* the shared geometry outlives the cross section it came from */
+        if (i == 99) {
+            xs_free(xs);
+            xs_hydraulic_properties_into(xs_sweep, 1, &xsp);
+            g_assert_true(xsp.values[XS_AREA] > 0);
+        }
+
+        xs_free(xs_sweep);
+    }
+
+    coarray_free(ca);
+}
+
+void
+test_xs_accessors(void)
+{
+    int    i;
+    int    n           = 9;
+    double z[]         = { 0, 0.25, 0.5, 0.75, 1, 1.25, 1.5, 1.75, 2 };
+    double y[]         = { 1, 0.5, 0, 0.5, 1, 0.5, 0, 0.5, 1.5 };
+    int    n_roughness = 3;
+    double r[]         = { 0.05, 0.01, 0.05 };
+    double z_r[]       = { 0.75, 1.25 };
+    double z_r_mid[]   = { 0.6, 1.25 };
+    int    n_span;
+    long   n_allocations;
+
+    const double *xs_y_values;
+    const double *xs_z_values;
+    const double *span_y;
+    const double *span_z;
+
+    CoArray      ca = coarray_new(n, y, z);
+    CrossSection xs = xs_new(ca, n_roughness, r, z_r);
+    CoArray      expected;
+
+    n_allocations = mem_n_allocations();
+
+    xs_y_values = xs_y(xs);
+    xs_z_values = xs_z(xs);
+    g_assert_true(xs_n_coordinates(xs) == n);
+    for (i = 0; i < n; i++) {
+        g_assert_true(xs_y_values[i] == y[i]);
+        g_assert_true(xs_z_values[i] == z[i]);
+    }
+    g_assert_true(xs_min_y(xs) == 0);
+    g_assert_true(xs_max_y(xs) == 1.5);
+
+    /* subsections with boundaries at coordinates view the coordinates */
+    n_span = xs_subsection_span(xs, 1, &span_y, &span_z);
+    g_assert_true(n_span == 3);
+    g_assert_true(span_y == xs_y_values + 3);
+    g_assert_true(span_z == xs_z_values + 3);
+
+    g_assert_true(mem_n_allocations() == n_allocations);
+
+    xs_free(xs);
+
+    /* interpolated boundaries */
+    xs       = xs_new(ca, n_roughness, r, z_r_mid);
+    expected = coarray_subarray(ca, z_r_mid[0], z_r_mid[1]);
+    n_span   = xs_subsection_span(xs, 1, &span_y, &span_z);
+    g_assert_true(n_span == coarray_length(expected));
+    for (i = 0; i < n_span; i++) {
+        g_assert_true(span_y[i] == coarray_y(expected)[i]);
+        g_assert_true(span_z[i] == coarray_z(expected)[i]);
+    }
+    g_assert_true(span_z[0] == z_r_mid[0]);
+
+    coarray_free(expected);
+    xs_free(xs);
+    coarray_free(ca);
+}
+
+void
+test_xs_new_adopt(void)
+{
+    int    i;
+    int    j;
+    int    n           = 9;
+    double z[]         = { 0, 0.25, 0.5, 0.75, 1, 1.25, 1.5, 1.75, 2 };
+    double y[]         = { 1, 0.5, 0, 0.5, 1, 0.5, 0, 0.5, 1 };
+    int    n_roughness = 3;
+    double r[]         = { 0.05, 0.01, 0.05 };
+    double z_r[]       = { 0.75, 1.25 };
+    double depth;
+    long   n_copy;
+    long   n_adopt;
+
+    Constants    us = CONSTANTS_US;
+    CoArray      ca = coarray_new(n, y, z);
+    CoArray      ca_adopted;
+    CrossSection xs;
+    CrossSection xs_adopted;
+    XSPValues    xsp;
+    XSPValues    xsp_adopted;
+
+    n_copy = mem_n_allocations();
+    xs     = xs_new_with_constants(ca, n_roughness, r, z_r, &us);
+    n_copy = mem_n_allocations() - n_copy;
+
+    ca_adopted = coarray_copy(ca);
+    n_adopt    = mem_n_allocations();
+    xs_adopted = xs_new_adopt(ca_adopted, n_roughness, r, z_r, &us);
+    n_adopt    = mem_n_allocations() - n_adopt;
+
+    /* the coordinate array and its values are not copied */
+    g_assert_true(n_copy - n_adopt == 3);
+    g_assert_true(xs_constants(xs_adopted).manning == us.manning);
+
+    for (i = 0; i < 25; i++) {
+        depth = 0.05 * i;
+        xs_hydraulic_properties_into(xs, depth, &xsp);
+        xs_hydraulic_properties_into(xs_adopted, depth, &xsp_adopted);
+        for (j = 0; j < N_XSP; j++) {
+            if (isnan(xsp.values[j]))
+                g_assert_true(isnan(xsp_adopted.values[j]));
+            else
+                g_assert_true(xsp_adopted.values[j] == xsp.values[j]);
+        }
+    }
+
+    xs_free(xs_adopted);
+    xs_free(xs);
+
+    /* NULL constants are the defaults */
+    xs         = xs_new(ca, n_roughness, r, z_r);
+    xs_adopted = xs_new_adopt(coarray_copy(ca), n_roughness, r, z_r, NULL);
+    xs_hydraulic_properties_into(xs, 0.75, &xsp);
+    xs_hydraulic_properties_into(xs_adopted, 0.75, &xsp_adopted);
+    g_assert_true(xsp_adopted.values[XS_CONVEYANCE] ==
+                  xsp.values[XS_CONVEYANCE]);
+
+    xs_free(xs_adopted);
+    xs_free(xs);
+    coarray_free(ca);
+}
+
+void
+test_xs_pool(void)
+{
+    int    i;
+    int    j;
+    int    n           = 9;
+    double z[]         = { 0, 0.25, 0.5, 0.75, 1, 1.25, 1.5, 1.75, 2 };
+    double y[]         = { 1, 0.5, 0, 0.5, 1, 0.5, 0, 0.5, 1 };
+    int    n_roughness = 3;
+    double r[]         = { 0.05, 0.01, 0.05 };
+    double z_r[]       = { 0.75, 1.25 };
+    double z_scaled[9];
+    double shift;
+    double y_offset;
+    double wse;
+    long   n_allocations;
+
+    XSPool       pool     = xs_pool_new(1e-9);
+    CoArray      template = coarray_new(n, y, z);
+    CoArray      shifted;
+    CrossSection xs_first;
+    CrossSection xs_interned;
+    CrossSection xs_shapes[40];
+    CrossSection xs_expected;
+    XSPValues    xsp;
+    XSPValues    xsp_expected;
+
+    xs_first = xs_pool_intern(
+        pool, template, n_roughness, r, z_r, NULL, &y_offset);
+    g_assert_true(y_offset == 0);
+
+    /* the same shape shifted vertically at many stations */
+    for (i = 0; i < 200; i++) {
+        shift       = 100 + 0.37 * i;
+        shifted     = coarray_add_y(template, shift);
+        xs_interned = xs_pool_intern(
+            pool, shifted, n_roughness, r, z_r, NULL, &y_offset);
+        g_assert_true(xs_interned == xs_first);
+        g_assert_true(test_is_close(y_offset, shift, 1e-12, 0));
+
+        xs_expected = xs_new(shifted, n_roughness, r, z_r);
+        for (j = 1; j <= 10; j++) {
+            wse = shift + 0.1 * j;
+            xs_hydraulic_properties_into(xs_interned, wse - y_offset, &xsp);
+            xs_hydraulic_properties_into(xs_expected, wse, &xsp_expected);
+            g_assert_true(test_is_close(xsp.values[XS_CONVEYANCE],
+                                        xsp_expected.values[XS_CONVEYANCE],
+                                        1e-9,
+                                        1e-9));
+        }
+
+        xs_free(xs_expected);
+        xs_free(xs_interned);
+        coarray_free(shifted);
+    }
+
+    g_assert_true(xs_pool_size(pool) == 1);
+
+    /* different roughness values are a different shape */
+    r[1]        = 0.02;
+    xs_interned = xs_pool_intern(
+        pool, template, n_roughness, r, z_r, NULL, &y_offset);
+    g_assert_true(xs_interned != xs_first);
+    g_assert_true(xs_pool_size(pool) == 2);
+    xs_free(xs_interned);
+
+    /* shapes that differ laterally grow the table */
+    for (i = 0; i < 40; i++) {
+        for (j = 0; j < n; j++)
+            z_scaled[j] = z[j] * (1 + 0.1 * i);
+        shifted      = coarray_new(n, y, z_scaled);
+        xs_shapes[i] = xs_pool_intern(
+            pool, shifted, 1, r, NULL, NULL, &y_offset);
+        coarray_free(shifted);
+    }
+    g_assert_true(xs_pool_size(pool) == 42);
+
+    for (i = 0; i < 40; i++) {
+        for (j = 0; j < n; j++)
+            z_scaled[j] = z[j] * (1 + 0.1 * i);
+        shifted = coarray_new(n, y, z_scaled);
+
+        n_allocations = mem_n_allocations();
+        xs_interned   = xs_pool_intern(
+            pool, shifted, 1, r, NULL, NULL, &y_offset);
+        g_assert_true(mem_n_allocations() == n_allocations);
+        g_assert_true(xs_interned == xs_shapes[i]);
+
+        xs_free(xs_interned);
+        coarray_free(shifted);
+    }
+
+    /* interned cross sections outlive the pool while referenced */
+    xs_pool_free(pool);
+    xs_hydraulic_properties_into(xs_first, 0.5, &xsp);
+    g_assert_true(xsp.values[XS_AREA] > 0);
+
+    for (i = 0; i < 40; i++)
+        xs_free(xs_shapes[i]);
+    xs_free(xs_first);
+    coarray_free(template);
+}
+
+void
+test_xs_pool_rounding(void)
+{
+    int    n   = 5;
+    double y[] = { 1, 0, 0, 0, 1 };
+    double z[] = { 0, 0, 1, 2, 2 };
+    double r   = 0.03;
+    double y_offset;
+
+    XSPool       pool = xs_pool_new(1e-3);
+    CoArray      ca;
+    CrossSection xs_below;
+    CrossSection xs_above;
+    CrossSection xs_near;
+
+    /* z-values within tolerance that round to the same multiple are one
+     * shape */
+    z[2]     = 1.0004999;
+    ca       = coarray_new(n, y, z);
+    xs_below = xs_pool_intern(pool, ca, 1, &r, NULL, NULL, &y_offset);
+    coarray_free(ca);
+
+    z[2]    = 1.0001;
+    ca      = coarray_new(n, y, z);
+    xs_near = xs_pool_intern(pool, ca, 1, &r, NULL, NULL, &y_offset);
+    coarray_free(ca);
+    g_assert_true(xs_near == xs_below);
+
+    /* z-values within tolerance on opposite sides of a rounding boundary
+     * hash differently and are not shared */
+    z[2]     = 1.0005001;
+    ca       = coarray_new(n, y, z);
+    xs_above = xs_pool_intern(pool, ca, 1, &r, NULL, NULL, &y_offset);
+    coarray_free(ca);
+    g_assert_true(xs_above != xs_below);
+    g_assert_true(xs_pool_size(pool) == 2);
+
+    xs_free(xs_above);
+    xs_free(xs_near);
+    xs_free(xs_below);
+    xs_pool_free(pool);
+}
+
+void
+test_xs_pool_table(void)
+{
+    int    i;
+    int    j;
+    int    n         = 5;
+    int    n_copies  = 20;
+    int    n_built   = 0;
+    double y[]       = { 1, 0, 0, 0, 1 };
+    double z[]       = { 0, 0, 1, 2, 2 };
+    double r         = 0.03;
+    double max_error = 1e-3;
+    double y_offset;
+
+    XSPool       pool     = xs_pool_new(1e-9);
+    CoArray      template = coarray_new(n, y, z);
+    CoArray      shifted;
+    CrossSection xs_interned[20];
+    CrossSection xs_expected = xs_new(template, 1, &r, NULL);
+    XSPValues    xsp;
+    XSPValues    xsp_expected;
+
+    xs_build_table(xs_expected, 0, 1, max_error);
+
+    /* every node with the shape builds or reuses the table of the shape */
+    for (i = 0; i < n_copies; i++) {
+        shifted        = coarray_add_y(template, 10 + 0.5 * i);
+        xs_interned[i] = xs_pool_intern(
+            pool, shifted, 1, &r, NULL, NULL, &y_offset);
+        n_built += xs_pool_build_table(pool, xs_interned[i], 0, 1, max_error);
+        coarray_free(shifted);
+    }
+
+    g_assert_true(n_built == 1);
+    g_assert_true(xs_pool_size(pool) == 1);
+
+    for (i = 0; i < n_copies; i++) {
+        g_assert_true(xs_interned[i] == xs_interned[0]);
+        g_assert_true(xs_table_size(xs_interned[i]) ==
+                      xs_table_size(xs_expected));
+
+        for (j = 1; j <= 10; j++) {
+            xs_hydraulic_properties_into(xs_interned[i], 0.095 * j, &xsp);
+            xs_hydraulic_properties_into(xs_expected, 0.095 * j, &xsp_expected);
+            g_assert_true(xsp.values[XS_CONVEYANCE] ==
+                          xsp_expected.values[XS_CONVEYANCE]);
+        }
+    }
+
+    for (i = 0; i < n_copies; i++)
+        xs_free(xs_interned[i]);
+    xs_free(xs_expected);
+    coarray_free(template);
+    xs_pool_free(pool);
+}
+
+void
+test_xs_constants(void)
+{
+    int    n           = 5;
+    double z[]         = { 0, 0, 0.5, 1, 1 };
+    double y[]         = { 1, 0, 0, 0, 1 };
+    int    n_roughness = 1;
+    double r[]         = { 0.030 };
+    double depth       = 0.5;
+
+    Constants si = CONSTANTS_SI;
+    Constants us = CONSTANTS_US;
+
+    CoArray      ca = coarray_new(n, y, z);
+    CrossSection xs_si;
+    CrossSection xs_us;
+    CrossSection xs_default;
+    XSPValues    xsp_si;
+    XSPValues    xsp_us;
+    XSPValues    xsp_default;
+
+    xs_si      = xs_new_with_constants(ca, n_roughness, r, NULL, &si);
+    xs_us      = xs_new_with_constants(ca, n_roughness, r, NULL, &us);
+    xs_default = xs_new(ca, n_roughness, r, NULL);
+
+    g_assert_true(xs_constants(xs_us).gravity == us.gravity);
+    g_assert_true(xs_constants(xs_us).manning == us.manning);
+
+    /* changing the defaults does not affect existing cross sections */
+    const_set_gravity(us.gravity);
+    const_set_manning(us.manning);
+
+    xs_hydraulic_properties_into(xs_si, depth, &xsp_si);
+    xs_hydraulic_properties_into(xs_us, depth, &xsp_us);
+    xs_hydraulic_properties_into(xs_default, depth, &xsp_default);
+
+    const_set_gravity(si.gravity);
+    const_set_manning(si.manning);
+
+    g_assert_true(test_is_close(xsp_us.values[XS_CONVEYANCE],
+                                us.manning * xsp_si.values[XS_CONVEYANCE],
+                                0,
+                                1e-12));
+    g_assert_true(
+        test_is_close(xsp_us.values[XS_CRITICAL_FLOW],
+                      sqrt(us.gravity / si.gravity) *
+                          xsp_si.values[XS_CRITICAL_FLOW],
+                      0,
+                      1e-12));
+    g_assert_true(xsp_default.values[XS_CONVEYANCE] ==
+                  xsp_si.values[XS_CONVEYANCE]);
+    g_assert_true(xsp_default.values[XS_CRITICAL_FLOW] ==
+                  xsp_si.values[XS_CRITICAL_FLOW]);
+
+    xs_free(xs_default);
+    xs_free(xs_us);
+    xs_free(xs_si);
+    coarray_free(ca);
+}
+
+void
+test_xs_many(void)
+{
+    int    i;
+    int    j;
+    int    n           = 9;
+    double z[]         = { 0, 0.25, 0.5, 0.75, 1, 1.25, 1.5, 1.75, 2 };
+    double y[]         = { 1, 0.5, 0, 0.5, 1, 0.5, 0, 0.5, 1 };
+    int    n_roughness = 3;
+    double r[3];
+    double z_r[]    = { 0.75, 1.25 };
+    int    n_xs     = 40;
+    int    n_depths = 50;
+    double slope    = 0.001;
+    double depths[40 * 50];
+    double out[40 * 50 * N_XSP];
+    double expected[50 * N_XSP];
+    double flow[40];
+    double slopes[40];
+    double depth[40];
+    double depth_serial[40];
+    double value;
+    long   n_allocations;
+
+    CoArray      ca = coarray_new(n, y, z);
+    CrossSection xs[40];
+    XSSolveInfo  info[40];
+
+    for (i = 0; i < n_xs; i++) {
+        r[0]      = 0.05 + 0.001 * i;
+        r[1]      = 0.01 + 0.001 * i;
+        r[2]      = r[0];
+        xs[i]     = xs_new(ca, n_roughness, r, z_r);
+        flow[i]   = 1 + 0.1 * i;
+        slopes[i] = slope;
+        for (j = 0; j < n_depths; j++)
+            depths[i * n_depths + j] = 0.01 * i + 0.02 * j;
+    }
+
+    /* rating curves of many cross sections match the single cross section
+     * batch exactly */
+    xs_hydraulic_properties_many(xs, n_xs, n_depths, depths, out, 4);
+    for (i = 0; i < n_xs; i++) {
+        xs_hydraulic_properties_batch(
+            xs[i], n_depths, depths + i * n_depths, expected);
+        for (j = 0; j < n_depths * N_XSP; j++) {
+            value = out[i * n_depths * N_XSP + j];
+            if (isnan(expected[j]))
+                g_assert_true(isnan(value));
+            else
+                g_assert_true(value == expected[j]);
+        }
+    }
+
+    n_allocations = mem_n_allocations();
+    xs_critical_depth_many(xs, n_xs, flow, NULL, depth_serial, NULL, 1);
+    g_assert_true(mem_n_allocations() == n_allocations);
+
+    xs_critical_depth_many(xs, n_xs, flow, NULL, depth, info, 4);
+    for (i = 0; i < n_xs; i++) {
+        value = xs_critical_depth(xs[i], flow[i], 1);
+        g_assert_true(info[i].converged);
+        g_assert_true(depth[i] == depth_serial[i]);
+        g_assert_true(test_is_close(depth[i], value, 0, 1e-8));
+    }
+
+    xs_normal_depth_many(xs, n_xs, flow, slopes, depth_serial, depth, info, 4);
+    for (i = 0; i < n_xs; i++) {
+        value = xs_normal_depth_solve(
+            xs[i], flow[i], slope, depth_serial[i], NULL);
+        g_assert_true(info[i].converged);
+        g_assert_true(depth[i] == value);
+    }
+
+    for (i = 0; i < n_xs; i++)
+        xs_free(xs[i]);
+    coarray_free(ca);
+}
+
+void
+test_xs_many_threads(void)
+{
+    int    i;
+    int    j;
+    int    n        = 9;
+    double z[]      = { 0, 0.25, 0.5, 0.75, 1, 1.25, 1.5, 1.75, 2 };
+    double y[]      = { 1, 0.5, 0, 0.5, 1, 0.5, 0, 0.5, 1 };
+    double r[]      = { 0.05, 0.01, 0.05 };
+    double z_r[]    = { 0.75, 1.25 };
+    int    n_xs     = 16;
+    int    n_depths = 8192;
+    double value;
+
+    CoArray      ca;
+    CrossSection xs[16];
+    double *     depths;
+    double *     out;
+    double *     expected;
+
+    /* The first batch evaluations of the process run on worker threads, so
+     * lazy one-time setup in the batch path would race. Every cross section
+     * has many depths so that the threads evaluate their first blocks at the
+     * same time. The test runs in a new process because earlier tests have
+     * already evaluated batches. */
+    if (!g_test_subprocess()) {
+        g_test_trap_subprocess(NULL, 0, G_TEST_SUBPROCESS_INHERIT_STDERR);
+        g_test_trap_assert_passed();
+        return;
+    }
+
+    depths   = g_malloc(n_xs * n_depths * sizeof(double));
+    out      = g_malloc(n_xs * n_depths * N_XSP * sizeof(double));
+    expected = g_malloc(n_depths * N_XSP * sizeof(double));
+
+    ca = coarray_new(n, y, z);
+    for (i = 0; i < n_xs; i++) {
+        xs[i] = xs_new(ca, 3, r, z_r);
+        for (j = 0; j < n_depths; j++)
+            depths[i * n_depths + j] = 1e-4 * j + 1e-3 * i;
+    }
+
+    xs_hydraulic_properties_many(xs, n_xs, n_depths, depths, out, 8);
+
+    for (i = 0; i < n_xs; i++) {
+        xs_hydraulic_properties_batch(
+            xs[i], n_depths, depths + i * n_depths, expected);
+        for (j = 0; j < n_depths * N_XSP; j++) {
+            value = out[i * n_depths * N_XSP + j];
+            if (isnan(expected[j]))
+                g_assert_true(isnan(value));
+            else
+                g_assert_true(value == expected[j]);
+        }
+    }
+
+    for (i = 0; i < n_xs; i++)
+        xs_free(xs[i]);
+    coarray_free(ca);
+    g_free(expected);
+    g_free(out);
+    g_free(depths);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -591,6 +1517,28 @@ main(int argc, char *argv[])
                     test_critical_depth);
     g_test_add_func("/pollywog/crosssection/xs_normal_depth",
                     test_normal_depth);
+    g_test_add_func("/pollywog/crosssection/xs_depth_solve", test_depth_solve);
+    g_test_add_func("/pollywog/crosssection/xs_build_table", test_xs_table);
+    g_test_add_func("/pollywog/crosssection/hydraulic_properties/into",
+                    test_xs_properties_into);
+    g_test_add_func("/pollywog/crosssection/hydraulic_properties/batch",
+                    test_xs_properties_batch);
+    g_test_add_func("/pollywog/crosssection/hydraulic_properties/masked",
+                    test_xs_properties_masked);
+    g_test_add_func("/pollywog/crosssection/hydraulic_properties/deriv",
+                    test_xs_properties_deriv);
+    g_test_add_func("/pollywog/crosssection/with roughness",
+                    test_xs_with_roughness);
+    g_test_add_func("/pollywog/crosssection/accessors", test_xs_accessors);
+    g_test_add_func("/pollywog/crosssection/new_adopt", test_xs_new_adopt);
+    g_test_add_func("/pollywog/crosssection/pool", test_xs_pool);
+    g_test_add_func("/pollywog/crosssection/pool/rounding",
+                    test_xs_pool_rounding);
+    g_test_add_func("/pollywog/crosssection/pool/table", test_xs_pool_table);
+    g_test_add_func("/pollywog/crosssection/constants", test_xs_constants);
+    g_test_add_func("/pollywog/crosssection/many", test_xs_many);
+    g_test_add_func("/pollywog/crosssection/many/threads",
+                    test_xs_many_threads);
 
     return g_test_run();
 }
@@ -72,6 +72,25 @@ class TestCrossSection(unittest.TestCase):
         self.assertTrue(np.array_equal(y, y_xs))
         self.assertTrue(np.array_equal(z, z_xs))
 
+    def test_coordinates_view(self):
+        """Test CrossSection.coordinates returns read-only views"""
+
+        y = np.array([1, 0, 0, 0, 1])
+        z = np.array([1, 1, 2, 3, 3])
+        xs = CrossSection(y, z, 0.030)
+        y_xs, z_xs = xs.coordinates()
+        y_again, _ = xs.coordinates()
+
+        self.assertTrue(np.shares_memory(y_xs, y_again))
+        self.assertFalse(y_xs.flags.writeable)
+        with self.assertRaises(ValueError):
+            y_xs[0] = 2
+
+        # the views keep the cross section alive
+        del xs, y_again
+        self.assertTrue(np.array_equal(y, y_xs))
+        self.assertTrue(np.array_equal(z, z_xs))
+
     def test_area(self):
         """Test CrossSection.area"""
 
@@ -151,3 +170,27 @@ class TestCrossSection(unittest.TestCase):
 
         self.assertTrue(np.allclose(e_expected, e_computed, rtol=1e-5, atol=0))
         self.assertTrue(np.isnan(xs.specific_energy(np.nan, Qc)))
+
+    def test_with_roughness(self):
+
+        y = np.array([5, 0, 0, 0, 5])
+        z = np.array([0, 0, 0.5, 1, 1])
+        xs = CrossSection(y, z, 0.030)
+
+        depth = np.linspace(0.25, 4)
+        xs_rough = xs.with_roughness(0.060)
+        expected = CrossSection(y, z, 0.060)
+
+        self.assertTrue(np.array_equal(xs_rough.area(depth),
+                                       xs.area(depth)))
+        self.assertTrue(np.allclose(xs_rough.conveyance(depth),
+                                    0.5 * xs.conveyance(depth),
+                                    rtol=1e-12, atol=0))
+        self.assertTrue(np.array_equal(xs_rough.conveyance(depth),
+                                       expected.conveyance(depth)))
+
+        del xs
+        self.assertTrue(np.array_equal(xs_rough.area(depth),
+                                       expected.area(depth)))
+
+        self.assertRaises(ValueError, expected.with_roughness, 0)
@@ -54,3 +54,82 @@ class TestInitialValueSolution(TestCase):
                 expected_depth,
                 rtol=0,
                 atol=0.001))
+
+    def test_fixed_bc_simultaneous(self):
+
+        y_xs = [10, 0, 0, 10]
+        z_xs = [0, 20, 30, 50]
+        roughness = 0.013
+
+        xs = CrossSection(y_xs, z_xs, roughness)
+
+        slope = 0.001
+        stream_distance = np.linspace(0, 4e3, num=5)
+        thalweg = stream_distance[::-1] * slope
+        reach = Reach()
+
+        for x, y in zip(stream_distance, thalweg):
+            reach.put(xs, x, y)
+
+        flow_data = SteadyFlow()
+        flow_data.set_flow(0, 30)
+
+        downstream_depth = 5
+        boundary_condition = FixedStageRelation(downstream_depth)
+        boundary_location = 'downstream'
+
+        plan = InitialValuePlan(
+            reach,
+            flow_data,
+            boundary_location,
+            boundary_condition)
+        solution = plan.solve(method='simul')
+
+        expected_depth = np.array([1.263, 2.038, 3.007, 4.002, 5])
+
+        computed_depth = solution.wse() - solution.thalweg()
+
+        self.assertTrue(
+            np.allclose(
+                computed_depth,
+                expected_depth,
+                rtol=0,
+                atol=0.001))
+
+    def test_fixed_bc_upstream(self):
+
+        y_xs = [10, 0, 0, 10]
+        z_xs = [0, 20, 30, 50]
+        roughness = 0.013
+
+        xs = CrossSection(y_xs, z_xs, roughness)
+
+        slope = 0.05
+        stream_distance = np.linspace(0, 1e3, num=11)
+        thalweg = stream_distance[::-1] * slope
+        reach = Reach()
+
+        for x, y in zip(stream_distance, thalweg):
+            reach.put(xs, x, y)
+
+        flow = 30
+        flow_data = SteadyFlow()
+        flow_data.set_flow(0, flow)
+
+        critical_depth = xs.critical_depth(flow)
+        normal_depth = xs.normal_depth(flow, slope)
+
+        boundary_condition = FixedStageRelation(thalweg[0] + critical_depth)
+        boundary_location = 'upstream'
+
+        plan = InitialValuePlan(
+            reach,
+            flow_data,
+            boundary_location,
+            boundary_condition)
+        solution = plan.solve()
+
+        computed_depth = solution.wse() - solution.thalweg()
+
+        self.assertTrue(np.all(computed_depth[1:] < critical_depth))
+        self.assertAlmostEqual(computed_depth[-1], normal_depth, places=3)
@@ -0,0 +1,234 @@
+#include "mem.h"
+#include "threadpool.h"
+#include <glib.h>
+#include <panthera/crosssection.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+void
+test_mem_arena_alloc(void)
+{
+    int     i;
+    long    n_allocations;
+    char *  small;
+    char *  heap;
+    double *large;
+
+    Arena arena = mem_arena_new(256);
+
+    small = ARENA_ALLOC(arena, 3);
+    large = ARENA_ALLOC(arena, 1000 * sizeof(double));
+
+    g_assert_true((uintptr_t) small % 16 == 0);
+    g_assert_true((uintptr_t) large % 16 == 0);
+    g_assert_true(mem_arena_owns(arena, small));
+    g_assert_true(mem_arena_owns(arena, large + 999));
+
+    for (i = 0; i < 1000; i++)
+        large[i] = i;
+
+    /* after a reset, the same allocations fit in one block */
+    mem_arena_reset(arena);
+    g_assert_false(mem_arena_owns(arena, small));
+
+    n_allocations = mem_n_allocations();
+    small         = ARENA_ALLOC(arena, 3);
+    large         = ARENA_ALLOC(arena, 1000 * sizeof(double));
+    g_assert_true(mem_n_allocations() == n_allocations);
+
+    /* new blocks are heap allocations */
+    large = ARENA_ALLOC(arena, 100000);
+    g_assert_true(mem_n_allocations() == n_allocations + 1);
+    g_assert_true(mem_arena_owns(arena, small));
+    g_assert_true(mem_arena_owns(arena, large));
+
+    /* heap memory is not owned by the arena */
+    heap = ALLOC(16);
+    g_assert_false(mem_arena_owns(arena, heap));
+    FREE(heap);
+
+    mem_arena_free(arena);
+}
+
+void
+test_mem_arena_current(void)
+{
+    long    n_allocations;
+    double *heap;
+    double *scratch;
+    double *grown;
+
+    Arena arena = mem_arena_new(1024);
+
+    heap = ALLOC(4 * sizeof(double));
+    g_assert_null(mem_arena_set_current(arena));
+    g_assert_true(mem_arena_current() == arena);
+
+    /* allocations are routed to the current arena */
+    n_allocations = mem_n_allocations();
+    scratch       = mem_calloc(4, sizeof(double), __FILE__, __LINE__);
+    g_assert_true(mem_arena_owns(arena, scratch));
+    g_assert_true(scratch[3] == 0);
+
+    scratch[0] = 1;
+    grown      = RESIZE(scratch, 8 * sizeof(double));
+    g_assert_true(grown[0] == 1);
+    g_assert_true(mem_arena_owns(arena, grown));
+
+    FREE(grown);
+    g_assert_true(mem_n_allocations() == n_allocations);
+
+    /* heap memory is still freed while an arena is current */
+    FREE(heap);
+
+    g_assert_true(mem_arena_set_current(NULL) == arena);
+    mem_arena_free(arena);
+}
+
+void
+test_mem_profile(void)
+{
+    int   line;
+    char  file[256];
+    char  report[4096];
+    char *a;
+    char *b;
+    char *c;
+
+    MemSiteStats stats;
+    MemSiteStats sites[4];
+    FILE *       stream;
+
+    mem_profile_reset();
+    mem_profile_enable(true);
+
+    /* two allocations at one call site and one at another */
+    for (int i = 0; i < 2; i++) {
+        line = __LINE__ + 1;
+        a    = mem_alloc(100, __FILE__, line);
+        FREE(a);
+    }
+    b = mem_alloc(10, __FILE__, line);
+    c = mem_alloc(1000, __FILE__, line + 100);
+
+    mem_profile_enable(false);
+
+    g_assert_true(mem_profile_site(__FILE__, line, &stats));
+    g_assert_true(stats.n_allocations == 3);
+    g_assert_true(stats.n_bytes == 210);
+    g_assert_true(stats.n_live == 1);
+    g_assert_true(stats.live_bytes == 10);
+    g_assert_true(stats.max_live_bytes == 100);
+
+    g_assert_true(mem_profile_sites(sites, 4) == 2);
+    g_assert_true(sites[0].line == line + 100);
+    g_assert_true(sites[1].line == line);
+
+    /* frees are tracked after recording stops */
+    FREE(b);
+    FREE(c);
+    mem_profile_totals(&stats);
+    g_assert_true(stats.n_allocations == 4);
+    g_assert_true(stats.n_live == 0);
+    g_assert_true(stats.max_live_bytes == 1010);
+
+    stream = tmpfile();
+    mem_profile_report(stream);
+    rewind(stream);
+    report[fread(report, 1, sizeof(report) - 1, stream)] = '\0';
+    fclose(stream);
+    g_assert_nonnull(strstr(report, "total"));
+
+    /* a copy of the file name is the same call site, and the high-water
+     * mark is that of the combined live bytes */
+    snprintf(file, sizeof(file), "%s", __FILE__);
+    mem_profile_reset();
+    mem_profile_enable(true);
+    a = mem_alloc(100, __FILE__, line);
+    FREE(a);
+    b = mem_alloc(60, file, line);
+    c = mem_alloc(60, __FILE__, line);
+    mem_profile_enable(false);
+    FREE(b);
+    FREE(c);
+
+    g_assert_true(mem_profile_site(file, line, &stats));
+    g_assert_true(stats.n_allocations == 3);
+    g_assert_true(stats.max_live_bytes == 120);
+    g_assert_true(mem_profile_sites(sites, 4) == 1);
+
+    mem_profile_reset();
+    g_assert_false(mem_profile_site(__FILE__, line, &stats));
+}
+
+void
+test_mem_profile_budget(void)
+{
+    double y[]       = { 1, 0, 0, 1 };
+    double z[]       = { 0, 0, 1, 1 };
+    double roughness = 0.03;
+
+    XSPValues    xsp;
+    MemSiteStats totals;
+
+    CoArray      ca = coarray_new(4, y, z);
+    CrossSection xs = xs_new(ca, 1, &roughness, NULL);
+    coarray_free(ca);
+
+    /* computing properties into a caller-owned struct does not allocate */
+    mem_profile_reset();
+    mem_profile_enable(true);
+    for (int i = 1; i <= 10; i++)
+        xs_hydraulic_properties_into(xs, 0.1 * i, &xsp);
+    mem_profile_enable(false);
+
+    mem_profile_totals(&totals);
+    g_assert_true(totals.n_allocations == 0);
+
+    mem_profile_reset();
+    xs_free(xs);
+}
+
+static void
+allocate_block(int begin, int end, void *data)
+{
+    (void) data;
+
+    double  y[] = { 1, 0, 0, 1 };
+    double  z[] = { 0, 0, 1, 1 };
+    CoArray ca;
+
+    for (int i = begin; i < end; i++) {
+        ca = coarray_new(4, y, z);
+        coarray_free(ca);
+    }
+}
+
+void
+test_mem_threads(void)
+{
+    int        n    = 4000;
+    ThreadPool pool = threadpool_new(4);
+    long       n_allocations;
+
+    /* each coordinate array is three allocations, none of them lost when
+     * threads allocate at the same time */
+    n_allocations = mem_n_allocations();
+    threadpool_run(pool, n, 10, allocate_block, NULL);
+    g_assert_true(mem_n_allocations() - n_allocations == 3 * n);
+
+    threadpool_free(pool);
+}
+
+int
+main(int argc, char *argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func("/panthera/mem/arena/alloc", test_mem_arena_alloc);
+    g_test_add_func("/panthera/mem/arena/current", test_mem_arena_current);
+    g_test_add_func("/panthera/mem/threads", test_mem_threads);
+    g_test_add_func("/panthera/mem/profile", test_mem_profile);
+    g_test_add_func("/panthera/mem/profile/budget", test_mem_profile_budget);
+    return g_test_run();
+}
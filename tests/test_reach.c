@@ -1,5 +1,7 @@
 #include "testlib.h"
 #include <glib.h>
+#include <math.h>
+#include <mem.h>
 #include <panthera/reach.h>
 
 CrossSection
@@ -44,6 +46,45 @@ test_reach_new(void)
     xs_free(xs);
 }
 
+void
+test_reach_put_xs_many(void)
+{
+    int    i;
+    double x[]          = { 3, 0, 4, 1, 3 };
+    double y[]          = { 0.3, 0, 0.4, 0.1, 0.35 };
+    double x_more[]     = { 2, 4, 5 };
+    double y_more[]     = { 0.2, 0.45, 0.5 };
+    double expected_x[] = { 0, 1, 2, 3, 4, 5 };
+    double expected_y[] = { 0, 0.1, 0.2, 0.35, 0.45, 0.5 };
+    double stream_distance[6];
+    double elevation[6];
+
+    CrossSection xs        = new_cross_section();
+    CrossSection xs_many[] = { xs, xs, xs, xs, xs };
+
+    Reach reach = reach_new();
+
+    /* the last of duplicate distances replaces the others */
+    reach_put_xs_many(reach, 5, x, y, xs_many);
+    g_assert_true(reach_size(reach) == 4);
+
+    /* new nodes are merged with existing nodes */
+    reach_put_xs(reach, x_more[0], y_more[0], xs);
+    reach_put_xs_many(reach, 2, x_more + 1, y_more + 1, xs_many);
+    g_assert_true(reach_size(reach) == 6);
+
+    reach_stream_distance(reach, stream_distance);
+    reach_elevation(reach, elevation);
+
+    for (i = 0; i < 6; i++) {
+        g_assert_true(stream_distance[i] == expected_x[i]);
+        g_assert_true(elevation[i] == expected_y[i]);
+    }
+
+    reach_free(reach);
+    xs_free(xs);
+}
+
 void
 test_reach_node_props(void)
 {
@@ -106,13 +147,531 @@ test_reach_stream_distance(void)
     xs_free(xs);
 }
 
+/* trapezoidal channel used by the steady flow solver tests */
+static Reach
+new_trapezoid_reach(int n_nodes, double length, double slope, CrossSection *xs)
+{
+    double y[]       = { 10, 0, 0, 10 };
+    double z[]       = { 0, 20, 30, 50 };
+    double roughness = 0.013;
+    double x;
+
+    CoArray ca = coarray_new(4, y, z);
+    *xs        = xs_new(ca, 1, &roughness, NULL);
+    coarray_free(ca);
+
+    Reach reach = reach_new();
+
+    for (int i = 0; i < n_nodes; i++) {
+        x = length * i / (n_nodes - 1);
+        reach_put_xs(reach, x, (length - x) * slope, *xs);
+    }
+
+    return reach;
+}
+
+void
+test_reach_freeze(void)
+{
+    int    i;
+    int    p;
+    int    n_nodes    = 11;
+    int    n_profiles = 8;
+    double x[11];
+    double y[11];
+    double q[8 * 11];
+    double wse_bc[8];
+    double wse[8 * 11];
+    double wse_one[11];
+
+    const double *x_data;
+    const double *y_data;
+
+    CrossSection xs;
+    CrossSection xs_reference;
+
+    Reach reach  = new_trapezoid_reach(n_nodes, 4e3, 0.001, &xs);
+    Reach frozen = reach_freeze(reach);
+
+    g_assert_true(!reach_is_frozen(reach));
+    g_assert_true(reach_is_frozen(frozen));
+    g_assert_true(reach_size(frozen) == n_nodes);
+
+    /* the snapshot is not affected by changes to the reach */
+    reach_put_xs(reach, -100, 10, xs);
+    reach_put_xs(reach, 0, 10, xs);
+    g_assert_true(reach_size(reach) == n_nodes + 1);
+    g_assert_true(reach_size(frozen) == n_nodes);
+
+    x_data = reach_stream_distance_data(frozen);
+    y_data = reach_elevation_data(frozen);
+    reach_stream_distance(frozen, x);
+    reach_elevation(frozen, y);
+    for (i = 0; i < n_nodes; i++) {
+        g_assert_true(x[i] == 4e3 * i / (n_nodes - 1));
+        g_assert_true(y[i] == (4e3 - x[i]) * 0.001);
+        g_assert_true(x_data[i] == x[i]);
+        g_assert_true(y_data[i] == y[i]);
+    }
+
+    /* profiles computed on several threads sharing the snapshot */
+    for (p = 0; p < n_profiles; p++) {
+        wse_bc[p] = 1 + 0.5 * p;
+        for (i = 0; i < n_nodes; i++)
+            q[p * n_nodes + i] = 10 + 5 * p;
+    }
+
+    reach_standard_step_many(frozen,
+                             n_profiles,
+                             q,
+                             wse_bc,
+                             REACH_DOWNSTREAM,
+                             wse,
+                             NULL,
+                             NULL,
+                             4);
+
+    reach_free(reach);
+    reach = new_trapezoid_reach(n_nodes, 4e3, 0.001, &xs_reference);
+
+    for (p = 0; p < n_profiles; p++) {
+        reach_standard_step(
+            reach, q + p * n_nodes, wse_bc[p], REACH_DOWNSTREAM, wse_one, NULL);
+        for (i = 0; i < n_nodes; i++)
+            g_assert_true(wse[p * n_nodes + i] == wse_one[i]);
+    }
+
+    reach_free(frozen);
+    reach_free(reach);
+    xs_free(xs_reference);
+    xs_free(xs);
+}
+
+void
+test_reach_energy_residuals(void)
+{
+    int    i;
+    int    n_nodes = 5;
+    double dy      = 1e-6;
+    double q[]     = { 30, 30, 30, 30, 30 };
+    double wse[5];
+    double residual[4];
+    double residual_only[4];
+    double residual_lo[4];
+    double residual_hi[4];
+    double dres_dwse_lo[4];
+    double dres_dwse_hi[4];
+    double fd; /* central difference derivative */
+    long   n_allocations;
+
+    CrossSection xs;
+
+    Reach reach = new_trapezoid_reach(n_nodes, 4e3, 0.001, &xs);
+
+    /* the residuals of the standard step profile are zero */
+    reach_standard_step(reach, q, 5, REACH_DOWNSTREAM, wse, NULL);
+    reach_energy_residuals(reach, wse, q, residual, NULL, NULL);
+    for (i = 0; i < n_nodes - 1; i++)
+        g_assert_true(fabs(residual[i]) < 1e-6);
+
+    for (i = 0; i < n_nodes; i++)
+        wse[i] += 0.1 * i;
+
+    n_allocations = mem_n_allocations();
+    reach_energy_residuals(
+        reach, wse, q, residual, dres_dwse_lo, dres_dwse_hi);
+    g_assert_true(mem_n_allocations() == n_allocations);
+
+    reach_energy_residuals(reach, wse, q, residual_only, NULL, NULL);
+
+    /* compare the Jacobian bands to central differences */
+    for (i = 0; i < n_nodes - 1; i++) {
+        g_assert_true(test_is_close(residual[i], residual_only[i], 0, 1e-12));
+
+        wse[i] += dy;
+        reach_energy_residuals(reach, wse, q, residual_hi, NULL, NULL);
+        wse[i] -= 2 * dy;
+        reach_energy_residuals(reach, wse, q, residual_lo, NULL, NULL);
+        wse[i] += dy;
+        fd = (residual_hi[i] - residual_lo[i]) / (2 * dy);
+        g_assert_true(test_is_close(dres_dwse_lo[i], fd, 1e-6, 1e-5));
+
+        wse[i + 1] += dy;
+        reach_energy_residuals(reach, wse, q, residual_hi, NULL, NULL);
+        wse[i + 1] -= 2 * dy;
+        reach_energy_residuals(reach, wse, q, residual_lo, NULL, NULL);
+        wse[i + 1] += dy;
+        fd = (residual_hi[i] - residual_lo[i]) / (2 * dy);
+        g_assert_true(test_is_close(dres_dwse_hi[i], fd, 1e-6, 1e-5));
+    }
+
+    reach_free(reach);
+    xs_free(xs);
+}
+
+void
+test_reach_rnp_many(void)
+{
+    int     i;
+    int     n_nodes = 2000;
+    double  q       = 30;
+    double *wse     = calloc(n_nodes, sizeof(double));
+    double *qs      = calloc(n_nodes, sizeof(double));
+    double *values  = calloc(12 * n_nodes, sizeof(double));
+    double  h_critical;
+    long    n_allocations;
+
+    RNPArrays      serial;
+    RNPArrays      threaded;
+    ReachNodeProps rnp;
+    CrossSection   xs;
+
+    Reach reach = new_trapezoid_reach(n_nodes, 4e4, 0.001, &xs);
+
+    serial   = (RNPArrays){ values,
+                          values + n_nodes,
+                          values + 2 * n_nodes,
+                          values + 3 * n_nodes,
+                          values + 4 * n_nodes,
+                          values + 5 * n_nodes };
+    threaded = (RNPArrays){ values + 6 * n_nodes,
+                            values + 7 * n_nodes,
+                            values + 8 * n_nodes,
+                            values + 9 * n_nodes,
+                            values + 10 * n_nodes,
+                            values + 11 * n_nodes };
+
+    /* the first node is at critical depth and the others are deeper */
+    h_critical = xs_critical_depth(xs, q, 1);
+    reach_elevation(reach, wse);
+    for (i = 0; i < n_nodes; i++) {
+        wse[i] += h_critical * (1 + (double) i / n_nodes);
+        qs[i] = q;
+    }
+
+    n_allocations = mem_n_allocations();
+    reach_rnp_many(reach, wse, qs, &serial, 1);
+    g_assert_true(mem_n_allocations() == n_allocations);
+
+    reach_rnp_many(reach, wse, qs, &threaded, 4);
+
+    g_assert_true(test_is_close(serial.froude[0], 1, 0, 1e-6));
+
+    for (i = 0; i < n_nodes; i++) {
+        rnp = reach_rnp(reach, i, wse[i], q);
+        g_assert_true(serial.velocity[i] == rnp_get(rnp, RN_VELOCITY));
+        g_assert_true(serial.friction_slope[i] ==
+                      rnp_get(rnp, RN_FRICTION_SLOPE));
+        g_assert_true(test_is_close(serial.velocity_head[i],
+                                    rnp_get(rnp, RN_VELOCITY_HEAD),
+                                    0,
+                                    1e-12));
+        g_assert_true(test_is_close(
+            serial.velocity[i], q / serial.area[i], 0, 1e-12));
+        g_assert_true(serial.top_width[i] > 0);
+        g_assert_true(i == 0 || serial.froude[i] < 1);
+        rnp_free(rnp);
+    }
+
+    /* the results do not depend on the number of threads */
+    for (i = 0; i < 6 * n_nodes; i++)
+        g_assert_true(values[i] == values[6 * n_nodes + i]);
+
+    free(wse);
+    free(qs);
+    free(values);
+    reach_free(reach);
+    xs_free(xs);
+}
+
+void
+test_reach_standard_step(void)
+{
+    int    i;
+    int    n_nodes    = 5;
+    double q[]        = { 30, 30, 30, 30, 30 };
+    double expected[] = { 1.263, 2.038, 3.007, 4.002, 5 };
+    double thalweg[5];
+    double wse[5];
+    int    n_solved;
+
+    CrossSection xs;
+    XSSolveInfo  info[5];
+
+    Reach reach = new_trapezoid_reach(n_nodes, 4e3, 0.001, &xs);
+    reach_elevation(reach, thalweg);
+
+    n_solved = reach_standard_step(reach, q, 5, REACH_DOWNSTREAM, wse, info);
+    g_assert_true(n_solved == n_nodes);
+
+    for (i = 0; i < n_nodes; i++) {
+        g_assert_true(info[i].converged);
+        g_assert_true(fabs(wse[i] - thalweg[i] - expected[i]) < 1e-3);
+    }
+
+    reach_free(reach);
+    xs_free(xs);
+}
+
+void
+test_reach_standard_step_supercritical(void)
+{
+    int    i;
+    int    n_nodes = 11;
+    double q[11];
+    double thalweg[11];
+    double wse[11];
+    double depth;
+    double critical_depth;
+    double normal_depth;
+    double slope = 0.05;
+    int    n_solved;
+
+    CrossSection xs;
+    XSSolveInfo  info[11];
+
+    Reach reach = new_trapezoid_reach(n_nodes, 1e3, slope, &xs);
+    reach_elevation(reach, thalweg);
+
+    for (i = 0; i < n_nodes; i++)
+        q[i] = 30;
+
+    critical_depth = xs_critical_depth(xs, 30, 1);
+    normal_depth   = xs_normal_depth(xs, 30, slope, 1);
+    g_assert_true(normal_depth < critical_depth);
+
+    /* the profile approaches normal depth from critical depth */
+    n_solved = reach_standard_step(
+        reach, q, thalweg[0] + critical_depth, REACH_UPSTREAM, wse, info);
+    g_assert_true(n_solved == n_nodes);
+
+    for (i = 1; i < n_nodes; i++) {
+        depth = wse[i] - thalweg[i];
+        g_assert_true(info[i].converged);
+        g_assert_true(fabs(info[i].residual) < 1e-8);
+        g_assert_true(depth < critical_depth);
+    }
+    g_assert_true(test_is_close(depth, normal_depth, 0, 1e-3));
+
+    reach_free(reach);
+    xs_free(xs);
+}
+
+void
+test_reach_standard_step_many(void)
+{
+    int    i;
+    int    p;
+    int    n_nodes    = 20;
+    int    n_profiles = 16;
+    double q[16 * 20];
+    double wse_bc[16];
+    double wse[16 * 20];
+    double wse_serial[16 * 20];
+    double wse_one[20];
+    int    n_solved[16];
+    int    n_solved_serial[16];
+    int    n_solved_one;
+    long   n_allocations;
+
+    CrossSection xs;
+    XSSolveInfo  info[16 * 20];
+
+    Reach reach = new_trapezoid_reach(n_nodes, 4e3, 0.001, &xs);
+
+    for (p = 0; p < n_profiles; p++) {
+        wse_bc[p] = 1 + 0.5 * p;
+        for (i = 0; i < n_nodes; i++)
+            q[p * n_nodes + i] = 10 + 5 * p;
+    }
+
+    n_allocations = mem_n_allocations();
+    reach_standard_step_many(reach,
+                             n_profiles,
+                             q,
+                             wse_bc,
+                             REACH_DOWNSTREAM,
+                             wse_serial,
+                             NULL,
+                             n_solved_serial,
+                             1);
+    g_assert_true(mem_n_allocations() == n_allocations);
+
+    reach_standard_step_many(reach,
+                             n_profiles,
+                             q,
+                             wse_bc,
+                             REACH_DOWNSTREAM,
+                             wse,
+                             info,
+                             n_solved,
+                             4);
+
+    for (p = 0; p < n_profiles; p++) {
+        n_solved_one = reach_standard_step(
+            reach, q + p * n_nodes, wse_bc[p], REACH_DOWNSTREAM, wse_one, NULL);
+        g_assert_true(n_solved[p] == n_solved_one);
+        g_assert_true(n_solved[p] == n_nodes);
+        g_assert_true(n_solved_serial[p] == n_nodes);
+        for (i = 0; i < n_nodes; i++) {
+            g_assert_true(info[p * n_nodes + i].converged);
+            g_assert_true(wse[p * n_nodes + i] == wse_one[i]);
+            g_assert_true(wse_serial[p * n_nodes + i] == wse_one[i]);
+        }
+    }
+
+    reach_free(reach);
+    xs_free(xs);
+}
+
+void
+test_reach_simultaneous(void)
+{
+    int    i;
+    int    n_nodes    = 5;
+    double q[]        = { 30, 30, 30, 30, 30 };
+    double expected[] = { 1.263, 2.038, 3.007, 4.002, 5 };
+    double thalweg[5];
+    double wse[5];
+    double wse_sstep[5];
+    long   n_allocations;
+
+    CrossSection xs;
+    XSSolveInfo  info;
+
+    Reach reach = new_trapezoid_reach(n_nodes, 4e3, 0.001, &xs);
+    reach_elevation(reach, thalweg);
+    reach_standard_step(reach, q, 5, REACH_DOWNSTREAM, wse_sstep, NULL);
+
+    n_allocations = mem_n_allocations();
+    g_assert_true(reach_simultaneous(reach, q, 5, wse, &info));
+    g_assert_true(mem_n_allocations() == n_allocations);
+
+    g_assert_true(info.converged);
+    g_assert_true(info.n_iterations > 1);
+    g_assert_true(info.n_evaluations == n_nodes * info.n_iterations);
+    g_assert_true(info.residual < 1e-8);
+
+    /* both methods solve the same energy equations */
+    for (i = 0; i < n_nodes; i++) {
+        g_assert_true(fabs(wse[i] - thalweg[i] - expected[i]) < 1e-3);
+        g_assert_true(fabs(wse[i] - wse_sstep[i]) < 1e-6);
+    }
+
+    reach_free(reach);
+    xs_free(xs);
+}
+
+void
+test_reach_simultaneous_long(void)
+{
+    int     i;
+    int     n_nodes  = 2000;
+    double *q        = calloc(n_nodes, sizeof(double));
+    double *wse      = calloc(n_nodes, sizeof(double));
+    double *wse_step = calloc(n_nodes, sizeof(double));
+
+    CrossSection xs;
+    XSSolveInfo  info;
+
+    /* the profile upstream is far from the initial estimate */
+    Reach reach = new_trapezoid_reach(n_nodes, 4e4, 0.001, &xs);
+
+    for (i = 0; i < n_nodes; i++)
+        q[i] = 30;
+
+    g_assert_true(reach_simultaneous(reach, q, 5, wse, &info));
+    reach_standard_step(reach, q, 5, REACH_DOWNSTREAM, wse_step, NULL);
+
+    for (i = 0; i < n_nodes; i++)
+        g_assert_true(fabs(wse[i] - wse_step[i]) < 1e-6);
+
+    free(q);
+    free(wse);
+    free(wse_step);
+    reach_free(reach);
+    xs_free(xs);
+}
+
+void
+test_reach_boundary_value(void)
+{
+    int    i;
+    int    n_nodes = 50;
+    double q       = 10;
+    double q_sstep[50];
+    double wse[50];
+    double wse_sstep[50];
+    long   n_allocations;
+
+    CrossSection xs;
+    XSSolveInfo  info;
+
+    Reach reach = new_trapezoid_reach(n_nodes, 1e3, 0.001, &xs);
+
+    for (i = 0; i < n_nodes; i++)
+        q_sstep[i] = 30;
+    reach_standard_step(reach, q_sstep, 5, REACH_DOWNSTREAM, wse_sstep, NULL);
+
+    /* the initial estimate is linear between the stages at the ends of the
+     * standard step profile */
+    for (i = 0; i < n_nodes; i++)
+        wse[i] = wse_sstep[0] +
+                 (wse_sstep[n_nodes - 1] - wse_sstep[0]) * i / (n_nodes - 1);
+
+    n_allocations = mem_n_allocations();
+    g_assert_true(reach_boundary_value(reach, wse, &q, &info));
+    g_assert_true(mem_n_allocations() == n_allocations + 1);
+
+    g_assert_true(info.converged);
+    g_assert_true(info.residual < 1e-8);
+    g_assert_true(test_is_close(q, 30, 0, 1e-6));
+
+    for (i = 0; i < n_nodes; i++)
+        g_assert_true(fabs(wse[i] - wse_sstep[i]) < 1e-6);
+
+    reach_free(reach);
+    xs_free(xs);
+
+    /* with two nodes both stages are known and only discharge is solved */
+    reach = new_trapezoid_reach(2, 1e2, 0.001, &xs);
+    reach_standard_step(reach, q_sstep, 5, REACH_DOWNSTREAM, wse_sstep, NULL);
+
+    wse[0] = wse_sstep[0];
+    wse[1] = wse_sstep[1];
+    q      = 10;
+    g_assert_true(reach_boundary_value(reach, wse, &q, &info));
+    g_assert_true(info.residual < 1e-8);
+    g_assert_true(test_is_close(q, 30, 0, 1e-6));
+    g_assert_true(wse[0] == wse_sstep[0] && wse[1] == wse_sstep[1]);
+
+    reach_free(reach);
+    xs_free(xs);
+}
+
 int
 main(int argc, char *argv[])
 {
     g_test_init(&argc, &argv, NULL);
     g_test_add_func("/panthera/reach/new", test_reach_new);
+    g_test_add_func("/panthera/reach/put many", test_reach_put_xs_many);
     g_test_add_func("/panthera/reach/node properties", test_reach_node_props);
     g_test_add_func("/panthera/reach/stream distance",
                     test_reach_stream_distance);
+    g_test_add_func("/panthera/reach/freeze", test_reach_freeze);
+    g_test_add_func("/panthera/reach/energy residuals",
+                    test_reach_energy_residuals);
+    g_test_add_func("/panthera/reach/node properties/many",
+                    test_reach_rnp_many);
+    g_test_add_func("/panthera/reach/standard step", test_reach_standard_step);
+    g_test_add_func("/panthera/reach/standard step/supercritical",
+                    test_reach_standard_step_supercritical);
+    g_test_add_func("/panthera/reach/standard step/many",
+                    test_reach_standard_step_many);
+    g_test_add_func("/panthera/reach/simultaneous", test_reach_simultaneous);
+    g_test_add_func("/panthera/reach/simultaneous/long reach",
+                    test_reach_simultaneous_long);
+    g_test_add_func("/panthera/reach/boundary value",
+                    test_reach_boundary_value);
     return g_test_run();
 }
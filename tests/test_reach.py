@@ -2,6 +2,7 @@ from unittest import TestCase
 
 import numpy as np
 
+from pantherapy.panthera import CrossSection
 from pantherapy.reach import Reach
 
 
@@ -81,3 +82,58 @@ class TestReach(TestCase):
             self.assertTrue(reach.friction_slope(i, y, 1) == 1)
             self.assertAlmostEqual(
                 expected_velocity_head, reach.velocity_head(i, y, 1))
+
+    def test_energy_residuals(self):
+        """Test energy residuals against energy_diff"""
+
+        S = 0.001
+
+        xs = CrossSection([10, 0, 0, 10], [0, 20, 30, 50], 0.013)
+
+        x_reach = np.linspace(0, 1e3, num=11)
+        y_reach = S*x_reach[::-1]
+
+        reach = Reach()
+
+        for x, y in zip(x_reach, y_reach):
+            reach.put(xs, x, y)
+
+        wse = y_reach + np.linspace(1, 3, num=11)
+        q = 30
+
+        residual, dres_dwse_lo, dres_dwse_hi = reach.energy_residuals(wse, q)
+
+        self.assertEqual(len(residual), len(x_reach) - 1)
+
+        for i in range(len(residual)):
+            self.assertAlmostEqual(
+                residual[i],
+                reach.energy_diff(wse[i + 1], q, i + 1, wse[i], q, i))
+
+    def test_node_properties(self):
+        """Test node properties against the node value methods"""
+
+        S = 0.001
+
+        xs = CrossSection([10, 0, 0, 10], [0, 20, 30, 50], 0.013)
+
+        x_reach = np.linspace(0, 1e3, num=11)
+        y_reach = S*x_reach[::-1]
+
+        reach = Reach()
+
+        for x, y in zip(x_reach, y_reach):
+            reach.put(xs, x, y)
+
+        wse = y_reach + np.linspace(1, 3, num=11)
+        q = 30
+
+        props = reach.node_properties(wse, q, n_threads=2)
+
+        for i in range(len(x_reach)):
+            self.assertAlmostEqual(
+                props['velocity_head'][i],
+                reach.velocity_head(i, wse[i], q))
+            self.assertAlmostEqual(
+                props['friction_slope'][i],
+                reach.friction_slope(i, wse[i], q))
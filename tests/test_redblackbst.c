@@ -0,0 +1,108 @@
+#include "mem.h"
+#include "redblackbst.h"
+#include <glib.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+static int
+compare_int(const void *x, const void *y)
+{
+    int x_key = *(const int *) x;
+    int y_key = *(const int *) y;
+
+    return (x_key > y_key) - (x_key < y_key);
+}
+
+void
+test_redblackbst_get_value(void)
+{
+    int  i;
+    int  n = 100;
+    int  keys[100];
+    int  values[100];
+    int  missing = n;
+    long n_allocations;
+
+    RedBlackBST tree = redblackbst_new(compare_int);
+
+    for (i = 0; i < n; i++) {
+        keys[i]   = (i * 37) % n;
+        values[i] = 2 * keys[i];
+        redblackbst_put(tree, keys + i, values + i);
+    }
+
+    n_allocations = mem_n_allocations();
+    for (i = 0; i < n; i++)
+        g_assert_true(*(int *) redblackbst_get_value(tree, keys + i) ==
+                      2 * keys[i]);
+    g_assert_null(redblackbst_get_value(tree, &missing));
+    g_assert_true(mem_n_allocations() == n_allocations);
+
+    /* putting an existing key replaces the value */
+    redblackbst_put(tree, keys, &missing);
+    g_assert_true(redblackbst_size(tree) == n);
+    g_assert_true(redblackbst_get_value(tree, keys) == &missing);
+
+    redblackbst_free(tree);
+}
+
+void
+test_redblackbst_cursor(void)
+{
+    int         i;
+    int         n = 1000;
+    int *       keys;
+    int         lo = 250;
+    int         hi = 500;
+    int         expected;
+    const void *key;
+    void *      value;
+    long        n_allocations;
+
+    RedBlackBSTCursor cursor;
+
+    RedBlackBST tree = redblackbst_new(compare_int);
+    keys             = calloc(n, sizeof(int));
+
+    for (i = 0; i < n; i++) {
+        keys[i] = (i * 7919) % n;
+        redblackbst_put(tree, keys + i, keys + i);
+    }
+
+    /* deleted nodes are reused from the pool */
+    for (i = 0; i < n; i += 2)
+        redblackbst_delete(tree, keys + i);
+    n_allocations = mem_n_allocations();
+    for (i = 0; i < n; i += 2)
+        redblackbst_put(tree, keys + i, keys + i);
+    g_assert_true(mem_n_allocations() == n_allocations);
+
+    expected = 0;
+    redblackbst_cursor_init(tree, &cursor, NULL, NULL);
+    while (redblackbst_cursor_next(&cursor, &key, &value)) {
+        g_assert_true(*(const int *) key == expected);
+        g_assert_true(value == key);
+        expected++;
+    }
+    g_assert_true(expected == n);
+    g_assert_true(mem_n_allocations() == n_allocations);
+
+    expected = lo;
+    redblackbst_cursor_init(tree, &cursor, &lo, &hi);
+    while (redblackbst_cursor_next(&cursor, &key, NULL))
+        g_assert_true(*(const int *) key == expected++);
+    g_assert_true(expected == hi + 1);
+
+    free(keys);
+    redblackbst_free(tree);
+}
+
+int
+main(int argc, char *argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func("/panthera/redblackbst/get value",
+                    test_redblackbst_get_value);
+    g_test_add_func("/panthera/redblackbst/cursor", test_redblackbst_cursor);
+    return g_test_run();
+}
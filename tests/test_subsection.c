@@ -1,5 +1,6 @@
 #include "testlib.h"
 #include <glib.h>
+#include <mem.h>
 #include <subsection.h>
 
 #define ABS_TOL 1e-13
@@ -258,6 +259,198 @@ test_simple_h_properties(ss_fixture *ssf, gconstpointer test_data)
     }
 }
 
+void
+test_ss_geometry_allocations(void)
+{
+    int    n         = 6;
+    double z[]       = { 0, 0.25, 0.5, 1.5, 1.75, 2 };
+    double y[]       = { 1, 0.5, 0, 0, 0.5, 1 };
+    double roughness = 0.030;
+
+    double area;
+    double perimeter;
+    double top_width;
+    long   n_allocations;
+
+    CoArray    ca = coarray_new(n, y, z);
+    Subsection ss = subsection_new(ca, roughness, -INFINITY);
+    coarray_free(ca);
+
+    n_allocations = mem_n_allocations();
+    for (int i = 0; i < 100; i++)
+        subsection_geometry(
+            ss, (double) i / 50, &area, &perimeter, &top_width);
+    g_assert_true(mem_n_allocations() == n_allocations);
+
+    subsection_free(ss);
+}
+
+/* clips each segment of a subsection at y and integrates the wetted area,
+ * perimeter, and top width */
+static void
+clip_geometry(int     n,
+              double *y,
+              double *z,
+              double  h,
+              double *area,
+              double *perimeter,
+              double *top_width)
+{
+    double y1, z1, y2, z2;
+
+    *area      = 0;
+    *perimeter = 0;
+    *top_width = 0;
+
+    for (int i = 1; i < n; i++) {
+        y1 = y[i - 1];
+        z1 = z[i - 1];
+        y2 = y[i];
+        z2 = z[i];
+        if (y1 < h && h < y2) {
+            z2 = (z2 - z1) / (y2 - y1) * (h - y1) + z1;
+            y2 = h;
+        } else if (y2 < h && h < y1) {
+            z1 = (z2 - z1) / (y2 - y1) * (h - y1) + z1;
+            y1 = h;
+        } else if (y1 > h || y2 > h) {
+            continue;
+        }
+        *area += 0.5 * ((h - y1) + (h - y2)) * (z2 - z1);
+        *perimeter += sqrt((y2 - y1) * (y2 - y1) + (z2 - z1) * (z2 - z1));
+        *top_width += z2 - z1;
+    }
+}
+
+void
+test_ss_geometry_pieces(void)
+{
+    /* irregular subsection with horizontal and vertical segments and
+     * repeated elevations */
+    int    n         = 11;
+    double z[]       = { 0, 0, 1, 2, 2.5, 3, 3, 4, 5, 6, 7 };
+    double y[]       = { 3, 2, 1, 1, 0, 1, 0.5, 0.5, 2, 1, 3 };
+    double roughness = 0.030;
+
+    double h;
+    double area;
+    double perimeter;
+    double top_width;
+    double d_perimeter;
+    double d_top_width;
+    double clip_area;
+    double clip_perimeter;
+    double clip_top_width;
+
+    CoArray    ca = coarray_new(n, y, z);
+    Subsection ss = subsection_new(ca, roughness, -INFINITY);
+    coarray_free(ca);
+
+    /* depths at and between every coordinate elevation and above the top */
+    for (int i = -2; i <= 90; i++) {
+        h = (double) i / 20;
+        subsection_geometry(ss, h, &area, &perimeter, &top_width);
+        clip_geometry(
+            n, y, z, h, &clip_area, &clip_perimeter, &clip_top_width);
+        g_assert_true(test_is_close(area, clip_area, ABS_TOL, 1e-13));
+        g_assert_true(
+            test_is_close(perimeter, clip_perimeter, ABS_TOL, 1e-13));
+        g_assert_true(
+            test_is_close(top_width, clip_top_width, ABS_TOL, 1e-13));
+    }
+
+    /* the top width slope between the lowest elevations is 1 / 2 + 1 / 2 */
+    subsection_geometry_deriv(
+        ss, 0.25, &area, &perimeter, &top_width, &d_perimeter, &d_top_width);
+    g_assert_true(test_is_close(d_top_width, 1, ABS_TOL, REL_TOL));
+
+    /* slopes are zero above the top */
+    subsection_geometry_deriv(
+        ss, 4, &area, &perimeter, &top_width, &d_perimeter, &d_top_width);
+    g_assert_true(d_top_width == 0 && d_perimeter == 0);
+
+    subsection_free(ss);
+}
+
+void
+test_ss_geometry_nan(void)
+{
+    /* a NAN elevation gives NAN properties instead of corrupting the pieces
+     * built from the sorted elevations */
+    int    n         = 5;
+    double z[]       = { 0, 0, 0.5, 1, 1 };
+    double y[]       = { 1, 0, NAN, 0, 1 };
+    double roughness = 0.030;
+
+    double area;
+    double perimeter;
+    double top_width;
+    double d_perimeter;
+    double d_top_width;
+
+    CoArray    ca = coarray_new(n, y, z);
+    Subsection ss = subsection_new(ca, roughness, -INFINITY);
+    coarray_free(ca);
+
+    subsection_geometry(ss, 0.5, &area, &perimeter, &top_width);
+    g_assert_true(isnan(area) && isnan(perimeter) && isnan(top_width));
+
+    subsection_geometry_deriv(
+        ss, 2, &area, &perimeter, &top_width, &d_perimeter, &d_top_width);
+    g_assert_true(isnan(area) && isnan(d_perimeter) && isnan(d_top_width));
+
+    subsection_free(ss);
+}
+
+void
+test_ss_batch_pieces(void)
+{
+    int    n         = 200;
+    double roughness = 0.030;
+    double y[200];
+    double z[200];
+    double depths[300];
+    double area[300];
+    double perimeter[300];
+    double top_width[300];
+    double conveyance[300];
+    double expected_area;
+    double expected_perimeter;
+    double expected_top_width;
+
+    for (int i = 0; i < n; i++) {
+        z[i] = i;
+        y[i] = fabs(sin(0.37 * i)) + (i == 0 || i == n - 1 ? 2 : 0);
+    }
+    for (int i = 0; i < 300; i++)
+        depths[i] = (double) i / 100;
+
+    CoArray    ca = coarray_new(n, y, z);
+    Subsection ss = subsection_new(ca, roughness, -INFINITY);
+    coarray_free(ca);
+
+    /* large subsections are evaluated in batches from their pieces */
+    subsection_properties_batch(
+        ss, 300, depths, area, perimeter, top_width, conveyance);
+
+    for (int i = 0; i < 300; i++) {
+        if (subsection_activated(ss, depths[i])) {
+            g_assert_true(area[i] == 0);
+            continue;
+        }
+        subsection_geometry(ss,
+                            depths[i],
+                            &expected_area,
+                            &expected_perimeter,
+                            &expected_top_width);
+        g_assert_true(area[i] == expected_area);
+        g_assert_true(perimeter[i] == expected_perimeter);
+        g_assert_true(top_width[i] == expected_top_width);
+    }
+
+    subsection_free(ss);
+}
+
 void
 add_ss_new_test(void)
 {
@@ -353,6 +546,14 @@ main(int argc, char *argv[])
     add_ss_triangle_test();
     add_ss_trapezoid_test();
     add_ss_double_triangle_test();
+    g_test_add_func("/pollywog/subsection/geometry/allocations",
+                    test_ss_geometry_allocations);
+    g_test_add_func("/pollywog/subsection/geometry/pieces",
+                    test_ss_geometry_pieces);
+    g_test_add_func("/pollywog/subsection/geometry/nan",
+                    test_ss_geometry_nan);
+    g_test_add_func("/pollywog/subsection/batch/pieces",
+                    test_ss_batch_pieces);
 
     return g_test_run();
 }
@@ -0,0 +1,72 @@
+#include "mem.h"
+#include "threadpool.h"
+#include <glib.h>
+#include <stdlib.h>
+
+/* counts the number of times each index is evaluated */
+static void
+count_block(int begin, int end, void *data)
+{
+    int  i;
+    int *counts = data;
+
+    for (i = begin; i < end; i++)
+        counts[i]++;
+}
+
+void
+test_threadpool_run(void)
+{
+    int  i;
+    int  j;
+    int  n             = 10007;
+    int  block_sizes[] = { 1, 7, 256, 20000 };
+    int *counts        = calloc(n, sizeof(int));
+
+    ThreadPool pool = threadpool_new(4);
+    g_assert_true(threadpool_n_threads(pool) >= 1);
+    g_assert_true(threadpool_n_threads(pool) <= 4);
+
+    /* every index is evaluated once by each run of the pool */
+    for (j = 0; j < 4; j++)
+        threadpool_run(pool, n, block_sizes[j], count_block, counts);
+    threadpool_run(pool, 0, 1, count_block, counts);
+
+    for (i = 0; i < n; i++)
+        g_assert_true(counts[i] == 4);
+
+    threadpool_free(pool);
+    free(counts);
+}
+
+void
+test_threadpool_parallel_for(void)
+{
+    int  i;
+    int  n      = 1000;
+    int *counts = calloc(n, sizeof(int));
+    long n_allocations;
+
+    n_allocations = mem_n_allocations();
+    threadpool_parallel_for(1, n, 10, count_block, counts);
+    threadpool_parallel_for(8, n, n, count_block, counts);
+    g_assert_true(mem_n_allocations() == n_allocations);
+
+    threadpool_parallel_for(8, n, 10, count_block, counts);
+    threadpool_parallel_for(8, 0, 10, count_block, counts);
+
+    for (i = 0; i < n; i++)
+        g_assert_true(counts[i] == 3);
+
+    free(counts);
+}
+
+int
+main(int argc, char *argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func("/panthera/threadpool/run", test_threadpool_run);
+    g_test_add_func("/panthera/threadpool/parallel for",
+                    test_threadpool_parallel_for);
+    return g_test_run();
+}